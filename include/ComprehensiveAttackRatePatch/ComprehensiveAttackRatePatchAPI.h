@@ -0,0 +1,187 @@
+#pragma once
+
+namespace AttackRatePatchAPI
+{
+	enum Version
+	{
+		Version1,
+		Version2,
+
+
+		Current = Version2
+	};
+
+
+	//Which hands a query wants. When both are asked for, right is always written before left.
+	enum HandMask : int32_t
+	{
+		kRightHand = 1 << 0,
+		kLeftHand = 1 << 1,
+		kBothHands = kRightHand | kLeftHand,
+	};
+
+
+	//The curve settings as they are at the time of the request.
+	struct SettingsSnapshot
+	{
+		float minSpeed;				//fMinWeaponSpeed
+		float capSpeed;				//fHighWeaponSpeedCap
+		float speedTaper;			//fWeaponSpeedTaper
+		float maxSpeed;				//fMaxWeaponSpeed
+		float magnitudeComparison;	//fMagnitudeComparison
+	};
+
+
+	//One hand of one actor changing speed.
+	struct SpeedChange
+	{
+		RE::Actor* actor;
+		bool right;
+		float oldSpeed;
+		float newSpeed;
+	};
+
+	//Gets every change since the last call, once a frame on the main thread. The records are only valid during the call.
+	using SpeedChangeCallback = void(*)(const SpeedChange* changes, uint64_t count, void* user);
+
+
+	struct InterfaceVersion1
+	{
+		inline static constexpr auto VERSION = Version::Version1;
+
+		virtual ~InterfaceVersion1() = default;
+
+		/// <summary>
+		/// Gets the current version of the interface.
+		/// </summary>
+		/// <returns></returns>
+		virtual Version GetVersion() = 0;
+
+
+		/// <summary>
+		/// The speed the target actually swings at, the same value CASP_PapyrusAPI.GetEffectiveWeaponSpeed returns.
+		/// </summary>
+		virtual float GetEffectiveSpeed(RE::Actor* target, bool right) = 0;
+
+		/// <summary>
+		/// Effective speeds for a list of actors. out needs room for count entries per hand in hand_mask. Null actors get 0.
+		/// </summary>
+		virtual void GetEffectiveSpeeds(RE::Actor* const* targets, uint64_t count, int32_t hand_mask, float* out) = 0;
+
+		/// <summary>
+		/// The amount CARP is currently taking off of the weapon speed actor value to undo recovering effects.
+		/// </summary>
+		virtual float GetSpeedTag(RE::Actor* target, bool right) = 0;
+
+		virtual void GetSettings(SettingsSnapshot& out) = 0;
+	};
+
+
+	struct InterfaceVersion2 : public InterfaceVersion1
+	{
+		inline static constexpr auto VERSION = Version::Version2;
+
+		/// <summary>
+		/// Calls back with a batch of effective speed changes at the end of any frame that had some. oldSpeed is what the
+		/// speed was before the first change that frame. Callbacks run without CARP holding any lock, so adding or removing
+		/// listeners (this one included) from inside one is fine. A listener removed mid frame isn't called again.
+		/// </summary>
+		/// <returns>False if the same callback and user are already registered.</returns>
+		virtual bool AddSpeedChangeListener(SpeedChangeCallback callback, void* user) = 0;
+
+		virtual bool RemoveSpeedChangeListener(SpeedChangeCallback callback, void* user) = 0;
+	};
+
+	using CurrentInterface = InterfaceVersion2;
+
+	inline CurrentInterface* Interface = nullptr;
+
+
+
+#ifdef CARP_SOURCE
+
+
+	CurrentInterface* InterfaceSingleton();
+
+	namespace detail
+	{
+		extern "C" __declspec(dllexport) void* CARP_RequestInterfaceImpl(Version version)
+		{
+			CurrentInterface* result = InterfaceSingleton();
+
+			switch (version)
+			{
+			case Version::Version1:
+				return dynamic_cast<InterfaceVersion1*>(result);
+			case Version::Version2:
+				return dynamic_cast<InterfaceVersion2*>(result);
+			default:
+				return nullptr;
+			}
+
+			return nullptr;
+		}
+	}
+
+#endif
+
+
+	/// <summary>
+	/// Accesses the CARP Interface, safe to call PostLoad
+	/// </summary>
+	/// <param name="version"> to request.</param>
+	/// <returns>Returns void* of the interface, cast to the respective version.</returns>
+	inline void* RequestInterface(Version version)
+	{
+		typedef void* (__stdcall* RequestFunction)(Version);
+
+		static RequestFunction request_interface = nullptr;
+
+		HINSTANCE API = GetModuleHandle(L"ComprehensiveAttackRatePatch.dll");
+
+		if (static bool once = false; !once && API == nullptr) {
+			once = true;
+			logger::warn("ComprehensiveAttackRatePatch.dll not found, API will remain non functional.");
+			return nullptr;
+		}
+
+		request_interface = (RequestFunction)GetProcAddress(API, "CARP_RequestInterfaceImpl");
+
+		if (request_interface) {
+			if (static unsigned int once = 0; once++ == 0)
+				logger::info("Successful module and request, CARP");
+
+		}
+		else {
+			if (static unsigned int once = 0; once++ == 0)
+				logger::critical("Unsuccessful module and request, CARP");
+
+			return nullptr;
+		}
+
+		auto intfc = (CurrentInterface*)request_interface(version);
+
+		return intfc;
+	}
+
+	/// <summary>
+	/// Accesses the CARP Interface, safe to call PostLoad
+	/// </summary>
+	/// <typeparam name="InterfaceClass">is the class derived from the interface to use.</typeparam>
+	/// <returns>Casts to and returns a specific version of the interface.</returns>
+	template <class InterfaceClass = CurrentInterface>
+	inline InterfaceClass* RequestInterface()
+	{
+		static InterfaceClass* intfc = nullptr;
+
+		if (!intfc) {
+			intfc = reinterpret_cast<InterfaceClass*>(RequestInterface(InterfaceClass::VERSION));
+
+			if constexpr (std::is_same_v<InterfaceClass, CurrentInterface>)
+				Interface = intfc;
+		}
+
+		return intfc;
+	}
+
+}
@@ -0,0 +1,208 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <type_traits>
+
+//Small fixed size form id -> value cache that any thread can read and write without taking a lock, for things the speed
+// queries look up per actor. Each slot is a seqlock: a writer claims it by making its sequence odd, copies the value in a
+// word at a time, then makes it even again. A reader copies the words out between two reads of the sequence and throws the
+// copy away if the sequence moved.
+//
+// A key lives in one of a few slots after its hash. Since it's only ever a cache, anything that can't be done right away
+// (a slot another writer holds, a full window) just doesn't happen and the caller works the value out again. Removing
+// waits its turn instead, something dropped has to stay dropped. Doesn't know anything about the game, keys are runtime
+// form ids and 0 is an empty slot.
+
+template <class T, size_t N>
+class ActorSlots
+{
+    static_assert(std::has_single_bit(N), "ActorSlots capacity must be a power of 2.");
+    static_assert(std::is_trivially_copyable_v<T> && sizeof(T) % sizeof(uint32_t) == 0, "ActorSlots values are copied a word at a time.");
+
+    static constexpr size_t k_words = sizeof(T) / sizeof(uint32_t);
+    static constexpr size_t k_window = 8;
+
+public:
+    std::optional<T> find(uint32_t key) const
+    {
+        if (!key)
+            return std::nullopt;
+
+        for (size_t i = 0; i < k_window; i++)
+        {
+            auto& slot = _slots[(Mix(key) + i) & (N - 1)];
+
+            uint32_t sequence = slot.sequence.load(std::memory_order_acquire);
+
+            if (sequence & 1 || slot.key.load(std::memory_order_relaxed) != key)
+                continue;
+
+            T value = Load(slot);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if (slot.sequence.load(std::memory_order_relaxed) != sequence)
+                return std::nullopt;
+
+            return value;
+        }
+
+        return std::nullopt;
+    }
+
+    //Takes the key's own slot, an empty one, or failing both the first in its window. False if a writer had it.
+    bool set(uint32_t key, const T& value)
+    {
+        if (!key)
+            return false;
+
+        Slot* target = nullptr;
+
+        for (uint32_t want : { key, 0u })
+        {
+            for (size_t i = 0; i < k_window && !target; i++)
+            {
+                auto& slot = _slots[(Mix(key) + i) & (N - 1)];
+
+                if (slot.key.load(std::memory_order_relaxed) == want)
+                    target = &slot;
+            }
+        }
+
+        if (!target)
+            target = &_slots[Mix(key) & (N - 1)];
+
+        uint32_t sequence = target->sequence.load(std::memory_order_relaxed);
+
+        if (sequence & 1 || !target->sequence.compare_exchange_strong(sequence, sequence + 1, std::memory_order_acquire))
+            return false;
+
+        std::atomic_thread_fence(std::memory_order_release);
+
+        target->key.store(key, std::memory_order_relaxed);
+        Store(*target, value);
+
+        target->sequence.store(sequence + 2, std::memory_order_release);
+
+        return true;
+    }
+
+    //Every slot the key is in, there can be two if two threads put it in at once.
+    bool erase(uint32_t key)
+    {
+        if (!key)
+            return false;
+
+        bool erased = false;
+
+        for (size_t i = 0; i < k_window; i++)
+        {
+            auto& slot = _slots[(Mix(key) + i) & (N - 1)];
+
+            if (slot.key.load(std::memory_order_relaxed) != key)
+                continue;
+
+            uint32_t sequence = Claim(slot);
+
+            if (slot.key.load(std::memory_order_relaxed) == key) {
+                slot.key.store(0, std::memory_order_relaxed);
+                erased = true;
+            }
+
+            slot.sequence.store(sequence + 2, std::memory_order_release);
+        }
+
+        return erased;
+    }
+
+    //Calls back with every key and a copy of its value. Whatever's written at the same time may or may not be seen.
+    template <class F>
+    void for_each(F&& callback) const
+    {
+        for (auto& slot : _slots)
+        {
+            uint32_t sequence = slot.sequence.load(std::memory_order_acquire);
+            uint32_t key = slot.key.load(std::memory_order_relaxed);
+
+            if (sequence & 1 || !key)
+                continue;
+
+            T value = Load(slot);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if (slot.sequence.load(std::memory_order_relaxed) == sequence)
+                callback(key, value);
+        }
+    }
+
+    void clear()
+    {
+        for (auto& slot : _slots)
+        {
+            if (!slot.key.load(std::memory_order_relaxed))
+                continue;
+
+            uint32_t sequence = Claim(slot);
+            slot.key.store(0, std::memory_order_relaxed);
+            slot.sequence.store(sequence + 2, std::memory_order_release);
+        }
+    }
+
+    static constexpr size_t capacity() { return N; }
+
+private:
+    struct Slot
+    {
+        std::atomic<uint32_t> sequence{ 0 };
+        std::atomic<uint32_t> key{ 0 };
+        std::array<std::atomic<uint32_t>, k_words> words{};
+    };
+
+    static uint32_t Mix(uint32_t x)
+    {
+        x ^= x >> 16;
+        x *= 0x7FEB352D;
+        x ^= x >> 15;
+        return x;
+    }
+
+    //Waits out whoever has the slot, writers only hold it for a copy.
+    static uint32_t Claim(Slot& slot)
+    {
+        for (;;)
+        {
+            uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+
+            if (!(sequence & 1) && slot.sequence.compare_exchange_weak(sequence, sequence + 1, std::memory_order_acquire)) {
+                std::atomic_thread_fence(std::memory_order_release);
+                return sequence;
+            }
+        }
+    }
+
+    static T Load(const Slot& slot)
+    {
+        std::array<uint32_t, k_words> words;
+
+        for (size_t i = 0; i < k_words; i++)
+            words[i] = slot.words[i].load(std::memory_order_relaxed);
+
+        return std::bit_cast<T>(words);
+    }
+
+    static void Store(Slot& slot, const T& value)
+    {
+        auto words = std::bit_cast<std::array<uint32_t, k_words>>(value);
+
+        for (size_t i = 0; i < k_words; i++)
+            slot.words[i].store(words[i], std::memory_order_relaxed);
+    }
+
+    std::array<Slot, N> _slots{};
+};
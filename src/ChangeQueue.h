@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+//Bounded lock free queue, any number of threads can push but only one may pop. Hooks fire from what ever thread is applying
+// the effect, the end of frame flush is the only reader. Each cell carries a sequence number so a reader never sees a value
+// before the writer that claimed the cell has finished with it.
+
+template <class T, size_t N>
+class ChangeQueue
+{
+    static_assert(std::has_single_bit(N), "ChangeQueue capacity must be a power of 2.");
+
+public:
+    ChangeQueue()
+    {
+        for (size_t i = 0; i < N; i++)
+            _cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    //False if the queue is full.
+    bool push(const T& value)
+    {
+        size_t pos = _enqueue.load(std::memory_order_relaxed);
+
+        for (;;)
+        {
+            Cell& cell = _cells[pos & (N - 1)];
+
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+
+            if (diff == 0) {
+                if (_enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = value;
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0) {
+                return false;
+            }
+            else {
+                pos = _enqueue.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    //Only ever call from one thread.
+    bool pop(T& value)
+    {
+        Cell& cell = _cells[_dequeue & (N - 1)];
+
+        size_t sequence = cell.sequence.load(std::memory_order_acquire);
+
+        if (static_cast<intptr_t>(sequence) - static_cast<intptr_t>(_dequeue + 1) < 0)
+            return false;
+
+        value = cell.value;
+        cell.sequence.store(_dequeue + N, std::memory_order_release);
+        _dequeue++;
+
+        return true;
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::array<Cell, N> _cells;
+
+    alignas(64) std::atomic<size_t> _enqueue{ 0 };
+    alignas(64) size_t _dequeue = 0;
+};
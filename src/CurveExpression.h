@@ -0,0 +1,652 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <expected>
+#include <format>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//Only the compiler needs Xbyak, without it there's just the interpreter.
+#if __has_include("xbyak/xbyak.h")
+#include "xbyak/xbyak.h"
+#define CARP_CURVE_JIT
+#endif
+
+//User written speed curves. An expression is parsed into a small stack program, which can either be run as is or compiled
+// to native code. Both go through Apply for anything that isn't a plain load, and the compiled ops are picked to round the
+// same way (minss/maxss order, sqrtss, calls into the same functions), so the two give identical results.
+//
+// Variables: speed (or x), base, minSpeed, capSpeed, speedTaper, maxSpeed
+// Operators: + - * / ^ < > and unary -, with the usual precedence. ^ is right associative.
+// Functions: sqrt abs exp log pow min max clamp(v, lo, hi) select(c, a, b), select gives a when c > 0.
+//
+// Doesn't know anything about the game, so it builds and runs the same anywhere, compiled anywhere Xbyak is.
+
+namespace CurveExpression
+{
+    enum struct Var : uint8_t
+    {
+        Speed,
+        Base,
+        MinSpeed,
+        CapSpeed,
+        SpeedTaper,
+        MaxSpeed,
+
+        Total
+    };
+
+    using Inputs = std::array<float, static_cast<size_t>(Var::Total)>;
+
+    //What compiled curves look like.
+    using Function = float(*)(const float* inputs);
+
+
+    enum struct Op : uint8_t
+    {
+        Const,
+        Load,
+
+        Neg,
+        Abs,
+        Sqrt,
+        Call1,
+
+        Add,
+        Sub,
+        Mul,
+        Div,
+        Min,
+        Max,
+        Less,
+        Greater,
+        Call2,
+
+        Select,
+    };
+
+    struct Instruction
+    {
+        Op op;
+        uint8_t index = 0;
+        float value = 0;
+        uintptr_t function = 0;
+    };
+
+
+    constexpr size_t k_maxDepth = 32;
+    constexpr size_t k_maxInstructions = 256;
+
+
+    //Out of line on purpose, both the interpreter and the compiled code call these.
+    inline float Exp(float x) { return std::exp(x); }
+    inline float Log(float x) { return std::log(x); }
+    inline float Pow(float x, float y) { return std::pow(x, y); }
+
+
+    constexpr size_t Arity(Op op)
+    {
+        if (op <= Op::Load)
+            return 0;
+        if (op <= Op::Call1)
+            return 1;
+        if (op <= Op::Call2)
+            return 2;
+        return 3;
+    }
+
+    //args are in push order.
+    inline float Apply(const Instruction& instruction, const float* args)
+    {
+        float a = args[0];
+
+        switch (instruction.op)
+        {
+        case Op::Neg:       return -a;
+        case Op::Abs:       return std::fabs(a);
+        case Op::Sqrt:      return std::sqrt(a);
+        case Op::Call1:     return reinterpret_cast<float(*)(float)>(instruction.function)(a);
+
+        case Op::Add:       return a + args[1];
+        case Op::Sub:       return a - args[1];
+        case Op::Mul:       return a * args[1];
+        case Op::Div:       return a / args[1];
+        //Same operand order as minss/maxss, NaNs and signed zeros come out the same.
+        case Op::Min:       return a < args[1] ? a : args[1];
+        case Op::Max:       return a > args[1] ? a : args[1];
+        case Op::Less:      return a < args[1] ? 1.f : 0.f;
+        case Op::Greater:   return a > args[1] ? 1.f : 0.f;
+        case Op::Call2:     return reinterpret_cast<float(*)(float, float)>(instruction.function)(a, args[1]);
+
+        case Op::Select:    return a > 0.f ? args[1] : args[2];
+
+        default:            return 0.f;
+        }
+    }
+
+
+    class Program
+    {
+    public:
+        static std::expected<Program, std::string> Parse(std::string_view text)
+        {
+            Parser parser{ .rest = text, .error = {}, .nesting = 0 };
+
+            Program result;
+
+            if (!parser.Expression(result._code))
+                return std::unexpected(parser.error);
+
+            parser.Skip();
+
+            if (!parser.rest.empty())
+                return std::unexpected(std::format("Unexpected '{}'", parser.rest));
+
+            if (result._code.size() > k_maxInstructions)
+                return std::unexpected(std::format("Curve is too long ({} instructions, max {})", result._code.size(), k_maxInstructions));
+
+            result._depth = result.MeasureDepth();
+
+            if (result._depth > k_maxDepth)
+                return std::unexpected(std::format("Curve nests too deep ({}, max {})", result._depth, k_maxDepth));
+
+            return result;
+        }
+
+
+        //A copy where the given variable is a constant, with what ever that makes constant folded away.
+        Program Bind(Var var, float value) const
+        {
+            Program result;
+
+            for (auto instruction : _code)
+            {
+                if (instruction.op == Op::Load && instruction.index == static_cast<uint8_t>(var))
+                    instruction = { .op = Op::Const, .value = value };
+
+                result.Push(instruction);
+            }
+
+            result._depth = result.MeasureDepth();
+
+            return result;
+        }
+
+
+        float Run(const float* inputs) const
+        {
+            float stack[k_maxDepth];
+            size_t depth = 0;
+
+            for (auto& instruction : _code)
+            {
+                switch (instruction.op)
+                {
+                case Op::Const:
+                    stack[depth++] = instruction.value;
+                    break;
+
+                case Op::Load:
+                    stack[depth++] = inputs[instruction.index];
+                    break;
+
+                default:
+                    depth -= Arity(instruction.op);
+                    stack[depth] = Apply(instruction, &stack[depth]);
+                    depth++;
+                    break;
+                }
+            }
+
+            return stack[0];
+        }
+
+
+        const std::vector<Instruction>& code() const { return _code; }
+        size_t depth() const { return _depth; }
+
+    private:
+        //Folds as it goes, an op whose inputs were all just pushed as constants becomes a constant.
+        void Push(const Instruction& instruction)
+        {
+            auto arity = Arity(instruction.op);
+
+            if (arity && _code.size() >= arity &&
+                std::all_of(_code.end() - arity, _code.end(), [](auto& it) { return it.op == Op::Const; }))
+            {
+                float args[3];
+
+                for (size_t i = 0; i < arity; i++)
+                    args[i] = _code[_code.size() - arity + i].value;
+
+                _code.resize(_code.size() - arity);
+                _code.push_back({ .op = Op::Const, .value = Apply(instruction, args) });
+                return;
+            }
+
+            _code.push_back(instruction);
+        }
+
+        size_t MeasureDepth() const
+        {
+            size_t depth = 0;
+            size_t result = 0;
+
+            for (auto& instruction : _code)
+            {
+                auto arity = Arity(instruction.op);
+
+                depth = depth - arity + 1;
+                result = std::max(result, depth);
+            }
+
+            return result;
+        }
+
+
+        struct Parser
+        {
+            std::string_view rest;
+            std::string error;
+            size_t nesting = 0;
+
+            void Skip()
+            {
+                while (!rest.empty() && std::isspace(static_cast<unsigned char>(rest.front())))
+                    rest.remove_prefix(1);
+            }
+
+            bool Accept(char c)
+            {
+                Skip();
+
+                if (rest.empty() || rest.front() != c)
+                    return false;
+
+                rest.remove_prefix(1);
+                return true;
+            }
+
+            bool Expect(char c)
+            {
+                if (Accept(c))
+                    return true;
+
+                if (error.empty())
+                    error = rest.empty() ? std::format("Expected '{}' at the end", c) : std::format("Expected '{}' at '{}'", c, rest);
+                return false;
+            }
+
+            bool Fail(std::string message)
+            {
+                if (error.empty())
+                    error = std::move(message);
+                return false;
+            }
+
+
+            bool Expression(std::vector<Instruction>& out)
+            {
+                if (!Additive(out))
+                    return false;
+
+                if (Accept('<'))
+                    return Additive(out) && (out.push_back({ Op::Less }), true);
+
+                if (Accept('>'))
+                    return Additive(out) && (out.push_back({ Op::Greater }), true);
+
+                return true;
+            }
+
+            bool Additive(std::vector<Instruction>& out)
+            {
+                if (!Term(out))
+                    return false;
+
+                for (;;)
+                {
+                    if (Accept('+')) {
+                        if (!Term(out)) return false;
+                        out.push_back({ Op::Add });
+                    }
+                    else if (Accept('-')) {
+                        if (!Term(out)) return false;
+                        out.push_back({ Op::Sub });
+                    }
+                    else {
+                        return true;
+                    }
+                }
+            }
+
+            bool Term(std::vector<Instruction>& out)
+            {
+                if (!Unary(out))
+                    return false;
+
+                for (;;)
+                {
+                    if (Accept('*')) {
+                        if (!Unary(out)) return false;
+                        out.push_back({ Op::Mul });
+                    }
+                    else if (Accept('/')) {
+                        if (!Unary(out)) return false;
+                        out.push_back({ Op::Div });
+                    }
+                    else {
+                        return true;
+                    }
+                }
+            }
+
+            //Everything that nests comes back through here, so this is what keeps a silly config from running off the stack.
+            bool Unary(std::vector<Instruction>& out)
+            {
+                if (nesting >= k_maxDepth)
+                    return Fail(std::format("Curve nests too deep (max {})", k_maxDepth));
+
+                nesting++;
+                bool result = Signed(out);
+                nesting--;
+
+                return result;
+            }
+
+            bool Signed(std::vector<Instruction>& out)
+            {
+                if (Accept('-'))
+                    return Unary(out) && (out.push_back({ Op::Neg }), true);
+
+                if (!Primary(out))
+                    return false;
+
+                if (Accept('^'))
+                    return Unary(out) && (out.push_back({ Op::Call2, 0, 0, reinterpret_cast<uintptr_t>(&Pow) }), true);
+
+                return true;
+            }
+
+            bool Primary(std::vector<Instruction>& out)
+            {
+                Skip();
+
+                if (Accept('('))
+                    return Expression(out) && Expect(')');
+
+                if (rest.empty())
+                    return Fail("Unexpected end of curve");
+
+                char front = rest.front();
+
+                if (std::isdigit(static_cast<unsigned char>(front)) || front == '.')
+                {
+                    float value;
+                    auto [end, ec] = std::from_chars(rest.data(), rest.data() + rest.size(), value);
+
+                    if (ec != std::errc{})
+                        return Fail(std::format("Bad number at '{}'", rest));
+
+                    rest.remove_prefix(end - rest.data());
+                    out.push_back({ .op = Op::Const, .value = value });
+                    return true;
+                }
+
+                if (!std::isalpha(static_cast<unsigned char>(front)))
+                    return Fail(std::format("Unexpected '{}'", rest));
+
+                size_t length = 0;
+
+                while (length < rest.size() && std::isalnum(static_cast<unsigned char>(rest[length])))
+                    length++;
+
+                auto name = rest.substr(0, length);
+                rest.remove_prefix(length);
+
+                Skip();
+
+                if (!rest.empty() && rest.front() == '(')
+                    return Call(name, out);
+
+                static constexpr std::pair<std::string_view, Var> k_variables[]
+                {
+                    { "x", Var::Speed },
+                    { "speed", Var::Speed },
+                    { "base", Var::Base },
+                    { "minSpeed", Var::MinSpeed },
+                    { "capSpeed", Var::CapSpeed },
+                    { "speedTaper", Var::SpeedTaper },
+                    { "maxSpeed", Var::MaxSpeed },
+                };
+
+                for (auto& [var_name, var] : k_variables) {
+                    if (name == var_name) {
+                        out.push_back({ .op = Op::Load, .index = static_cast<uint8_t>(var) });
+                        return true;
+                    }
+                }
+
+                return Fail(std::format("Unknown variable '{}'", name));
+            }
+
+            bool Arguments(std::vector<Instruction>& out, size_t count)
+            {
+                if (!Expect('('))
+                    return false;
+
+                for (size_t i = 0; i < count; i++) {
+                    if (i && !Expect(','))
+                        return false;
+
+                    if (!Expression(out))
+                        return false;
+                }
+
+                return Expect(')');
+            }
+
+            bool Call(std::string_view name, std::vector<Instruction>& out)
+            {
+                struct Builtin
+                {
+                    std::string_view name;
+                    size_t count;
+                    Instruction instruction;
+                };
+
+                static const Builtin k_builtins[]
+                {
+                    { "sqrt", 1, { Op::Sqrt } },
+                    { "abs", 1, { Op::Abs } },
+                    { "exp", 1, { Op::Call1, 0, 0, reinterpret_cast<uintptr_t>(&Exp) } },
+                    { "log", 1, { Op::Call1, 0, 0, reinterpret_cast<uintptr_t>(&Log) } },
+                    { "pow", 2, { Op::Call2, 0, 0, reinterpret_cast<uintptr_t>(&Pow) } },
+                    { "min", 2, { Op::Min } },
+                    { "max", 2, { Op::Max } },
+                    { "select", 3, { Op::Select } },
+                };
+
+                //clamp(v, lo, hi) is max(min(v, hi), lo), lo gets parsed off to the side so it can go last.
+                if (name == "clamp")
+                {
+                    std::vector<Instruction> low;
+
+                    if (!Expect('(') || !Expression(out) || !Expect(',') || !Expression(low) || !Expect(',') || !Expression(out) || !Expect(')'))
+                        return false;
+
+                    out.push_back({ Op::Min });
+                    out.insert(out.end(), low.begin(), low.end());
+                    out.push_back({ Op::Max });
+                    return true;
+                }
+
+                for (auto& builtin : k_builtins) {
+                    if (name == builtin.name) {
+                        if (!Arguments(out, builtin.count))
+                            return false;
+
+                        out.push_back(builtin.instruction);
+                        return true;
+                    }
+                }
+
+                return Fail(std::format("Unknown function '{}'", name));
+            }
+        };
+
+
+        std::vector<Instruction> _code;
+        size_t _depth = 0;
+    };
+
+
+
+#ifdef CARP_CURVE_JIT
+    //The program as native code. Every value lives in a stack slot and only xmm0-2 are ever used, so calling out needs
+    // nothing saved on either calling convention.
+    class Compiled : public Xbyak::CodeGenerator
+    {
+    public:
+        explicit Compiled(const Program& program) :
+            Xbyak::CodeGenerator(0x40 + program.code().size() * 0x40)
+        {
+#ifdef _WIN32
+            const Xbyak::Reg64& inputs = rcx;
+#else
+            const Xbyak::Reg64& inputs = rdi;
+#endif
+            //The push puts rsp back on 16, the frame keeps it there. First 0x20 is the home space the windows calls want.
+            const auto frame = static_cast<uint32_t>((0x20 + program.depth() * sizeof(float) + 0xF) & ~size_t{ 0xF });
+
+            auto slot = [&](size_t i) { return dword[rsp + 0x20 + i * sizeof(float)]; };
+
+            push(rbx);
+            mov(rbx, inputs);
+            sub(rsp, frame);
+
+            size_t depth = 0;
+
+            for (auto& instruction : program.code())
+            {
+                auto arity = Arity(instruction.op);
+
+                //Where the result goes, also where the first argument is.
+                auto top = depth - arity;
+
+                switch (instruction.op)
+                {
+                case Op::Const:
+                    mov(slot(top), std::bit_cast<uint32_t>(instruction.value));
+                    break;
+
+                case Op::Load:
+                    movss(xmm0, dword[rbx + instruction.index * sizeof(float)]);
+                    movss(slot(top), xmm0);
+                    break;
+
+                case Op::Neg:
+                    xor_(slot(top), 0x80000000);
+                    break;
+
+                case Op::Abs:
+                    and_(slot(top), 0x7FFFFFFF);
+                    break;
+
+                case Op::Sqrt:
+                    sqrtss(xmm0, slot(top));
+                    movss(slot(top), xmm0);
+                    break;
+
+                case Op::Call1:
+                    movss(xmm0, slot(top));
+                    mov(rax, instruction.function);
+                    call(rax);
+                    movss(slot(top), xmm0);
+                    break;
+
+                case Op::Add:
+                case Op::Sub:
+                case Op::Mul:
+                case Op::Div:
+                case Op::Min:
+                case Op::Max:
+                    movss(xmm0, slot(top));
+
+                    switch (instruction.op)
+                    {
+                    case Op::Add: addss(xmm0, slot(top + 1)); break;
+                    case Op::Sub: subss(xmm0, slot(top + 1)); break;
+                    case Op::Mul: mulss(xmm0, slot(top + 1)); break;
+                    case Op::Div: divss(xmm0, slot(top + 1)); break;
+                    case Op::Min: minss(xmm0, slot(top + 1)); break;
+                    case Op::Max: maxss(xmm0, slot(top + 1)); break;
+                    }
+
+                    movss(slot(top), xmm0);
+                    break;
+
+                case Op::Less:
+                case Op::Greater:
+                    //a > b is b < a.
+                    if (instruction.op == Op::Less) {
+                        movss(xmm0, slot(top));
+                        cmpltss(xmm0, slot(top + 1));
+                    }
+                    else {
+                        movss(xmm0, slot(top + 1));
+                        cmpltss(xmm0, slot(top));
+                    }
+
+                    mov(eax, std::bit_cast<uint32_t>(1.f));
+                    movd(xmm1, eax);
+                    andps(xmm0, xmm1);
+                    movss(slot(top), xmm0);
+                    break;
+
+                case Op::Call2:
+                    movss(xmm0, slot(top));
+                    movss(xmm1, slot(top + 1));
+                    mov(rax, instruction.function);
+                    call(rax);
+                    movss(slot(top), xmm0);
+                    break;
+
+                case Op::Select:
+                    //mask = 0 < c, then (a & mask) | (b & ~mask)
+                    xorps(xmm2, xmm2);
+                    cmpltss(xmm2, slot(top));
+                    movss(xmm0, slot(top + 1));
+                    andps(xmm0, xmm2);
+                    movss(xmm1, slot(top + 2));
+                    andnps(xmm2, xmm1);
+                    orps(xmm0, xmm2);
+                    movss(slot(top), xmm0);
+                    break;
+                }
+
+                depth = top + 1;
+            }
+
+            movss(xmm0, slot(0));
+            add(rsp, frame);
+            pop(rbx);
+            ret();
+
+            ready();
+        }
+
+        Function get() const
+        {
+            return getCode<Function>();
+        }
+    };
+#endif
+}
@@ -0,0 +1,205 @@
+#pragma once
+
+#include "TagAudit.h"
+
+#include <array>
+#include <cmath>
+#include <optional>
+#include <vector>
+
+//What the value effect hooks and GetActorValueHook do to the speed tags, kept apart from the game so the same bodies run
+// in the plugin and in the tests. The thunks in Main.cpp are left with the glue: the original call, profiling and logs.
+//
+// Game is a set of static functions over whatever stands for the game (GameAccess in Main.cpp, Host::Game in the tests):
+//
+//  Effect, Actor                   the value modifier effect and the actor its target is
+//  Target(effect)                  the actor the effect is on, or null
+//  Hand(effect)                    true for right, false for left, nothing if it isn't a speed value
+//  SecondaryHand(effect)           the same for a dual value modifier's second value
+//  DualWeight(effect)              what the second value is scaled by
+//  Recovers, Detrimental, Dispelled(effect)
+//  Magnitude(effect)               the effect's magnitude, Value(effect) what's on the actor value right now
+//  Applied, ConditionsHold(effect) whether a loaded effect has its values on
+//  Mark(effect)                    a uint16_t& that lives on the effect, see TagAudit::Mark
+//  Tag(actor, right)               a float& that lives on the actor
+//  Sync(actor)                     after either of the actor's tags changed
+//  SpeedRelevant(effect)           whether it can touch weapon speed at all
+//  BeforeSpeedChange(actor)        before anything moves the actor's speed, what it is now is what it's changing from
+//  ForEachValueEffect(actor, cb)   calls cb(effect, type) for each speed relevant effect on the actor, false if it has no list
+
+namespace EffectHooks
+{
+    //Which ModifierEffect an effect is, the order the hooks are written in.
+    enum Type : int
+    {
+        kValueMod,
+        kDualMod,
+        kAccumMod,
+        kPeakMod,
+        kEnhance,
+    };
+
+
+    //TagAudit::Applies for a live effect. Only start and the load ask this, and they leave the answer on the effect.
+    template <class Game>
+    bool AppliesToTags(typename Game::Effect* effect, int type)
+    {
+        return TagAudit::Applies(Game::Recovers(effect), Game::Detrimental(effect), type == kEnhance && Game::Dispelled(effect));
+    }
+
+    //TagAudit::Counts for a live effect, what finish and the auditor go by.
+    template <class Game>
+    bool CountsToTags(typename Game::Effect* effect)
+    {
+        return TagAudit::Counts(Game::Mark(effect), Game::Recovers(effect), Game::Detrimental(effect));
+    }
+
+    //The value start, finish and the load count with, and so what the auditor has to count too.
+    template <class Game>
+    float TagValue(typename Game::Effect* effect)
+    {
+        float value = Game::Value(effect);
+        float alignment = value >= 0 ? 1 : -1;
+
+        float magnitude = Game::Magnitude(effect);
+
+        //If for some reason something is a value modifier that modifies speed that is zero, but the current value is equal to 1, were
+        // going to treat it like its 1. Loads were where that came up, but finish has to see the same or it never comes back off.
+        if (auto act_mag = std::abs(value); !magnitude && act_mag >= 1)
+            magnitude = act_mag;
+
+        return magnitude * alignment;
+    }
+
+
+    //Note, currently these adjustments don't work if the magnitude gets flipped. Need to account for that sort of situations.
+    // That will likely rest in handle actor tag. But due to the projects nature, I can add it any time the problem arises.
+    //
+    // is_dual is if it's a dual value modifier, its second value gets counted on its own. is_on declares that negative values
+    // are of no concern, they're intentional decreases.
+    template <class Game>
+    void HandleSpeedEffect(typename Game::Effect* effect, float value, bool is_dual, bool is_on)
+    {
+        auto target = Game::Target(effect);
+
+        if (!target)
+            return;
+
+        if (auto right = Game::Hand(effect))
+            Game::Tag(target, *right) += TagAudit::Count(is_on, value);
+
+        if (is_dual) {
+            if (auto right = Game::SecondaryHand(effect))
+                Game::Tag(target, *right) += TagAudit::Count(is_on, value * Game::DualWeight(effect));
+        }
+
+        Game::Sync(target);
+    }
+
+
+    //Before the original start or finish, false for anything that can't touch weapon speed. Marks the actor while the speed
+    // is still what it's changing from.
+    template <class Game>
+    bool Prepare(typename Game::Effect* effect)
+    {
+        if (!Game::SpeedRelevant(effect))
+            return false;
+
+        Game::BeforeSpeedChange(Game::Target(effect));
+        return true;
+    }
+
+    //After the original start. Enhance effects that are already dispelled are left out in here, finish goes by what's
+    // decided here. True if it was counted.
+    template <class Game>
+    bool Start(typename Game::Effect* effect, int type)
+    {
+        bool counted = AppliesToTags<Game>(effect, type);
+
+        Game::Mark(effect) = TagAudit::MarkFor(counted);
+
+        if (counted)
+            HandleSpeedEffect<Game>(effect, TagValue<Game>(effect), type == kDualMod, true);
+
+        return counted;
+    }
+
+    //After the original finish. Takes off what start put on, a dispel on the way out doesn't change that.
+    template <class Game>
+    bool Finish(typename Game::Effect* effect, int type)
+    {
+        bool counted = CountsToTags<Game>(effect);
+
+        if (counted)
+            HandleSpeedEffect<Game>(effect, TagValue<Game>(effect), type == kDualMod, false);
+
+        //Nothing left on for a second finish to take off.
+        Game::Mark(effect) = TagAudit::kSkipped;
+
+        return counted;
+    }
+
+    //After the original FinishLoadGame, for a speed relevant effect. Only what has its values on right now, past that it's
+    // the same rule and value start goes by. What's decided is left on the effect the same way, so finish and the auditor
+    // agree with the tags this builds.
+    template <class Game>
+    bool Load(typename Game::Effect* effect, int type)
+    {
+        bool counted = Game::Applied(effect) && Game::ConditionsHold(effect) && AppliesToTags<Game>(effect, type);
+
+        Game::Mark(effect) = TagAudit::MarkFor(counted);
+
+        if (counted)
+            HandleSpeedEffect<Game>(effect, TagValue<Game>(effect), type == kDualMod, true);
+
+        return counted;
+    }
+
+
+    //What GetActorValueHook hands back for a speed value, the game's result with the tag taken back off.
+    template <class Game>
+    float ActorValue(typename Game::Actor* actor, bool right, float result)
+    {
+        return result - Game::Tag(actor, right);
+    }
+
+
+    //What the tags should be going by the actor's active effects, with what start or the load decided and the value they
+    // use. Anything else and the tags get pulled somewhere finish can't bring them back from.
+    template <class Game>
+    std::optional<std::array<float, 2>> Recompute(typename Game::Actor* actor)
+    {
+        static std::vector<TagAudit::Effect> found;
+
+        found.clear();
+
+        bool listed = Game::ForEachValueEffect(actor, [&](typename Game::Effect* effect, int type) {
+            TagAudit::Effect entry
+            {
+                .contribution = {},
+                .recovers = Game::Recovers(effect),
+                .detrimental = Game::Detrimental(effect),
+                .mark = Game::Mark(effect),
+            };
+
+            float value = TagValue<Game>(effect);
+
+            if (auto right = Game::Hand(effect)) {
+                entry.contribution = { *right, value };
+                found.push_back(entry);
+            }
+
+            if (type == kDualMod) {
+                if (auto right = Game::SecondaryHand(effect)) {
+                    entry.contribution = { *right, value * Game::DualWeight(effect) };
+                    found.push_back(entry);
+                }
+            }
+        });
+
+        if (!listed)
+            return std::nullopt;
+
+        return TagAudit::Recompute(found);
+    }
+}
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <array>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <expected>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+
+//What the effect hooks want to know about a spell or effect, and the file tools/plugin_scanner writes it out to ahead of
+// time. The rules are here in raw numbers so the plugin (classifying forms as it finds them) and the scanner (classifying
+// records straight out of the plugin files) can't disagree.
+//
+// The file is a header and a flat array of entries that's read where it's mapped. The plugin only checks its own table
+// against it and logs where they differ, what's loaded is always what's used. It's tied to one load order by a hash of
+// every plugin's name, size and last write time, anything else and it's stale and the check is skipped.
+//
+// Doesn't know anything about the game, the values are the ones the game's records and enums use.
+
+namespace EffectIndex
+{
+    enum Flag : uint8_t
+    {
+        //MagicItem
+        kAdjusts = 1 << 0,          //Effectiveness applies to it at all.
+
+        //EffectSetting
+        kAdjustDuration = 1 << 1,
+        kAdjustMagnitude = 1 << 2,
+        kHostile = 1 << 3,
+        kDetrimental = 1 << 4,
+        kRecovers = 1 << 5,
+        kSpeedRelevant = 1 << 6,    //Modifies one of the weapon speed values.
+    };
+
+
+    //EffectSetting flags, as in the MGEF DATA.
+    constexpr uint32_t k_settingHostile = 1 << 0;
+    constexpr uint32_t k_settingRecover = 1 << 1;
+    constexpr uint32_t k_settingDetrimental = 1 << 2;
+    constexpr uint32_t k_settingNoDuration = 1 << 9;
+    constexpr uint32_t k_settingNoMagnitude = 1 << 10;
+    constexpr uint32_t k_settingPowerAffectsMagnitude = 1 << 21;
+    constexpr uint32_t k_settingPowerAffectsDuration = 1 << 22;
+
+    //MagicSystem::SpellType and CastingType values that matter.
+    constexpr uint32_t k_spellDisease = 1;
+    constexpr uint32_t k_spellAbility = 4;
+    constexpr uint32_t k_spellEnchantment = 6;
+    constexpr uint32_t k_spellIngredient = 8;
+    constexpr uint32_t k_spellAddiction = 10;
+    constexpr uint32_t k_castConstantEffect = 0;
+
+
+    //Everything but kSpeedRelevant, which depends on actor value ids only the game side knows for sure.
+    inline uint8_t ClassifyEffect(uint32_t flags)
+    {
+        uint8_t result = 0;
+
+        if (!(flags & k_settingNoDuration) && flags & k_settingPowerAffectsDuration)
+            result |= kAdjustDuration;
+
+        if (!(flags & k_settingNoMagnitude) && flags & k_settingPowerAffectsMagnitude)
+            result |= kAdjustMagnitude;
+
+        if (flags & k_settingHostile)
+            result |= kHostile;
+
+        if (flags & k_settingDetrimental)
+            result |= kDetrimental;
+
+        if (flags & k_settingRecover)
+            result |= kRecovers;
+
+        return result;
+    }
+
+    inline uint8_t ClassifyItem(uint32_t spell_type, uint32_t casting_type)
+    {
+        switch (spell_type)
+        {
+        case k_spellDisease:
+        case k_spellAbility:
+        case k_spellIngredient:
+        case k_spellAddiction:
+            return 0;
+
+        case k_spellEnchantment:
+            return casting_type != k_castConstantEffect ? kAdjusts : 0;
+
+        default:
+            return kAdjusts;
+        }
+    }
+
+
+    constexpr std::array<char, 8> k_magic{ 'C', 'A', 'R', 'P', 'E', 'F', 'F', 'X' };
+    constexpr uint32_t k_version = 2;
+
+    struct FileHeader
+    {
+        std::array<char, 8> magic;
+        uint32_t version;
+        uint32_t count;
+        uint64_t loadOrder;     //LoadOrderHash of what it was scanned from.
+    };
+    static_assert(sizeof(FileHeader) == 24);
+
+    enum Kind : uint8_t
+    {
+        kEffect,
+        kItem,
+    };
+
+    //The actor values are kept raw, the plugin sets kSpeedRelevant from them when it loads the file. Items have -1 for both.
+    struct Entry
+    {
+        uint32_t formID;
+        uint8_t flags;
+        Kind kind;
+        uint8_t pad[2];
+        int32_t primaryAV;
+        int32_t secondaryAV;
+    };
+    static_assert(sizeof(Entry) == 16);
+
+
+    //A file's last write time in whole seconds since 1970. The plugin and the scanner don't share a file clock, and a copy
+    // between file systems can lose anything finer than a second.
+    inline int64_t WriteTime(const std::filesystem::path& path, std::error_code& error)
+    {
+        auto time = std::filesystem::last_write_time(path, error);
+
+        if (error)
+            return 0;
+
+        return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::file_clock::to_sys(time).time_since_epoch()).count();
+    }
+
+    //FNV-1a over each plugin's lowercased name, size and write time, full plugins in load order then light ones. Saving a
+    // plugin again without changing its size still moves the hash.
+    class LoadOrderHash
+    {
+    public:
+        void Add(std::string_view name, uint64_t size, int64_t write_time)
+        {
+            for (char c : name)
+                Mix(static_cast<uint8_t>(std::tolower(static_cast<unsigned char>(c))));
+
+            Mix(0);
+
+            for (int i = 0; i < 8; i++)
+                Mix(static_cast<uint8_t>(size >> (i * 8)));
+
+            for (int i = 0; i < 8; i++)
+                Mix(static_cast<uint8_t>(static_cast<uint64_t>(write_time) >> (i * 8)));
+        }
+
+        uint64_t value() const { return _value; }
+
+    private:
+        void Mix(uint8_t byte)
+        {
+            _value ^= byte;
+            _value *= 0x100000001B3;
+        }
+
+        uint64_t _value = 0xCBF29CE484222325;
+    };
+
+
+    //Checks a mapped file and gives back its entries, which point into the mapping.
+    inline std::expected<std::span<const Entry>, std::string> View(const void* data, size_t size, uint64_t load_order)
+    {
+        if (size < sizeof(FileHeader))
+            return std::unexpected("too small to be an index");
+
+        FileHeader header;
+        std::memcpy(&header, data, sizeof(header));
+
+        if (header.magic != k_magic)
+            return std::unexpected("not an index");
+
+        if (header.version != k_version)
+            return std::unexpected("made by a different version of the scanner");
+
+        if (size != sizeof(FileHeader) + static_cast<size_t>(header.count) * sizeof(Entry))
+            return std::unexpected("size doesn't match its entry count");
+
+        if (header.loadOrder != load_order)
+            return std::unexpected("made for a different load order");
+
+        return std::span{ reinterpret_cast<const Entry*>(static_cast<const char*>(data) + sizeof(FileHeader)), header.count };
+    }
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cmath>
+
+//The arithmetic of scaling an effect by spell effectiveness, away from deciding whether it should be.
+//
+// Doesn't know anything about the game.
+
+namespace Effectiveness
+{
+    //The smallest magnitude effectiveness is allowed to scale something down to, the step just past the comparison.
+    inline float MinMagnitude(float magnitude_comparison)
+    {
+        float mag_comp = std::fabs(magnitude_comparison);
+        return std::nextafter(mag_comp, INFINITY) - mag_comp;
+    }
+
+    //Keeps the sign, and never lets a scaled magnitude reach zero.
+    inline float ScaleMagnitude(float magnitude, float effectiveness, float min_magnitude)
+    {
+        float polarity = magnitude < 0 ? -1 : 1;
+
+        return std::fmax(std::fabs(magnitude) * effectiveness, min_magnitude) * polarity;
+    }
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+//Immutable form id -> value map, built once on data load and only read after. It's a hash and displace perfect hash, every
+// key gets a bucket, and each bucket stores the seed that scatters its keys onto slots nobody else has. A lookup is the seed
+// load then a single probe of the slot, present or not. Doesn't know anything about the game, keys are just the runtime
+// form ids.
+
+template <class T>
+class FormTable
+{
+public:
+    FormTable() = default;
+
+    //Duplicate ids keep the last value given. Id 0 is never a form and is what marks an empty slot, so it's dropped.
+    explicit FormTable(std::vector<std::pair<uint32_t, T>> entries)
+    {
+        std::erase_if(entries, [](auto& entry) { return entry.first == 0; });
+
+        std::ranges::stable_sort(entries, {}, &std::pair<uint32_t, T>::first);
+
+        //Reverse unique so the last of each run survives.
+        auto last = std::unique(entries.rbegin(), entries.rend(), [](auto& a, auto& b) { return a.first == b.first; });
+        entries.erase(entries.begin(), last.base());
+
+        if (entries.empty())
+            return;
+
+        size_t slots = std::bit_ceil(entries.size() + entries.size() / 4);
+
+        while (!Build(entries, slots))
+            slots <<= 1;
+    }
+
+
+    const T* find(uint32_t key) const
+    {
+        if (_keys.empty() || !key)
+            return nullptr;
+
+        auto slot = Slot(key, _seeds[Mix(key) & _bucketMask]);
+
+        return _keys[slot] == key ? &_values[slot] : nullptr;
+    }
+
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+
+    //Slots over entries, for the log.
+    size_t capacity() const { return _keys.size(); }
+
+private:
+    static constexpr uint32_t k_maxSeed = 1 << 16;
+
+    static uint32_t Mix(uint32_t x)
+    {
+        x ^= x >> 16;
+        x *= 0x85EBCA6B;
+        x ^= x >> 13;
+        x *= 0xC2B2AE35;
+        x ^= x >> 16;
+        return x;
+    }
+
+    uint32_t Slot(uint32_t key, uint32_t seed) const
+    {
+        return Mix(key ^ (seed * 0x9E3779B9)) & _slotMask;
+    }
+
+
+    bool Build(const std::vector<std::pair<uint32_t, T>>& entries, size_t slots)
+    {
+        size_t buckets = std::bit_ceil(std::max<size_t>(entries.size() / 2, 1));
+
+        _slotMask = static_cast<uint32_t>(slots - 1);
+        _bucketMask = static_cast<uint32_t>(buckets - 1);
+
+        std::vector<std::vector<uint32_t>> members(buckets);
+
+        for (uint32_t i = 0; i < entries.size(); i++)
+            members[Mix(entries[i].first) & _bucketMask].push_back(i);
+
+        //Biggest buckets first, they're the hardest to place.
+        std::vector<uint32_t> order(buckets);
+
+        for (uint32_t i = 0; i < buckets; i++)
+            order[i] = i;
+
+        std::ranges::stable_sort(order, std::greater{}, [&](uint32_t b) { return members[b].size(); });
+
+        _seeds.assign(buckets, 0);
+
+        std::vector<bool> used(slots, false);
+
+        std::vector<uint32_t> placed;
+
+        for (auto bucket : order)
+        {
+            auto& keys = members[bucket];
+
+            if (keys.empty())
+                break;
+
+            uint32_t seed = 0;
+
+            for (; seed < k_maxSeed; seed++)
+            {
+                placed.clear();
+
+                for (auto index : keys)
+                {
+                    auto slot = Slot(entries[index].first, seed);
+
+                    if (used[slot] || std::ranges::find(placed, slot) != placed.end())
+                        break;
+
+                    placed.push_back(slot);
+                }
+
+                if (placed.size() == keys.size())
+                    break;
+            }
+
+            if (seed == k_maxSeed)
+                return false;
+
+            _seeds[bucket] = seed;
+
+            for (auto slot : placed)
+                used[slot] = true;
+        }
+
+        _keys.assign(slots, 0);
+        _values.assign(slots, T{});
+
+        for (auto& [key, value] : entries)
+        {
+            auto slot = Slot(key, _seeds[Mix(key) & _bucketMask]);
+            _keys[slot] = key;
+            _values[slot] = value;
+        }
+
+        _size = entries.size();
+
+        return true;
+    }
+
+
+    std::vector<uint32_t> _seeds;
+    std::vector<uint32_t> _keys;
+    std::vector<T> _values;
+
+    uint32_t _slotMask = 0;
+    uint32_t _bucketMask = 0;
+    size_t _size = 0;
+};
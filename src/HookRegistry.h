@@ -0,0 +1,328 @@
+#pragma once
+
+#include "Prologue.h"
+
+//A declarative take on the hooks. Each hook struct states the sites it patches in a static constexpr "sites" array, which lets
+// the trampoline size be summed at compile time instead of being a number I have to keep in my head. The writes themselves
+// are queued while patching and flushed by Commit, so every touched page has its protection changed exactly once.
+
+namespace Hooks
+{
+    enum struct HookKind : uint8_t
+    {
+        Vfunc,      //Replaces a vtable entry, doesn't use the trampoline.
+        Call,       //Rewrites a rel32 call, routed through a trampoline stub.
+        Branch,     //Rewrites the start of a function into a rel32 jump, routed through a trampoline stub.
+    };
+
+    //jmp [rip]; dq dst. Same as what SKSE's trampoline emits for write_call<5>/write_branch<5>.
+    constexpr size_t k_absoluteJumpSize = 0xE;
+
+    //Room for the relocated instructions of a detour, plus the jump back.
+    constexpr size_t k_prologueSize = 0x80;
+
+
+    struct HookSite
+    {
+        std::string_view name;
+        HookKind kind = HookKind::Vfunc;
+
+        REL::RelocationID id{};
+        REL::VariantOffset offset{};
+
+        REL::VariantID vtable{};
+        size_t index = 0;
+
+        size_t stubSize = 0;
+
+        uintptr_t address() const
+        {
+            if (kind == HookKind::Vfunc)
+                return vtable.address() + index * sizeof(uintptr_t);
+            else
+                return id.address() + offset.offset();
+        }
+    };
+
+
+    constexpr HookSite Call(std::string_view name, REL::RelocationID id, REL::VariantOffset offset = {})
+    {
+        return HookSite{ .name = name, .kind = HookKind::Call, .id = id, .offset = offset, .stubSize = k_absoluteJumpSize };
+    }
+
+    constexpr HookSite Branch(std::string_view name, REL::RelocationID id, REL::VariantOffset offset = {})
+    {
+        return HookSite{ .name = name, .kind = HookKind::Branch, .id = id, .offset = offset, .stubSize = k_absoluteJumpSize };
+    }
+
+    //A branch where the overwritten instructions get relocated into the trampoline, so the original stays callable.
+    constexpr HookSite Detour(std::string_view name, REL::RelocationID id, REL::VariantOffset offset = {})
+    {
+        return HookSite{ .name = name, .kind = HookKind::Branch, .id = id, .offset = offset, .stubSize = k_absoluteJumpSize + k_prologueSize };
+    }
+
+    constexpr HookSite Vfunc(std::string_view name, REL::VariantID vtable, size_t index)
+    {
+        return HookSite{ .name = name, .kind = HookKind::Vfunc, .vtable = vtable, .index = index };
+    }
+
+
+    template <size_t N>
+    constexpr size_t SiteBudget(const std::array<HookSite, N>& sites)
+    {
+        size_t result = 0;
+
+        for (auto& site : sites) {
+            if (site.kind != HookKind::Vfunc)
+                result += site.stubSize;
+        }
+
+        return result;
+    }
+
+
+
+    namespace detail
+    {
+        struct PendingWrite
+        {
+            std::string_view name;
+            uintptr_t address;
+            std::array<uint8_t, 0x20> bytes;
+            size_t size;
+        };
+
+        inline std::vector<PendingWrite> pending;
+
+
+        inline void Queue(const HookSite& site, uintptr_t address, const void* data, size_t size)
+        {
+            auto& write = pending.emplace_back(PendingWrite{ site.name, address, {}, size });
+            assert(size <= write.bytes.size());
+            std::memcpy(write.bytes.data(), data, size);
+        }
+
+
+        inline uintptr_t WriteRelative(const HookSite& site, uint8_t opcode, uintptr_t dst)
+        {
+            auto address = site.address();
+
+            //What ever was there before is what the function object gets to forward to. If someone else already placed a jump here,
+            // this is where it leads.
+            auto original = address + 5 + *reinterpret_cast<int32_t*>(address + 1);
+
+#pragma pack(push, 1)
+            struct AbsoluteJump
+            {
+                uint8_t jmp = 0xFF;
+                uint8_t modrm = 0x25;
+                int32_t disp = 0;
+                uint64_t dst;
+            };
+#pragma pack(pop)
+            static_assert(sizeof(AbsoluteJump) == k_absoluteJumpSize);
+
+            auto& trampoline = SKSE::GetTrampoline();
+
+            //Only the jump, a detour takes its prologue room itself before getting here.
+            auto stub = new (trampoline.allocate(k_absoluteJumpSize)) AbsoluteJump{ .dst = dst };
+
+            auto disp = reinterpret_cast<intptr_t>(stub) - static_cast<intptr_t>(address + 5);
+
+            if (disp < INT32_MIN || disp > INT32_MAX) {
+                SKSE::stl::report_and_fail(std::format("Trampoline stub for {} is out of rel32 range.", site.name));
+            }
+
+#pragma pack(push, 1)
+            struct RelativeJump
+            {
+                uint8_t opcode;
+                int32_t disp;
+            } code{ opcode, static_cast<int32_t>(disp) };
+#pragma pack(pop)
+            static_assert(sizeof(RelativeJump) == 5);
+
+            Queue(site, address, &code, sizeof(code));
+
+            return original;
+        }
+    }
+
+
+    inline uintptr_t write_call(const HookSite& site, uintptr_t dst)
+    {
+        assert(site.kind == HookKind::Call);
+        return detail::WriteRelative(site, 0xE8, dst);
+    }
+
+    template <class F>
+    inline uintptr_t write_call(const HookSite& site, F dst)
+    {
+        return write_call(site, reinterpret_cast<uintptr_t>(dst));
+    }
+
+
+    inline uintptr_t write_branch(const HookSite& site, uintptr_t dst)
+    {
+        assert(site.kind == HookKind::Branch);
+        return detail::WriteRelative(site, 0xE9, dst);
+    }
+
+    template <class F>
+    inline uintptr_t write_branch(const HookSite& site, F dst)
+    {
+        return write_branch(site, reinterpret_cast<uintptr_t>(dst));
+    }
+
+
+    //Branches to dst and returns a callable copy of the original function's start. Where write_branch would hand back the
+    // target of what ever jump it overwrote, this works on any prologue the decoder understands.
+    inline uintptr_t write_detour(const HookSite& site, uintptr_t dst)
+    {
+        assert(site.kind == HookKind::Branch && site.stubSize == k_absoluteJumpSize + k_prologueSize);
+
+        auto address = site.address();
+
+        auto& trampoline = SKSE::GetTrampoline();
+
+        auto buffer = reinterpret_cast<uintptr_t>(trampoline.allocate(k_prologueSize));
+
+        auto relocation = Prologue::Relocate(reinterpret_cast<const uint8_t*>(address), address, 5, buffer, k_prologueSize);
+
+        if (!relocation) {
+            SKSE::stl::report_and_fail(std::format("Unable to relocate the prologue of {} at {:X}.", site.name, address));
+        }
+
+        std::memcpy(reinterpret_cast<void*>(buffer), relocation->code.data(), relocation->code.size());
+
+        detail::WriteRelative(site, 0xE9, dst);
+
+        //Whatever's left of the last instruction that got cut into.
+        if (auto leftover = relocation->consumed - 5; leftover) {
+            std::array<uint8_t, 0x20> padding;
+            padding.fill(0xCC);
+            detail::Queue(site, address + 5, padding.data(), leftover);
+        }
+
+        return buffer;
+    }
+
+    template <class F>
+    inline uintptr_t write_detour(const HookSite& site, F dst)
+    {
+        return write_detour(site, reinterpret_cast<uintptr_t>(dst));
+    }
+
+
+    inline uintptr_t write_vfunc(const HookSite& site, uintptr_t dst)
+    {
+        assert(site.kind == HookKind::Vfunc);
+
+        auto address = site.address();
+        auto original = *reinterpret_cast<uintptr_t*>(address);
+
+        detail::Queue(site, address, &dst, sizeof(dst));
+
+        return original;
+    }
+
+    template <class F>
+    inline uintptr_t write_vfunc(const HookSite& site, F dst)
+    {
+        return write_vfunc(site, reinterpret_cast<uintptr_t>(dst));
+    }
+
+
+
+    //Flushes all queued writes. Pages are unprotected once each, written, then restored.
+    inline void Commit(std::string_view phase)
+    {
+        using namespace detail;
+
+        if (pending.empty())
+            return;
+
+        auto start = std::chrono::steady_clock::now();
+
+        constexpr uintptr_t k_pageSize = 0x1000;
+
+        std::vector<uintptr_t> pages;
+
+        for (auto& write : pending) {
+            for (auto page = write.address & ~(k_pageSize - 1); page < write.address + write.size; page += k_pageSize)
+                pages.push_back(page);
+        }
+
+        std::ranges::sort(pages);
+        pages.erase(std::unique(pages.begin(), pages.end()), pages.end());
+
+        std::vector<DWORD> old_protection(pages.size());
+
+        for (size_t i = 0; i < pages.size(); i++) {
+            if (!VirtualProtect(reinterpret_cast<void*>(pages[i]), k_pageSize, PAGE_EXECUTE_READWRITE, &old_protection[i])) {
+                SKSE::stl::report_and_fail(std::format("Unable to unprotect page {:X} for hook installation.", pages[i]));
+            }
+        }
+
+        for (auto& write : pending) {
+            std::memcpy(reinterpret_cast<void*>(write.address), write.bytes.data(), write.size);
+        }
+
+        for (size_t i = 0; i < pages.size(); i++) {
+            DWORD discard;
+            VirtualProtect(reinterpret_cast<void*>(pages[i]), k_pageSize, old_protection[i], &discard);
+        }
+
+        FlushInstructionCache(GetCurrentProcess(), nullptr, 0);
+
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+        logger::info("{} hooks committed: {} writes over {} pages in {}us.", phase, pending.size(), pages.size(), elapsed.count());
+
+        pending.clear();
+    }
+
+
+    //Times the hook's Patch and how much of the trampoline it took.
+    template <class H>
+    inline void Install()
+    {
+        auto& trampoline = SKSE::GetTrampoline();
+
+        auto used = trampoline.allocated_size();
+        auto start = std::chrono::steady_clock::now();
+
+        H::Patch();
+
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+        auto taken = trampoline.allocated_size() - used;
+
+        logger::info("{}: {} sites prepared in {}us, trampoline {}/{} bytes (budgeted {}).",
+            typeid(H).name(), H::sites.size(), elapsed.count(), taken, trampoline.capacity(), SiteBudget(H::sites));
+
+        if (taken > SiteBudget(H::sites))
+            logger::error("{} took {} bytes more of the trampoline than its sites budget for.", typeid(H).name(), taken - SiteBudget(H::sites));
+    }
+
+
+    //Hooks that go in together. The trampoline is sized from the same lists that get installed, so a hook can't be put in
+    // without being budgeted for.
+    template <class... Hs>
+    struct HookSet
+    {
+        static constexpr size_t budget = (SiteBudget(Hs::sites) + ... + 0);
+
+        static void Install()
+        {
+            (Hooks::Install<Hs>(), ...);
+        }
+    };
+
+    //The amount of trampoline space the given sets could ever need. Sites that are only patched on some runtimes still count.
+    template <class... Sets>
+    constexpr size_t TrampolineBudget()
+    {
+        return (Sets::budget + ... + 0);
+    }
+}
@@ -2,6 +2,24 @@
 #include "nlohmann/json.hpp"
 #include "PerkEntryPointExtenderAPI.h"
 
+#define CARP_SOURCE
+#include "ComprehensiveAttackRatePatch/ComprehensiveAttackRatePatchAPI.h"
+
+#include "HookRegistry.h"
+#include "Profiler.h"
+#include "ChangeQueue.h"
+#include "FormTable.h"
+#include "CurveExpression.h"
+#include "Spline.h"
+#include "SpeedCurve.h"
+#include "SpeedQuery.h"
+#include "Effectiveness.h"
+#include "EffectIndex.h"
+#include "TagAudit.h"
+#include "TagRegistry.h"
+#include "SpeedHooks.h"
+#include "EffectHooks.h"
+
 using namespace SKSE;
 using namespace SKSE::log;
 using namespace SKSE::stl;
@@ -79,32 +97,6 @@ namespace RE
 }
 
 
-int IsCallOrJump(uintptr_t addr)
-{
-    //0x15 0xE8//These are calls, represented by negative numbers
-    //0x25 0xE9//These are jumps, represented by positive numbers.
-    //And zero represent it being neither.
-
-    if (addr)
-    {
-        auto first_byte = reinterpret_cast<uint8_t*>(addr);
-
-        switch (*first_byte)
-        {
-        case 0x15:
-        case 0xE8:
-            return -1;
-
-        case 0x25:
-        case 0xE9:
-            return 1;
-
-        }
-    }
-
-    return 0;
-}
-
 //SE: 0x692390, AE: 0x6CC2B0, VR: ???
 REL::Relocation<void(RE::CachedValues*, RE::ActorValue)> InvalidateTotalCache{ REL::RelocationID(39159, 40225, 0) };
 //SE: (0x63E080), AE: (0x676820)
@@ -120,221 +112,1233 @@ RE::FloatSetting capSpeed{ "fHighWeaponSpeedCap", 2.f };
 RE::FloatSetting speedTaper{ "fWeaponSpeedTaper", 0.2f };
 RE::FloatSetting maxSpeed{ "fMaxWeaponSpeed", 3.f };
 
-//An undisclosed value that serves as the very limits to how slow an attack can be. Made to ensure that low values never mean normal attack speed.
-constexpr float k_closeToZero = 0.01f;
 //This value is used to ensure that whatever value the magnitude is able to go into
 RE::FloatSetting magnitudeComparison{ "fMagnitudeComparison", 10000.f };
 
+//Per weapon class speed, ordered the same as RE::WEAPON_TYPE.
+RE::FloatSetting weaponTypeSpeed[]
+{
+    { "fWeaponSpeedMultHandToHand", 1.f },
+    { "fWeaponSpeedMultOneHandSword", 1.f },
+    { "fWeaponSpeedMultOneHandDagger", 1.f },
+    { "fWeaponSpeedMultOneHandAxe", 1.f },
+    { "fWeaponSpeedMultOneHandMace", 1.f },
+    { "fWeaponSpeedMultTwoHandSword", 1.f },
+    { "fWeaponSpeedMultTwoHandAxe", 1.f },
+    { "fWeaponSpeedMultBow", 1.f },
+    { "fWeaponSpeedMultStaff", 1.f },
+    { "fWeaponSpeedMultCrossbow", 1.f },
+};
+static_assert(std::size(weaponTypeSpeed) == RE::WEAPON_TYPE::kTotal);
 
-static RE::TESObjectWEAP* fists = RE::TESForm::LookupByID<RE::TESObjectWEAP>(0x1F4);
+//Actors whose AI process is lower than this (0 high, 1 middle high, 2 middle low, 3 low) skip perks and reuse their last
+// result for a while instead of being worked out every time. 3 evaluates everyone in full.
+RE::FloatSetting tierFullProcess{ "fWeaponSpeedFullProcessLevel", 1.f };
+//In seconds, how long those actors keep a result.
+RE::FloatSetting tierRefresh{ "fWeaponSpeedTierRefresh", 1.f };
 
-RE::TESObjectWEAP* GetFists()
+//In microseconds, how long a frame the tag auditor gets to look over actors. 0 turns it off.
+RE::FloatSetting auditBudget{ "fWeaponSpeedAuditBudget", 50.f };
+
+
+//What the weapon speed hook multiplies by, indexed directly by animation type. It's the full range of the byte so a
+// modded weapon with a strange type still reads 1 instead of going out of bounds.
+std::array<float, 0x100> weaponTypeMult = [] { std::array<float, 0x100> result; result.fill(1.f); return result; }();
+
+
+//Either "Plugin.esp|0x800" (the id local to that plugin) or an editor id. Editor ids for most forms only exist if something
+// like po3's Tweaks is keeping them.
+RE::TESForm* LookupFormReference(const std::string& reference)
 {
-    static RE::TESObjectWEAP* a_fists = nullptr;
+    if (auto split = reference.find('|'); split != std::string::npos)
+    {
+        auto plugin = reference.substr(0, split);
+        auto local_id = static_cast<RE::FormID>(std::stoul(reference.substr(split + 1), nullptr, 16));
 
-    if (!a_fists)
-        a_fists = RE::TESForm::LookupByID<RE::TESObjectWEAP>(0x1F4);
-    
-    return a_fists;
+        return RE::TESDataHandler::GetSingleton()->LookupForm(local_id, plugin);
+    }
+
+    return RE::TESForm::LookupByEditorID(reference);
 }
 
-float GetEffectiveSpeed(RE::ActorValueOwner* target, bool right)
+
+//Calls back with every json in Data/SKSE/Plugins/ComprehensiveAttackRatePatch/, in file name order so later files win.
+template <class F>
+void ForEachConfig(F&& callback)
 {
-    //TODO: This is causing the issue. Unsure why, but investigate.
-    
-    RE::ActorValue speed_av = right ? RE::ActorValue::kWeaponSpeedMult : RE::ActorValue::kLeftWeaponSpeedMultiply;
+    std::filesystem::path directory{ "Data/SKSE/Plugins/ComprehensiveAttackRatePatch" };
 
-    float speed = target->GetActorValue(speed_av);
+    std::error_code error;
 
-    //if (right)
-    //    speed = target->GetActorValue(RE::ActorValue::kWeaponSpeedMult);
-    //else
-    //    speed = target->GetActorValue(RE::ActorValue::kLeftWeaponSpeedMultiply);
-    
-    //TODO:Check the performance of this, if by chance it makes things slow, I can curb it by only firing if someone is in a non-idle attack state.
-    if (RE::Actor* actor = skyrim_cast<RE::Actor*>(target); actor)
+    if (!std::filesystem::is_directory(directory, error))
+        return;
+
+    std::vector<std::filesystem::path> files;
+
+    for (auto& file : std::filesystem::directory_iterator{ directory, error }) {
+        if (file.is_regular_file() && file.path().extension() == ".json")
+            files.push_back(file.path());
+    }
+
+    std::ranges::sort(files);
+
+    for (auto& path : files)
     {
-        auto data = actor->GetEquippedEntryData(!right);
+        std::ifstream stream{ path };
 
-        if (actor->IsAttacking() == true)
+        try
         {
-            if (!data || data->object->formType == RE::FormType::Weapon)
-            {
-                auto old = speed;
-                RE::TESObjectWEAP* weapon = !data ? GetFists() : data->object->As<RE::TESObjectWEAP>();
-                RE::HandleEntryPoint(RE::PerkEntryPoint::kModBowZoom, actor, &speed, "AttackSpeed", 1, { weapon });
-                //For the upteenth time, the fucking convinence function fucks shit up.
-                //if (auto res = RE::HandleEntryPoint(RE::PerkEntryPoint::kModBowZoom, actor, speed, "AttackSpeed", 1, weapon); res != PEPE::RequestResult::Success)
-                //    logger::info("invalid {}", (int)res);
+            nlohmann::json json = nlohmann::json::parse(stream, nullptr, true, true);
+            callback(path.filename().string(), json);
+        }
+        catch (nlohmann::json::exception& error)
+        {
+            logger::error("{}: {}", path.filename().string(), error.what());
+        }
+    }
+}
+
+
+//What a profile's curve is made of when it isn't the built in taper. A spline wins if both are given.
+struct CurveShape
+{
+    std::optional<CurveExpression::Program> expression;
+    std::optional<Spline::Table> spline;
+
+    bool empty() const { return !expression && !spline; }
+};
+
+
+//A user written curve with one profile's settings baked in. Never freed once made, a hook on another thread could still be
+// running the old one right as it gets swapped out, but reused whenever the same shape gets the same settings again.
+struct CustomCurve
+{
+    //What it was made from.
+    const CurveShape* shape = nullptr;
+    std::array<float, 4> bound{};
+
+    std::optional<Spline::Table> spline;
+
+    CurveExpression::Program program;
+    std::unique_ptr<CurveExpression::Compiled> code;
+    CurveExpression::Function native = nullptr;
+
+    float operator()(const CurveExpression::Inputs& inputs) const
+    {
+        if (spline)
+            return spline->Evaluate(inputs[0]);
+
+        return native ? native(inputs.data()) : program.Run(inputs.data());
+    }
+};
+
+
+//The curve settings, set once per settings epoch.
+struct CurveParams : SpeedCurve::Params
+{
+    //Replaces the taper when set.
+    std::atomic<const CustomCurve*> custom = nullptr;
+};
+
+
+//Named curves that replace the global one for some actors. Which actors is worked out once on data loaded, per race and per
+// actor base, so picking a curve is at most two table lookups. Anything a profile leaves out follows the global setting.
+//{ "profiles": [ { "name": "Bosses", "maxSpeed": 2.0, "keywords": [ "ActorTypeDragon" ], "factions": [ "Skyrim.esm|0x..." ] } ] }
+// "curve" on a profile, or at the top of a file for the global one, replaces the taper with an expression (see CurveExpression.h).
+// Those are interpreted, "jitCurves": true compiles them to native code each time the settings change instead.
+// "spline": [ [0.5, 0.6], [1, 1], [2, 1.8], [3, 2.2] ] does the same with a smooth curve through the given speed -> effective
+// speed points, which unlike the taper can shape the slow end too.
+// Matching with "npcs", "factions" or "keywords" on the actor base wins over "races" or keywords on the race. "player": true claims the player.
+// The first profile to match something keeps it.
+struct CurveProfiles
+{
+    struct Profile
+    {
+        std::string name;
+
+        std::optional<float> minSpeed;
+        std::optional<float> capSpeed;
+        std::optional<float> speedTaper;
+        std::optional<float> maxSpeed;
+
+        CurveShape shape;
+    };
+
+    //0 is the global curve.
+    using Index = uint8_t;
+
+
+    static const CurveParams& Get(RE::Actor* actor)
+    {
+        Index index = 0;
+
+        if (actor)
+        {
+            if (actor->IsPlayerRef()) {
+                index = playerProfile;
+            }
+            else if (auto entry = FindNPC(actor)) {
+                index = *entry;
+            }
+            else if (auto race = actor->GetRace(); auto entry = raceProfiles.find(race ? race->GetFormID() : 0)) {
+                index = *entry;
             }
         }
+
+        return curves[index];
     }
 
-    float base_av = target->GetBaseActorValue(speed_av);
 
-    if (base_av == 0)
-        base_av = k_closeToZero;
+    //Leveled actors get a base made at runtime (0xFF...) that no rule was ever resolved for, so those fall back on the base
+    // they were leveled from, then on the one their face comes from. Either can be templated in turn, the first in the
+    // chain with a profile wins.
+    static const Index* FindNPC(RE::Actor* actor)
+    {
+        auto base = actor->GetActorBase();
+
+        if (!base)
+            return nullptr;
 
-    float max_speed = !maxSpeed.GetValue() ? std::numeric_limits<float>::infinity(): fmax(maxSpeed.GetValue(), 1.f);//If zero, no maximum
-    
-    //It's absolutely minimum value is a save value away from 0
-    // additionally, your minimum speed can never be higher than your base attack speed.
-    // this is allowed because no base game system ever messes with that, it's an active choice on the part of a developer or player. As such, let em.
-    float min_speed = std::clamp(minSpeed.GetValue(), k_closeToZero, base_av);//fmax(base_av, fmax(minSpeed.GetValue(), 0.01f));
-    float speed_taper = fmin(speedTaper.GetValue(), 1.f);//Not allowed to exceed 1. Gets fucky if it does.
-    float cap_speed = !capSpeed.GetValue() ? std::clamp(capSpeed.GetValue(), min_speed, max_speed) : 0;
-   
+        if (auto entry = npcProfiles.find(base->GetFormID()))
+            return entry;
+
+        if (!base->IsDynamicForm())
+            return nullptr;
 
-    float low_cap_speed = 0.75f;
+        for (auto npc : { actor->GetTemplateActorBase(), base->GetRootFaceNPC() })
+        {
+            for (size_t depth = 0; npc && depth < k_maxTemplateDepth; depth++)
+            {
+                if (auto entry = npcProfiles.find(npc->GetFormID()))
+                    return entry;
+
+                npc = npc->baseTemplateForm ? npc->baseTemplateForm->As<RE::TESNPC>() : nullptr;
+            }
+        }
+
+        return nullptr;
+    }
 
-    if (speed <= min_speed)
-        return min_speed;
+    //Just so a template loop in someone's plugin can't hang us.
+    static constexpr size_t k_maxTemplateDepth = 8;
 
 
-    //These can be the same function, just altered or something.
-    if (cap_speed)
+    //Called by the settings epoch, profiles that leave a setting out need to follow it.
+    static void Rebuild()
     {
-        if (speed > cap_speed)
+        while (curves.size() < profiles.size() + 1)
+            curves.emplace_back();
+
+        curves[0].Set(minSpeed.GetValue(), capSpeed.GetValue(), speedTaper.GetValue(), maxSpeed.GetValue());
+
+        Compile(curves[0], globalShape, "global");
+
+        for (size_t i = 0; i < profiles.size(); i++)
         {
-            if (speed_taper <= 0)
-                return cap_speed;
+            auto& profile = profiles[i];
+
+            curves[i + 1].Set(
+                profile.minSpeed.value_or(minSpeed.GetValue()),
+                profile.capSpeed.value_or(capSpeed.GetValue()),
+                profile.speedTaper.value_or(speedTaper.GetValue()),
+                profile.maxSpeed.value_or(maxSpeed.GetValue()));
+
+            Compile(curves[i + 1], profile.shape.empty() ? globalShape : profile.shape, profile.name);
+        }
+    }
+
+
+    static void Compile(CurveParams& curve, const CurveShape& shape, std::string_view name)
+    {
+        using CurveExpression::Var;
 
+        if (shape.empty()) {
+            curve.custom.store(nullptr, std::memory_order_release);
+            return;
+        }
 
-            float extra_speed = speed - cap_speed;
+        //Splines don't read the settings at all.
+        auto bound = shape.spline ? std::array<float, 4>{} : std::array{ curve.minSpeed, curve.capSpeed, curve.speedTaper, curve.maxSpeed };
 
-            float new_speed = cap_speed + sqrt(extra_speed) * pow(speed_taper, 1.0f / extra_speed);
+        //Most epochs change something else entirely, those get the same curve back instead of another copy.
+        auto existing = std::ranges::find_if(customCurves, [&](auto& custom) { return custom->shape == &shape && custom->bound == bound; });
 
-            speed = new_speed;
-            //speed = std::clamp(speed, minSpeed, capSpeed);
+        if (existing != customCurves.end()) {
+            curve.custom.store(existing->get(), std::memory_order_release);
+            return;
         }
-        else if constexpr (false)// speed < low_cap_speed)
+
+        auto custom = std::make_unique<CustomCurve>();
+
+        custom->shape = &shape;
+        custom->bound = bound;
+
+        if (shape.spline)
         {
-            //The space to work on 
-            float extra_speed = low_cap_speed - speed;
+            custom->spline = shape.spline;
 
+            curve.custom.store(custom.get(), std::memory_order_release);
+            customCurves.push_back(std::move(custom));
+            return;
+        }
 
-            float new_speed = low_cap_speed - sqrt(extra_speed) / pow(speed_taper, 1.0f / extra_speed);
+        custom->program = shape.expression->
+            Bind(Var::MinSpeed, curve.minSpeed).
+            Bind(Var::CapSpeed, curve.capSpeed).
+            Bind(Var::SpeedTaper, curve.speedTaper).
+            Bind(Var::MaxSpeed, curve.maxSpeed);
 
-            speed = new_speed;
+        if (jitCurves)
+        {
+            try
+            {
+                custom->code = std::make_unique<CurveExpression::Compiled>(custom->program);
+                custom->native = custom->code->get();
+            }
+            catch (std::exception& error)
+            {
+                logger::warn("Curve '{}' couldn't be compiled ({}), interpreting it instead.", name, error.what());
+                custom->code.reset();
+            }
         }
+
+        logger::debug("Curve '{}' built, {} instructions, {}.", name, custom->program.code().size(), custom->native ? "native" : "interpreted");
+
+        curve.custom.store(custom.get(), std::memory_order_release);
+        customCurves.push_back(std::move(custom));
     }
 
-    if (target->GetIsPlayerOwner() == true)
-        logger::debug("max:{}, min:{}, tap:{}, h_cap:{}, l_cap:{} = spd:{}", max_speed, min_speed, speed_taper, cap_speed, low_cap_speed, speed);
 
+    static void Load()
+    {
+        struct Rules
+        {
+            std::vector<RE::TESRace*> races;
+            std::vector<RE::BGSKeyword*> keywords;
+            std::vector<RE::TESFaction*> factions;
+            std::vector<RE::TESNPC*> npcs;
+        };
+
+        std::vector<Rules> rules;
 
-    if (speed >= max_speed)
-        return max_speed;
+        auto parse = [](const std::string& file, const nlohmann::json& json, CurveShape& shape) {
+            if (json.contains("curve")) {
+                auto program = CurveExpression::Program::Parse(json["curve"].get<std::string>());
 
+                if (program)
+                    shape.expression = std::move(*program);
+                else
+                    logger::error("{}: bad curve, {}.", file, program.error());
+            }
 
+            if (json.contains("spline")) {
+                auto table = Spline::Build(json["spline"].get<std::vector<std::pair<float, float>>>());
 
-    return speed;
-}
+                if (table)
+                    shape.spline = *table;
+                else
+                    logger::error("{}: bad spline, {}.", file, table.error());
+            }
+        };
 
+        ForEachConfig([&](const std::string& file, nlohmann::json& json)
+        {
+            if (json.contains("curve") || json.contains("spline"))
+                globalShape = {};
 
+            parse(file, json, globalShape);
 
-float GetEffectiveSpeedFromActor(RE::StaticFunctionTag*, RE::Actor* target, bool right) 
-{ 
-    if (!target) return 0.f; 
-    return GetEffectiveSpeed(target->AsActorValueOwner(), right); 
-}
+            if (json.contains("jitCurves"))
+                jitCurves = json["jitCurves"].get<bool>();
 
+            if (!json.contains("profiles"))
+                return;
 
+            for (auto& entry : json["profiles"])
+            {
+                if (profiles.size() == std::numeric_limits<Index>::max()) {
+                    logger::error("{}: too many curve profiles, the rest are ignored.", file);
+                    return;
+                }
 
-//I'm thinking of implementing 2 things. First, a cap, then a taper, then a max. Maybe something for min. Basically, the lower it gets the more it
-// creeps toward a max or min.
+                Profile& profile = profiles.emplace_back();
+                Rules& rule = rules.emplace_back();
 
-//write_call/write_branch
-struct WeaponSpeedMultHook
-{
-	static void Patch()
-	{
-        constexpr bool is_write_branch = true;
-        
-        if constexpr (is_write_branch)
+                profile.name = entry.value("name", std::format("{}[{}]", file, profiles.size()));
+
+                auto read = [&](const char* key) -> std::optional<float> {
+                    return entry.contains(key) ? std::optional{ entry[key].get<float>() } : std::nullopt;
+                };
+
+                profile.minSpeed = read("minSpeed");
+                profile.capSpeed = read("capSpeed");
+                profile.speedTaper = read("speedTaper");
+                profile.maxSpeed = read("maxSpeed");
+
+                parse(file, entry, profile.shape);
+
+                auto gather = [&]<class T>(const char* key, std::vector<T*>& out) {
+                    if (!entry.contains(key))
+                        return;
+
+                    for (auto& reference : entry[key]) {
+                        RE::TESForm* form = nullptr;
+
+                        try { form = LookupFormReference(reference.get<std::string>()); }
+                        catch (std::exception&) {}
+
+                        if (auto result = form ? form->As<T>() : nullptr)
+                            out.push_back(result);
+                        else
+                            logger::warn("{}: profile '{}' {} entry '{}' not found.", file, profile.name, key, reference.dump());
+                    }
+                };
+
+                gather("races", rule.races);
+                gather("keywords", rule.keywords);
+                gather("factions", rule.factions);
+                gather("npcs", rule.npcs);
+
+                if (entry.value("player", false) && !playerProfile)
+                    playerProfile = static_cast<Index>(profiles.size());
+            }
+        });
+
+        //The curves themselves get built by the settings epoch right after this.
+        if (profiles.empty())
+            return;
+
+        auto start = std::chrono::steady_clock::now();
+
+        auto data_handler = RE::TESDataHandler::GetSingleton();
+
+        std::vector<std::pair<uint32_t, Index>> race_entries;
+        std::vector<std::pair<uint32_t, Index>> npc_entries;
+
+        for (auto race : data_handler->GetFormArray<RE::TESRace>())
         {
-            //SE: (0x3BE440), AE: (0x3D7FB0), VR: ???
-            REL::Relocation<uintptr_t> WeaponSpeedHook{ REL::RelocationID(25851, 26417) };
-            
-            auto& trampoline = SKSE::GetTrampoline();
+            if (!race)
+                continue;
 
-            trampoline.write_branch<5>(WeaponSpeedHook.address(), thunk1);
+            for (size_t i = 0; i < rules.size(); i++)
+            {
+                auto& rule = rules[i];
+
+                bool match = std::ranges::find(rule.races, race) != rule.races.end() ||
+                    std::ranges::any_of(rule.keywords, [&](auto keyword) { return race->HasKeyword(keyword); });
+
+                if (match) {
+                    race_entries.emplace_back(race->GetFormID(), static_cast<Index>(i + 1));
+                    break;
+                }
+            }
         }
-        else
+
+        for (auto npc : data_handler->GetFormArray<RE::TESNPC>())
         {
-            //SE: 0x71B670, AE: 0x758510, VR: ???
-            REL::Relocation<uintptr_t> WeaponSpeedHook{ REL::RelocationID { 41694, 42779 }, 0x29 };
+            if (!npc)
+                continue;
 
-            auto& trampoline = SKSE::GetTrampoline();
+            for (size_t i = 0; i < rules.size(); i++)
+            {
+                auto& rule = rules[i];
 
-            func = trampoline.write_call<5>(WeaponSpeedHook.address(), thunk1);
+                bool match = std::ranges::find(rule.npcs, npc) != rule.npcs.end() ||
+                    std::ranges::any_of(rule.keywords, [&](auto keyword) { return npc->HasKeyword(keyword); }) ||
+                    std::ranges::any_of(npc->factions, [&](auto& rank) { return std::ranges::find(rule.factions, rank.faction) != rule.factions.end(); });
 
+                if (match) {
+                    npc_entries.emplace_back(npc->GetFormID(), static_cast<Index>(i + 1));
+                    break;
+                }
+            }
         }
 
-        
-		logger::info("WeaponSpeedMultHook complete...");
-	}
+        raceProfiles = FormTable<Index>{ std::move(race_entries) };
+        npcProfiles = FormTable<Index>{ std::move(npc_entries) };
 
-	//This hook is so ununique btw, that I think I can just write branch this shit. Straight up.
-	static float thunk(RE::ActorValueOwner* av_owner, RE::TESObjectWEAP* weap, bool is_left)
-	{
-		//SE: 0x2EFF868, AE: 0x2F99450
-		//static uintptr_t fists = REL::RelocationID(514923, 401061).address();
-        
-        //The above crashed for me because I'm a fucking moron, so it's this now.
-		static RE::TESObjectWEAP* fists = RE::TESForm::LookupByID<RE::TESObjectWEAP>(0x1F4);
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
 
-		if (!weap)
-			weap = fists;//reinterpret_cast<RE::TESObjectWEAP*>(fists);
+        logger::info("{} curve profiles, resolved for {} races and {} actor bases in {}us.", profiles.size(), raceProfiles.size(), npcProfiles.size(), elapsed.count());
+    }
 
-		return func(av_owner, weap, is_left);
-	}
 
-    
-    static float thunk1(RE::ActorValueOwner* av_owner, RE::TESObjectWEAP* weap, bool is_left)
-    {
-        static RE::TESObjectWEAP* fists = RE::TESForm::LookupByID<RE::TESObjectWEAP>(0x1F4);
+    static inline std::vector<Profile> profiles;
+    static inline std::deque<CurveParams> curves = std::deque<CurveParams>(1);
 
-        if (!weap)
-            weap = fists;//reinterpret_cast<RE::TESObjectWEAP*>(fists);
+    static inline CurveShape globalShape;
+    static inline bool jitCurves = false;
+    static inline std::vector<std::unique_ptr<CustomCurve>> customCurves;
 
-        float speed = GetEffectiveSpeed(av_owner, !is_left);
-        //RE::ActorValue speed_av = !is_left ? RE::ActorValue::kWeaponSpeedMult : RE::ActorValue::kLeftWeaponSpeedMultiply;
+    static inline FormTable<Index> raceProfiles;
+    static inline FormTable<Index> npcProfiles;
+    static inline Index playerProfile = 0;
+};
 
-        //float speed = av_owner->GetActorValue(speed_av);
 
+//Everything built from settings gets rebuilt here, and only when one of them has actually changed. Hot paths read what was built
+// instead of the settings, and the epoch is for anything caching on top of that to know when to throw it out.
+struct SettingsEpoch
+{
+    static uint32_t Get()
+    {
+        return epoch.load(std::memory_order_acquire);
+    }
 
+    static bool Changed(RE::FloatSetting& setting)
+    {
+        //prevValue is ours, the game only ever writes the current value.
+        if (setting.currValue == setting.prevValue)
+            return false;
 
-        bool two_handed = weap->weaponData.animationType.any
-        (
-            RE::WEAPON_TYPE::kCrossbow, 
-            RE::WEAPON_TYPE::kTwoHandAxe, 
-            RE::WEAPON_TYPE::kTwoHandSword
-        );
-        
-        static RE::Setting* two_handed_speed_mult = RE::GameSettingCollection::GetSingleton()->GetSetting("fWeaponTwoHandedAnimationSpeedMult");
+        setting.Update();
+        return true;
+    }
 
-        if (!two_handed_speed_mult){
-            two_handed_speed_mult = RE::GameSettingCollection::GetSingleton()->GetSetting("fWeaponTwoHandedAnimationSpeedMult");
-        }
-        
-        
+    static void RebuildWeaponTypes()
+    {
+        if (!twoHandedMult)
+            twoHandedMult = RE::GameSettingCollection::GetSingleton()->GetSetting("fWeaponTwoHandedAnimationSpeedMult");
+
+        twoHandedValue = twoHandedMult ? twoHandedMult->GetFloat() : 1.f;
+
+        for (size_t i = 0; i < std::size(weaponTypeSpeed); i++)
         {
-            switch (*weap->weaponData.animationType)
+            float mult = weaponTypeSpeed[i].currValue;
+
+            switch (static_cast<RE::WEAPON_TYPE>(i))
             {
             case RE::WEAPON_TYPE::kCrossbow:
             case RE::WEAPON_TYPE::kTwoHandAxe:
             case RE::WEAPON_TYPE::kTwoHandSword:
-                float mult = two_handed_speed_mult->GetFloat();
-                //logger::info("2handMult {}", mult);
-                speed *= mult;
+                mult *= twoHandedValue;
+                break;
             }
+
+            weaponTypeMult[i] = mult;
         }
-        
-        speed *= weap->weaponData.speed;
+    }
+
+    //Called once a frame, and once on data loaded with force so there's something built before anyone swings.
+    static void Refresh(bool force = false)
+    {
+        bool changed = force;
+
+        changed |= Changed(minSpeed);
+        changed |= Changed(capSpeed);
+        changed |= Changed(speedTaper);
+        changed |= Changed(maxSpeed);
+        changed |= Changed(magnitudeComparison);
+
+        for (auto& setting : weaponTypeSpeed)
+            changed |= Changed(setting);
+
+        changed |= Changed(tierFullProcess);
+        changed |= Changed(tierRefresh);
+
+        if (twoHandedMult && twoHandedMult->GetFloat() != twoHandedValue)
+            changed = true;
+
+        if (!changed)
+            return;
+
+        RebuildWeaponTypes();
+
+        minMagnitude = Effectiveness::MinMagnitude(magnitudeComparison.GetValue());
+
+        CurveProfiles::Rebuild();
+
+        epoch.fetch_add(1, std::memory_order_release);
+
+        logger::debug("Settings epoch {}", Get());
+    }
+
+    static inline std::atomic<uint32_t> epoch = 0;
+
+    static inline RE::Setting* twoHandedMult = nullptr;
+    static inline float twoHandedValue = 1.f;
+
+    static inline float minMagnitude = 0.f;
+};
+
+
+static RE::TESObjectWEAP* fists = RE::TESForm::LookupByID<RE::TESObjectWEAP>(0x1F4);
+
+RE::TESObjectWEAP* GetFists()
+{
+    static RE::TESObjectWEAP* a_fists = nullptr;
+
+    if (!a_fists)
+        a_fists = RE::TESForm::LookupByID<RE::TESObjectWEAP>(0x1F4);
+    
+    return a_fists;
+}
+
+//Everything after the speed's been gathered, just numbers from here on.
+float ApplyCurve(const CurveParams& curve, float speed, float base_av, bool is_player)
+{
+    float result = 0;
+
+    if (auto custom = curve.custom.load(std::memory_order_acquire))
+        result = SpeedCurve::Apply(curve, speed, base_av, *custom);
+    else
+        result = SpeedCurve::Apply(curve, speed, base_av);
+
+    if (is_player)
+        logger::debug("max:{}, min:{}, tap:{}, h_cap:{}, base:{} spd:{} = {}",
+            curve.maxSpeed, curve.minSpeed, curve.speedTaper, curve.capSpeed, base_av, speed, result);
+
+    return result;
+}
 
 
-        return speed;
+//The game's side of SpeedHooks.h and EffectHooks.h, what the hook bodies in there read and write. The effect half needs
+// things further down, so it's filled in next to the effect hooks.
+struct GameAccess
+{
+    using Owner = RE::ActorValueOwner;
+    using Actor = RE::Actor;
+    using Weapon = RE::TESObjectWEAP;
+    using Effect = RE::ValueModifierEffect;
+
+    static constexpr RE::ActorValue SpeedAV(bool right)
+    {
+        return right ? RE::ActorValue::kWeaponSpeedMult : RE::ActorValue::kLeftWeaponSpeedMultiply;
+    }
+
+
+    //SpeedHooks.h
+    static RE::Actor* AsActor(RE::ActorValueOwner* owner) { return skyrim_cast<RE::Actor*>(owner); }
+    static float GetActorValue(RE::ActorValueOwner* owner, bool right) { return owner->GetActorValue(SpeedAV(right)); }
+    static float GetBaseActorValue(RE::ActorValueOwner* owner, bool right) { return owner->GetBaseActorValue(SpeedAV(right)); }
+    static bool IsPlayer(RE::ActorValueOwner* owner) { return owner->GetIsPlayerOwner(); }
+
+    static RE::FormID FormID(RE::Actor* actor) { return actor->GetFormID(); }
+    static RE::Actor* Lookup(RE::FormID id) { return RE::TESForm::LookupByID<RE::Actor>(id); }
+    static bool IsAttacking(RE::Actor* actor) { return actor->IsAttacking(); }
+
+    static bool IsDrawing(RE::Actor* actor)
+    {
+        auto state = actor->AsActorState()->GetAttackState();
+        return state == RE::ATTACK_STATE_ENUM::kDraw || state == RE::ATTACK_STATE_ENUM::kBowDraw;
+    }
+
+    static void AttackSpeedPerk(RE::Actor* actor, bool right, float& speed)
+    {
+        auto data = actor->GetEquippedEntryData(!right);
+
+        if (!data || data->object->formType == RE::FormType::Weapon)
+        {
+            RE::TESObjectWEAP* weapon = !data ? GetFists() : data->object->As<RE::TESObjectWEAP>();
+            RE::HandleEntryPoint(RE::PerkEntryPoint::kModBowZoom, actor, &speed, "AttackSpeed", 1, { weapon });
+            //For the upteenth time, the fucking convinence function fucks shit up.
+            //if (auto res = RE::HandleEntryPoint(RE::PerkEntryPoint::kModBowZoom, actor, speed, "AttackSpeed", 1, weapon); res != PEPE::RequestResult::Success)
+            //    logger::info("invalid {}", (int)res);
+        }
+    }
+
+    static const CurveParams& Curve(RE::Actor* actor) { return CurveProfiles::Get(actor); }
+
+    static float ApplyCurve(const CurveParams& curve, float speed, float base_av, bool is_player)
+    {
+        return ::ApplyCurve(curve, speed, base_av, is_player);
+    }
+
+    static std::optional<int32_t> ProcessLevel(RE::Actor* actor)
+    {
+        auto process = actor->GetActorRuntimeData().currentProcess;
+
+        if (!process)
+            return std::nullopt;
+
+        return static_cast<int32_t>(process->processLevel.underlying());
+    }
+
+    static float TierFullProcess() { return tierFullProcess.GetValue(); }
+    static float TierRefresh() { return tierRefresh.GetValue(); }
+
+    static bool DualWielding(RE::Actor* actor)
+    {
+        auto one_handed = [](RE::TESForm* object) {
+            if (!object)
+                return true;
+
+            auto weapon = object->As<RE::TESObjectWEAP>();
+            return weapon && *weapon->weaponData.animationType <= RE::WEAPON_TYPE::kOneHandMace;
+        };
+
+        return one_handed(actor->GetEquippedObject(false)) && one_handed(actor->GetEquippedObject(true));
+    }
+
+    //Already has fWeaponTwoHandedAnimationSpeedMult folded in for the two handers, see SettingsEpoch.
+    static float WeaponTypeMult(RE::TESObjectWEAP* weapon) { return weaponTypeMult[weapon->weaponData.animationType.underlying()]; }
+    static float WeaponSpeed(RE::TESObjectWEAP* weapon);
+
+
+    //EffectHooks.h
+    static RE::Actor* Target(RE::ValueModifierEffect* effect);
+    static std::optional<bool> Hand(RE::ValueModifierEffect* effect);
+    static std::optional<bool> SecondaryHand(RE::ValueModifierEffect* effect);
+    static float DualWeight(RE::ValueModifierEffect* effect);
+    static bool Recovers(RE::ValueModifierEffect* effect);
+    static bool Detrimental(RE::ValueModifierEffect* effect);
+    static bool Dispelled(RE::ValueModifierEffect* effect);
+    static float Magnitude(RE::ValueModifierEffect* effect);
+    static float Value(RE::ValueModifierEffect* effect);
+    static bool Applied(RE::ValueModifierEffect* effect);
+    static bool ConditionsHold(RE::ValueModifierEffect* effect);
+    static uint16_t& Mark(RE::ValueModifierEffect* effect);
+    static float& Tag(RE::Actor* actor, bool right);
+    static void Sync(RE::Actor* actor);
+    static bool SpeedRelevant(RE::ValueModifierEffect* effect);
+    static void BeforeSpeedChange(RE::Actor* actor);
+
+    template <class F>
+    static bool ForEachValueEffect(RE::Actor* actor, F&& callback);
+};
+
+
+using AttackPins = SpeedHooks::AttackPins<GameAccess>;
+using FusedSpeedCache = SpeedHooks::FusedSpeedCache<GameAccess>;
+
+struct EvaluationTiers : SpeedHooks::EvaluationTiers<GameAccess>
+{
+    static void Report()
+    {
+        auto full_count = full.load(std::memory_order_relaxed);
+        auto cached_count = cached.load(std::memory_order_relaxed);
+        auto refreshed_count = refreshed.load(std::memory_order_relaxed);
+
+        logger::info("Speed evaluations: {} full, {} tiered ({} cached, {} refreshed without perks).",
+            full_count, cached_count + refreshed_count, cached_count, refreshed_count);
+    }
+};
+
+
+float GetEffectiveSpeed(RE::ActorValueOwner* target, bool right)
+{
+    return SpeedHooks::GetEffectiveSpeed<GameAccess>(target, right);
+}
+
+std::array<float, 2> GetBothEffectiveSpeeds(RE::ActorValueOwner* target, bool perks = true)
+{
+    return SpeedHooks::GetBothEffectiveSpeeds<GameAccess>(target, perks);
+}
+
+
+
+float GetEffectiveSpeedFromActor(RE::StaticFunctionTag*, RE::Actor* target, bool right) 
+{ 
+    if (!target) return 0.f; 
+    return GetEffectiveSpeed(target->AsActorValueOwner(), right); 
+}
+
+
+using enum AttackRatePatchAPI::HandMask;
+
+static_assert(kRightHand == SpeedQuery::k_rightHand && kLeftHand == SpeedQuery::k_leftHand);
+
+//Each actor gets an entry per requested hand (right then left), null actors get 0 like the single version. out has to have
+// room for all of it, nothing here allocates.
+void GetEffectiveSpeeds(std::span<RE::Actor* const> targets, int32_t hand_mask, float* out)
+{
+    SpeedQuery::Fill(targets, hand_mask, out,
+        [](RE::Actor* target) { return GetBothEffectiveSpeeds(target->AsActorValueOwner()); },
+        [](RE::Actor* target, bool right) { return GetEffectiveSpeed(target->AsActorValueOwner(), right); });
+}
+
+//One VM call for a whole list of actors. The result is sized once up front.
+std::vector<float> GetEffectiveSpeedsFromActors(RE::StaticFunctionTag*, std::vector<RE::Actor*> targets, int32_t hand_mask)
+{
+    hand_mask &= kBothHands;
+
+    std::vector<float> result(targets.size() * SpeedQuery::Stride(hand_mask));
+
+    GetEffectiveSpeeds(targets, hand_mask, result.data());
+
+    return result;
+}
+
+std::vector<float> GetBothEffectiveSpeedsFromActors(RE::StaticFunctionTag* tag, std::vector<RE::Actor*> targets)
+{
+    return GetEffectiveSpeedsFromActors(tag, std::move(targets), kBothHands);
+}
+
+
+
+//Lets scripts get told when an actor's effective speed crosses a threshold (or moves far enough) instead of polling
+// GetEffectiveWeaponSpeed on a timer, and other plugins get the same through native listeners. Actors get marked just before
+// their speed changes, with what the speed was, and what ever got marked is evaluated once at the end of the frame, so 5
+// effects landing on the same actor in a frame still only cost one evaluation. The marking side is lock free, it happens on
+// what ever thread applies the effect.
+struct SpeedChangeEvents
+{
+    static constexpr const char* eventName = "OnEffectiveWeaponSpeedChange";
+
+    struct Subscription
+    {
+        RE::VMHandle receiver;
+        RE::FormID actor;//Zero is every actor.
+        float minDelta;
+        std::vector<float> thresholds;
+
+        //What this receiver was last told where that's not where the actor is now, a change too small to report yet. Anyone
+        // not in here gets compared against the speed from before the change.
+        std::unordered_map<RE::FormID, std::array<float, 2>> reported;
+    };
+
+    struct Dirty
+    {
+        RE::ActorHandle handle;
+        std::array<float, 2> old;
+    };
+
+    struct Listener
+    {
+        AttackRatePatchAPI::SpeedChangeCallback callback;
+        void* user;
+
+        bool operator==(const Listener&) const = default;
+    };
+
+
+    //Has to be called before the change goes in, what the speed is now is what it's changing from. Equips are the exception,
+    // the event only comes after, so those are only seen against what a receiver was last told.
+    static void MarkDirty(RE::Actor* actor)
+    {
+        FusedSpeedCache::Invalidate();
+
+        if (!actor || !active.load(std::memory_order_relaxed))
+            return;
+
+        if (!dirty.push({ actor->GetHandle(), GetBothEffectiveSpeeds(actor->AsActorValueOwner()) })) {
+            overflowed.store(true, std::memory_order_relaxed);
+        }
+    }
+
+
+    static bool ShouldReport(const Subscription& sub, float old, float now)
+    {
+        if (old == now)
+            return false;
+
+        if (sub.minDelta > 0 && fabs(now - old) >= sub.minDelta)
+            return true;
+
+        for (auto threshold : sub.thresholds) {
+            if ((old < threshold) != (now < threshold))
+                return true;
+        }
+
+        //Asked for neither, so any change counts.
+        return sub.minDelta <= 0 && sub.thresholds.empty();
+    }
+
+
+    //Called once a frame on the main thread.
+    static void Flush()
+    {
+        if (!active.load(std::memory_order_relaxed))
+            return;
+
+        //Kept around between frames so a normal frame doesn't allocate.
+        static std::vector<Dirty> batch;
+        static std::vector<AttackRatePatchAPI::SpeedChange> changes;
+        static std::vector<Listener> notify;
+
+        batch.clear();
+        changes.clear();
+        notify.clear();
+
+        for (Dirty entry; dirty.pop(entry);)
+            batch.push_back(entry);
+
+        if (overflowed.exchange(false, std::memory_order_relaxed)) {
+            logger::warn("More than {} speed changes in a frame, some weren't reported.", k_dirtyCapacity);
+        }
+
+        if (batch.empty())
+            return;
+
+        //Stable so the first mark of the frame is the one kept, that's the speed from before all of it.
+        auto native = [](const Dirty& entry) { return entry.handle.native_handle(); };
+
+        std::ranges::stable_sort(batch, {}, native);
+        batch.erase(std::unique(batch.begin(), batch.end(), [&](auto& a, auto& b) { return native(a) == native(b); }), batch.end());
+
+        auto vm = RE::BSScript::Internal::VirtualMachine::GetSingleton();
+
+        static const RE::BSFixedString event{ eventName };
+
+        std::unique_lock guard{ lock };
+
+        for (auto& entry : batch)
+        {
+            auto actor = entry.handle.get();
+
+            if (!actor)
+                continue;
+
+            auto owner = actor->AsActorValueOwner();
+
+            const std::array<float, 2> speed = GetBothEffectiveSpeeds(owner);
+
+            if (!listeners.empty())
+            {
+                for (int hand = 0; hand < 2; hand++)
+                {
+                    if (entry.old[hand] != speed[hand])
+                        changes.push_back({ actor.get(), hand == 0, entry.old[hand], speed[hand] });
+                }
+            }
+
+            for (auto& sub : subscriptions)
+            {
+                if (sub.actor && sub.actor != actor->formID)
+                    continue;
+
+                auto it = sub.reported.try_emplace(actor->formID, entry.old).first;
+
+                for (int hand = 0; hand < 2; hand++)
+                {
+                    float old = it->second[hand];
+
+                    if (!ShouldReport(sub, old, speed[hand]))
+                        continue;
+
+                    it->second[hand] = speed[hand];
+
+                    auto args = RE::MakeFunctionArguments(static_cast<RE::Actor*>(actor.get()), hand == 0, float{ old }, float{ speed[hand] });
+                    vm->SendEvent(sub.receiver, event, args);
+                }
+
+                //Caught up, the next mark will carry the same speed. Keeps this to actors with something left unreported.
+                if (it->second == speed)
+                    sub.reported.erase(it);
+            }
+        }
+
+        if (!changes.empty())
+            notify = listeners;
+
+        guard.unlock();
+
+        //One call per listener with every change, no matter how many actors there are. Made with the lock released so a
+        // listener can add or remove listeners from inside its callback. One that was removed since the copy is skipped,
+        // its user data might be gone.
+        for (auto& listener : notify)
+        {
+            if (!HasListener(listener))
+                continue;
+
+            listener.callback(changes.data(), changes.size(), listener.user);
+        }
+    }
+
+
+    static bool Register(RE::TESForm* receiver, RE::Actor* target, float min_delta, std::vector<float> thresholds)
+    {
+        if (!receiver)
+            return false;
+
+        auto vm = RE::BSScript::Internal::VirtualMachine::GetSingleton();
+        auto policy = vm->GetObjectHandlePolicy();
+
+        auto handle = policy->GetHandleForObject(static_cast<RE::VMTypeID>(receiver->GetFormType()), receiver);
+
+        if (handle == policy->EmptyHandle())
+            return false;
+
+        RE::FormID actor_id = target ? target->formID : 0;
+
+        std::lock_guard guard{ lock };
+
+        auto it = std::ranges::find_if(subscriptions, [&](auto& sub) { return sub.receiver == handle && sub.actor == actor_id; });
+
+        if (it == subscriptions.end()) {
+            policy->PersistHandle(handle);
+            it = subscriptions.insert(it, Subscription{ handle, actor_id });
+        }
+
+        it->minDelta = min_delta;
+        it->thresholds = std::move(thresholds);
+        it->reported.clear();
+
+        UpdateActive();
+
+        return true;
+    }
+
+
+    static bool Unregister(RE::TESForm* receiver, RE::Actor* target)
+    {
+        if (!receiver)
+            return false;
+
+        auto vm = RE::BSScript::Internal::VirtualMachine::GetSingleton();
+        auto policy = vm->GetObjectHandlePolicy();
+
+        auto handle = policy->GetHandleForObject(static_cast<RE::VMTypeID>(receiver->GetFormType()), receiver);
+
+        RE::FormID actor_id = target ? target->formID : 0;
+
+        std::lock_guard guard{ lock };
+
+        auto removed = std::erase_if(subscriptions, [&](auto& sub) { return sub.receiver == handle && sub.actor == actor_id; });
+
+        if (removed)
+            policy->ReleaseHandle(handle);
+
+        UpdateActive();
+
+        return removed;
+    }
+
+
+    static bool AddListener(Listener listener)
+    {
+        if (!listener.callback)
+            return false;
+
+        std::lock_guard guard{ lock };
+
+        if (std::ranges::find(listeners, listener) != listeners.end())
+            return false;
+
+        listeners.push_back(listener);
+
+        UpdateActive();
+
+        return true;
+    }
+
+    static bool HasListener(const Listener& listener)
+    {
+        std::lock_guard guard{ lock };
+
+        return std::ranges::find(listeners, listener) != listeners.end();
+    }
+
+    static bool RemoveListener(Listener listener)
+    {
+        std::lock_guard guard{ lock };
+
+        auto removed = std::erase(listeners, listener);
+
+        UpdateActive();
+
+        return removed;
+    }
+
+
+    //Registrations aren't saved, scripts are expected to register again in OnPlayerLoadGame. Native listeners stay.
+    static void Clear()
+    {
+        auto vm = RE::BSScript::Internal::VirtualMachine::GetSingleton();
+        auto policy = vm ? vm->GetObjectHandlePolicy() : nullptr;
+
+        std::lock_guard guard{ lock };
+
+        if (policy) {
+            for (auto& sub : subscriptions)
+                policy->ReleaseHandle(sub.receiver);
+        }
+
+        subscriptions.clear();
+
+        UpdateActive();
+    }
+
+
+    static void UpdateActive()
+    {
+        active = !subscriptions.empty() || !listeners.empty();
+    }
+
+
+    static constexpr size_t k_dirtyCapacity = 0x1000;
+
+    static inline std::atomic<bool> active = false;
+    static inline std::atomic<bool> overflowed = false;
+
+    static inline ChangeQueue<Dirty, k_dirtyCapacity> dirty;
+
+    //Guards everything below, only ever contended by registration.
+    static inline std::mutex lock;
+
+    static inline std::vector<Subscription> subscriptions;
+
+    static inline std::vector<Listener> listeners;
+};
+
+
+bool RegisterForEffectiveSpeedChange(RE::StaticFunctionTag*, RE::TESForm* receiver, RE::Actor* target, float min_delta, std::vector<float> thresholds)
+{
+    return SpeedChangeEvents::Register(receiver, target, min_delta, std::move(thresholds));
+}
+
+bool UnregisterForEffectiveSpeedChange(RE::StaticFunctionTag*, RE::TESForm* receiver, RE::Actor* target)
+{
+    return SpeedChangeEvents::Unregister(receiver, target);
+}
+
+
+struct EquipEventHandler : public RE::BSTEventSink<RE::TESEquipEvent>
+{
+    RE::BSEventNotifyControl ProcessEvent(const RE::TESEquipEvent* a_event, RE::BSTEventSource<RE::TESEquipEvent>*) override
+    {
+        if (a_event && a_event->actor)
+            SpeedChangeEvents::MarkDirty(a_event->actor->As<RE::Actor>());
+
+        return RE::BSEventNotifyControl::kContinue;
+    }
+
+    static EquipEventHandler* GetSingleton()
+    {
+        static EquipEventHandler singleton;
+        return &singleton;
+    }
+};
+
+
+
+//Per weapon speed overrides, read from the configs on data loaded.
+//{ "weapons": [ { "form": "Skyrim.esm|0x1C4E6", "speed": 1.1 }, { "form": "DA08EbonyBlade", "mult": 0.9 } ] }
+struct WeaponOverrides
+{
+    struct Entry
+    {
+        float speed = -1.f;   //Replaces the record's speed when set.
+        float mult = 1.f;
+
+        float Apply(float base) const
+        {
+            return (speed >= 0.f ? speed : base) * mult;
+        }
+    };
+
+
+    static void Load()
+    {
+        std::vector<std::pair<uint32_t, Entry>> entries;
+
+        ForEachConfig([&](const std::string& file, nlohmann::json& json)
+        {
+            if (!json.contains("weapons"))
+                return;
+
+            for (auto& weapon : json["weapons"])
+            {
+                //One bad entry shouldn't take the rest of the file down with it.
+                if (!weapon.contains("form") || !weapon["form"].is_string()) {
+                    logger::warn("{}: weapon entry {} has no form, skipping.", file, weapon.dump());
+                    continue;
+                }
+
+                auto reference = weapon["form"].get<std::string>();
+
+                RE::TESForm* form = nullptr;
+
+                try { form = LookupFormReference(reference); }
+                catch (std::exception&) {}
+
+                if (!form || !form->Is(RE::FormType::Weapon)) {
+                    logger::warn("{}: '{}' is not a weapon, skipping.", file, reference);
+                    continue;
+                }
+
+                Entry entry;
+
+                entry.speed = weapon.value("speed", -1.f);
+                entry.mult = weapon.value("mult", 1.f);
+
+                entries.emplace_back(form->GetFormID(), entry);
+            }
+        });
+
+        auto start = std::chrono::steady_clock::now();
+
+        table = FormTable<Entry>{ std::move(entries) };
+
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+        logger::info("{} weapon overrides loaded, {} slots built in {}us.", table.size(), table.capacity(), elapsed.count());
+    }
+
+    static inline FormTable<Entry> table;
+};
+
+
+
+float GameAccess::WeaponSpeed(RE::TESObjectWEAP* weapon)
+{
+    float base = weapon->weaponData.speed;
+
+    if (auto entry = WeaponOverrides::table.find(weapon->GetFormID()))
+        base = entry->Apply(base);
+
+    return base;
+}
+
+
+//I'm thinking of implementing 2 things. First, a cap, then a taper, then a max. Maybe something for min. Basically, the lower it gets the more it
+// creeps toward a max or min.
+
+//write_call/write_branch
+struct WeaponSpeedMultHook
+{
+    static constexpr bool is_write_branch = true;
+
+    static constexpr std::array sites
+    {
+        is_write_branch ?
+            //SE: (0x3BE440), AE: (0x3D7FB0), VR: ???
+            Hooks::Branch("WeaponSpeedMult", REL::RelocationID(25851, 26417)) :
+            //SE: 0x71B670, AE: 0x758510, VR: ???
+            Hooks::Call("WeaponSpeedMult", REL::RelocationID(41694, 42779), REL::VariantOffset(0x29, 0x29, 0))
+    };
+
+	static void Patch()
+	{
+        if constexpr (is_write_branch)
+        {
+            Hooks::write_branch(sites[0], thunk1);
+        }
+        else
+        {
+            func = Hooks::write_call(sites[0], thunk1);
+        }
+
+        
+		logger::info("WeaponSpeedMultHook complete...");
+	}
+
+	//This hook is so ununique btw, that I think I can just write branch this shit. Straight up.
+	static float thunk(RE::ActorValueOwner* av_owner, RE::TESObjectWEAP* weap, bool is_left)
+	{
+		//SE: 0x2EFF868, AE: 0x2F99450
+		//static uintptr_t fists = REL::RelocationID(514923, 401061).address();
+        
+        //The above crashed for me because I'm a fucking moron, so it's this now.
+		static RE::TESObjectWEAP* fists = RE::TESForm::LookupByID<RE::TESObjectWEAP>(0x1F4);
+
+		if (!weap)
+			weap = fists;//reinterpret_cast<RE::TESObjectWEAP*>(fists);
+
+		return func(av_owner, weap, is_left);
+	}
+
+    
+    static float thunk1(RE::ActorValueOwner* av_owner, RE::TESObjectWEAP* weap, bool is_left)
+    {
+        CARP_PROFILE_SCOPE("WeaponSpeedMultHook");
+
+        static RE::TESObjectWEAP* fists = RE::TESForm::LookupByID<RE::TESObjectWEAP>(0x1F4);
+
+        if (!weap)
+            weap = fists;//reinterpret_cast<RE::TESObjectWEAP*>(fists);
+
+        return SpeedHooks::WeaponSpeedMult<GameAccess>(av_owner, weap, is_left);
     }
 
 
@@ -361,16 +1365,18 @@ struct CreateActorValueInfoHook
 {
     using DefaultValueFunc = float(uint64_t, RE::ActorValue);
 
-    static void Patch()
+    //I'm going to make this into a rewrite function.
+    //SE: (0x3E1790), AE: (0x3FC8E0), VR: ???
+    static constexpr std::array sites
     {
-        //I'm going to make this into a rewrite function.
-        //SE: (0x3E1790), AE: (0x3FC8E0), VR: ???
-        REL::Relocation<uintptr_t> InitAVI{ REL::RelocationID{ 26574, 27232 } };
-
-        auto& trampoline = SKSE::GetTrampoline();
+        Hooks::Call("InitAVI+0xE7F", REL::RelocationID(26574, 27232), REL::VariantOffset(0xE7F, 0xE7F, 0)),
+        Hooks::Call("InitAVI+0xEAA", REL::RelocationID(26574, 27232), REL::VariantOffset(0xEAA, 0xEAA, 0)),
+    };
 
-        func[0] = trampoline.write_call<5>(InitAVI.address() + 0xE7F, thunk<0>);
-        func[1] = trampoline.write_call<5>(InitAVI.address() + 0xEAA, thunk<1>);
+    static void Patch()
+    {
+        func[0] = Hooks::write_call(sites[0], thunk<0>);
+        func[1] = Hooks::write_call(sites[1], thunk<1>);
 
         logger::info("CreateActorValueInfo complete...");
     }
@@ -411,38 +1417,71 @@ SpeedTag& GetActorTag(RE::Actor* target, bool right)
         return reinterpret_cast<SpeedTag&>(target->GetActorRuntimeData().pad1EC);
 }
 
-//inline uint32_t& GetActorTag(RE::Actor* target, RE::ActorValue av)
-//{
-//    return GetActorTag(target, av == RE::ActorValue::kWeaponSpeedMult);
-//}
 
-constexpr bool k_right = true;
-constexpr bool k_left = false;
+//The actors that have a tag on either hand right now, so anything that wants to go over them doesn't have to go over
+// everyone. Kept up to date wherever the tags change, and actors leave it when they're destroyed.
+struct TaggedActors
+{
+    //Call after changing either of the actor's tags. Anything an effect is landing on is loaded and should have a handle
+    // already, this only makes one for a reference that has none.
+    static void Sync(RE::Actor* actor)
+    {
+        float right = GetActorTag(actor, true);
+        float left = GetActorTag(actor, false);
 
+        auto handle = actor->GetHandle();
 
-int HandleActorTag(RE::ValueModifierEffect* a_this, bool is_on, float value)
-{
-    if (!value)
-        return 0;
+        std::lock_guard guard{ lock };
+        registry.Set(handle, right, left);
+    }
 
-    if (is_on)
+    //Handles go stale on their own when an actor is destroyed, whoever finds one that has drops it.
+    static void Remove(RE::ActorHandle handle)
     {
-        //Disabled that for now because of no constructor.
-        if (value < 1.f) //|| !a_this->pad86)
-        {
-            return 0;
-        }
+        std::lock_guard guard{ lock };
+        registry.Remove(handle);
     }
-    else
+
+    //A copy, so the lock isn't held while the caller works through them.
+    static std::vector<RE::ActorHandle> Snapshot()
     {
-        if (value > -1.f)//if value is returning a small sum or restoring a large decrement.
-            return 0;
+        std::lock_guard guard{ lock };
+        return { registry.keys().begin(), registry.keys().end() };
     }
-    
-    logger::debug("value increment, {}", value > 0);
 
-    return value > 0 ? 1 : -1;
-}
+    static size_t Count()
+    {
+        std::lock_guard guard{ lock };
+        return registry.size();
+    }
+
+    //Every actor is gone on a load, the effects put back what's still tagged as they load.
+    static void Clear()
+    {
+        std::lock_guard guard{ lock };
+        registry.clear();
+    }
+
+    struct HandleHash
+    {
+        size_t operator()(const RE::ActorHandle& handle) const
+        {
+            return std::hash<uint32_t>{}(handle.native_handle());
+        }
+    };
+
+    //Effects start and finish on whatever thread, so this gets locked from more than just the main one.
+    static inline std::mutex lock;
+    static inline TagRegistry<RE::ActorHandle, HandleHash> registry;
+};
+
+//inline uint32_t& GetActorTag(RE::Actor* target, RE::ActorValue av)
+//{
+//    return GetActorTag(target, av == RE::ActorValue::kWeaponSpeedMult);
+//}
+
+constexpr bool k_right = true;
+constexpr bool k_left = false;
 
 
 RE::Actor* GetTargetActor(RE::MagicTarget* target)
@@ -470,86 +1509,261 @@ void correct(RE::Actor* t)
 }
 
 
-//Note, currently these adjustments don't work if the magnitude gets flipped. Need to account for that sort of situations.
-// That will likely rest in handle actor tag. But due to the projects nature, I can add it any time the problem arises.
-
-//make a get left right function, that way I can move the padding if need be.
-//template both parameters maybe?
-void HandleSpeedEffect(RE::ValueModifierEffect* a_this, float value, bool is_dual, bool is_on)
+static_assert(std::to_underlying(SettingFlag::kHostile) == EffectIndex::k_settingHostile);
+static_assert(std::to_underlying(SettingFlag::kRecover) == EffectIndex::k_settingRecover);
+static_assert(std::to_underlying(SettingFlag::kDetrimental) == EffectIndex::k_settingDetrimental);
+static_assert(std::to_underlying(SettingFlag::kNoDuration) == EffectIndex::k_settingNoDuration);
+static_assert(std::to_underlying(SettingFlag::kNoMagnitude) == EffectIndex::k_settingNoMagnitude);
+static_assert(std::to_underlying(SettingFlag::kPowerAffectsMagnitude) == EffectIndex::k_settingPowerAffectsMagnitude);
+static_assert(std::to_underlying(SettingFlag::kPowerAffectsDuration) == EffectIndex::k_settingPowerAffectsDuration);
+static_assert(std::to_underlying(RE::MagicSystem::SpellType::kDisease) == EffectIndex::k_spellDisease);
+static_assert(std::to_underlying(RE::MagicSystem::SpellType::kAbility) == EffectIndex::k_spellAbility);
+static_assert(std::to_underlying(RE::MagicSystem::SpellType::kEnchantment) == EffectIndex::k_spellEnchantment);
+static_assert(std::to_underlying(RE::MagicSystem::SpellType::kIngredient) == EffectIndex::k_spellIngredient);
+static_assert(std::to_underlying(RE::MagicSystem::SpellType::kAddiction) == EffectIndex::k_spellAddiction);
+static_assert(std::to_underlying(RE::MagicSystem::CastingType::kConstantEffect) == EffectIndex::k_castConstantEffect);
+
+//What the effect hooks want to know about a spell or effect, worked out once on data loaded so they can do a single lookup and a
+// bit test instead of walking spell types and flags every application. Anything that isn't in the table (made at runtime,
+// like custom enchantments) just gets classified on the spot. The rules themselves are in EffectIndex.h, along with the index
+// file the table gets checked against.
+//
+// It's a snapshot of the records as they are on our data loaded. Anything that changes an effect's flags or actor values after
+// that, another plugin's data loaded listener that happens to run after ours or a script at runtime, isn't seen, and that form
+// keeps the class it had. Nothing known does that to speed effects. If something does, Build has to run again from a later
+// message, and swapping the table out is only safe while no hook can be reading it (a loading screen, not in game).
+struct EffectClasses
 {
-    //The effect is redundant
-    //is_dual is if it's dual.
-    // Is on declares that negative values are of no concern, they're intentional decreases. Off will need a flag. That flag will not be saved however.
-    // that too goes in padding.
+    using enum EffectIndex::Flag;
 
-    //The value plucked for dual value modifer is the size of this + 98. That 4 past 94 being another multiplier value.
+    static bool IsSpeed(RE::ActorValue av)
+    {
+        return av == RE::ActorValue::kWeaponSpeedMult || av == RE::ActorValue::kLeftWeaponSpeedMultiply;
+    }
 
-    //pad86 is the padding I need. I want to hook ValueModifierEffect__ctor_1405671F0 for it, so I can free up some space for any other padding use.
+    static uint8_t Classify(const RE::MagicItem* item)
+    {
+        return EffectIndex::ClassifyItem(std::to_underlying(item->GetSpellType()), std::to_underlying(item->GetCastingType()));
+    }
 
-    //Note, due to lack of dealing with being inited from save, AND constructor hooks. this is woefully unprepared for a save.
+    static uint8_t Classify(const RE::EffectSetting* setting)
+    {
+        uint8_t result = EffectIndex::ClassifyEffect(setting->data.flags.underlying());
 
-    //BIG NOTE
-    //When handling magnitude, use the base magnitude instead of the current value.
+        if (IsSpeed(setting->data.primaryAV) || IsSpeed(setting->data.secondaryAV))
+            result |= kSpeedRelevant;
 
-        RE::Actor* target = GetTargetActor(a_this->target);
-        
-        if (!target) {
-            logger::debug("Null target");
+        return result;
+    }
+
+
+    static uint8_t Get(const RE::MagicItem* item)
+    {
+        if (auto entry = table.find(item->GetFormID()))
+            return *entry;
+
+        return Classify(item);
+    }
+
+    static uint8_t Get(const RE::EffectSetting* setting)
+    {
+        if (auto entry = table.find(setting->GetFormID()))
+            return *entry;
+
+        return Classify(setting);
+    }
+
+
+    //Every loaded plugin's name, size and write time, the same way the scanner hashes its load order.
+    static uint64_t LoadOrderHash()
+    {
+        EffectIndex::LoadOrderHash hash;
+
+        auto& collection = RE::TESDataHandler::GetSingleton()->compiledFileCollection;
+
+        auto add = [&](RE::TESFile* file) {
+            auto path = std::filesystem::path{ "Data" } / file->GetFilename();
+
+            std::error_code error;
+            auto size = std::filesystem::file_size(path, error);
+            auto write_time = EffectIndex::WriteTime(path, error);
+
+            hash.Add(file->GetFilename(), error ? 0 : size, write_time);
+        };
+
+        for (auto file : collection.files)
+            add(file);
+
+        for (auto file : collection.smallFiles)
+            add(file);
+
+        return hash.value();
+    }
+
+    //Holds the table up against the index tools/plugin_scanner makes, if there is one and it's for this load order. Only
+    // logs, the table is what the records say now and the index is what the files said, so where they differ something
+    // changed the record in between (or the scanner reads it wrong, which is as worth knowing). covered is how many
+    // effects, spells and enchantments went into the table, the forms the scanner looks at.
+    static void CheckIndex(size_t covered)
+    {
+        std::filesystem::path path{ "Data/SKSE/Plugins/ComprehensiveAttackRatePatch/EffectIndex.bin" };
+
+        HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+        if (file == INVALID_HANDLE_VALUE)
             return;
-        }
 
-        switch (a_this->actorValue)
-        {
-        case RE::ActorValue::kWeaponSpeedMult:
-            //target->pad1C += HandleActorTag(a_this, is_on, value);
-            GetActorTag(target, k_right) += HandleActorTag(a_this, is_on, value);
-            //GetActorTag(target, k_right)++;
-            //HandleActorTag(a_this, is_on, value);
-            //logger::debug("Right1st {} ({:08X}): {}, {}", is_on ? "ON" : "OFF", a_this->effect->baseEffect->formID, value, GetActorTag(target, k_right));
-            break;
+        LARGE_INTEGER size{};
+        HANDLE mapping = nullptr;
+        const void* view = nullptr;
 
-        case RE::ActorValue::kLeftWeaponSpeedMultiply:
-            //target->GetActorRuntimeData().pad0EC += HandleActorTag(a_this, is_on, value);
-            GetActorTag(target, k_left) += HandleActorTag(a_this, is_on, value);
-            //GetActorTag(target, k_left)++;
-            //HandleActorTag(a_this, is_on, value);
-            //logger::debug("Left1st {} ({:08X}): {}, {}", is_on ? "ON" : "OFF", a_this->effect->baseEffect->formID, value, GetActorTag(target, k_left));
-            break;
+        if (GetFileSizeEx(file, &size) && size.QuadPart)
+            mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+        if (mapping)
+            view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+        if (!view) {
+            logger::warn("Couldn't map {}, not checking against it.", path.string());
         }
-        
-        
-        if (is_dual)
-        {
-            RE::EffectSetting* setting = a_this->GetBaseObject();
-            
-            //Dual value mod hasn't been done yet and prick that I am I don't feel like making it
-            //I'm also going to stick with this because it's the correct offset.
-            
-            //The current version of this isn't quite correct, and the thing to get the repository is busted
-            // so negatory.
-            //RE::DualValueModifierEffect* dual_mod = skyrim_cast<RE::DualValueModifierEffect*>(a_this);
-            
-            //if (!dual_mod)
-            //    return;
+        else if (auto index = EffectIndex::View(view, static_cast<size_t>(size.QuadPart), LoadOrderHash()); !index) {
+            logger::info("Not checking against {}, {}. Run the plugin scanner again to update it.", path.string(), index.error());
+        }
+        else {
+            constexpr size_t k_reported = 8;
 
-            float dual_mod = *stl::adjust_pointer<float>(a_this, 0x98);//GetDualMod(a_this);//
-            //float dual_mod = skyrim_cast<RE::DualValueModifierEffect*>(a_this)->secondaryAVWeight;
-            
-            switch (setting->data.secondaryAV)
+            size_t found = 0;
+            size_t differ = 0;
+            size_t missing = 0;
+
+            for (auto& entry : *index)
             {
-            case RE::ActorValue::kWeaponSpeedMult:
-                GetActorTag(target, k_right) += HandleActorTag(a_this, is_on, value * dual_mod);
-                logger::debug("Right2nd {} ({:08X}): {}, {}", is_on ? "ON" : "OFF", a_this->effect->baseEffect->formID, value * dual_mod, GetActorTag(target, k_right));
-                break;
-            case RE::ActorValue::kLeftWeaponSpeedMultiply:
-                GetActorTag(target, k_left) += HandleActorTag(a_this, is_on, value * dual_mod);
-                logger::debug("Left2nd {} ({:08X}): {}, {}", is_on ? "ON" : "OFF", a_this->effect->baseEffect->formID, value * dual_mod, GetActorTag(target, k_left));
-                break;
+                uint8_t expected = entry.flags;
+
+                if (entry.kind == EffectIndex::kEffect && (IsSpeed(static_cast<RE::ActorValue>(entry.primaryAV)) || IsSpeed(static_cast<RE::ActorValue>(entry.secondaryAV))))
+                    expected |= kSpeedRelevant;
+
+                auto actual = table.find(entry.formID);
+
+                if (!actual) {
+                    if (missing++ < k_reported)
+                        logger::warn("Effect index has {:08X} but it isn't loaded.", entry.formID);
+
+                    continue;
+                }
+
+                found++;
+
+                if (*actual != expected && differ++ < k_reported)
+                    logger::warn("{:08X} is classed {:02X} but the effect index has {:02X}.", entry.formID, *actual, expected);
+            }
+
+            if (differ || missing || found != covered) {
+                logger::warn("Effect index differs on {} of {} forms, {} in it aren't loaded and {} loaded aren't in it. Using what's loaded.",
+                    differ, found, missing, covered - found);
+            }
+            else {
+                logger::info("Effect index agrees on all {} forms.", found);
             }
         }
 
-        
-}
+        if (view)
+            UnmapViewOfFile(view);
+
+        if (mapping)
+            CloseHandle(mapping);
+
+        CloseHandle(file);
+    }
+
+
+    static void Build()
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        auto data_handler = RE::TESDataHandler::GetSingleton();
+
+        std::vector<std::pair<uint32_t, uint8_t>> entries;
+
+        size_t items = 0;
+        size_t speed_relevant = 0;
+
+        auto add_items = [&]<class T>(std::type_identity<T>) {
+            for (auto item : data_handler->GetFormArray<T>()) {
+                if (item) {
+                    entries.emplace_back(item->GetFormID(), Classify(item));
+                    items++;
+                }
+            }
+        };
+
+        add_items(std::type_identity<RE::SpellItem>{});
+        add_items(std::type_identity<RE::EnchantmentItem>{});
+
+        for (auto setting : data_handler->GetFormArray<RE::EffectSetting>()) {
+            if (setting) {
+                auto flags = Classify(setting);
+                entries.emplace_back(setting->GetFormID(), flags);
+
+                if (flags & kSpeedRelevant)
+                    speed_relevant++;
+            }
+        }
+
+        //Everything so far is what the scanner looks at too.
+        size_t covered = entries.size();
+
+        add_items(std::type_identity<RE::AlchemyItem>{});
+        add_items(std::type_identity<RE::IngredientItem>{});
+        add_items(std::type_identity<RE::ScrollItem>{});
+
+        size_t total = entries.size();
+
+        table = FormTable<uint8_t>{ std::move(entries) };
+
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+        logger::info("Classified {} magic items and {} effects ({} touch weapon speed), {} slots built in {}us.",
+            items, total - items, speed_relevant, table.capacity(), elapsed.count());
+
+        CheckIndex(covered);
+    }
+
+    static inline FormTable<uint8_t> table;
+};
+
+
+//Value modifier hooks get every value effect in the game, and next to none of them touch weapon speed. This lets them leave
+// right after the original function on a bit test, and keeps count so it can be seen how many actually do.
+struct SpeedEffectFilter
+{
+    static bool Pass(RE::ActiveEffect* a_this)
+    {
+        auto setting = a_this->GetBaseObject();
+
+        if (setting && EffectClasses::Get(setting) & EffectClasses::kSpeedRelevant) {
+            passed.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        skipped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    static void Report()
+    {
+        auto skipped_count = skipped.load(std::memory_order_relaxed);
+        auto passed_count = passed.load(std::memory_order_relaxed);
+        auto total = skipped_count + passed_count;
+
+        logger::info("Value effect hooks: {} calls, {} skipped early ({:.1f}%), {} touched weapon speed.",
+            total, skipped_count, total ? 100.0 * skipped_count / total : 0.0, passed_count);
+    }
+
+    static inline std::atomic<uint64_t> skipped = 0;
+    static inline std::atomic<uint64_t> passed = 0;
+};
+
 
 
 //NOTICE, to all vtable hooks, ValueAndConditionsEffect may be implemented soon, so might want to get my hooks into that.
@@ -571,17 +1785,188 @@ constexpr size_t VoidEffect = std::tuple_size<EffectTypes>::value - 1;
 template<size_t I>
 using ModifierEffect = std::tuple_element_t<I, EffectTypes>;
 
+static_assert(std::is_same_v<ModifierEffect<EffectHooks::kDualMod>, RE::DualValueModifierEffect>);
+static_assert(std::is_same_v<ModifierEffect<EffectHooks::kEnhance>, RE::EnhanceWeaponEffect>);
+
+
+//The effect half of GameAccess, see EffectHooks.h.
+
+RE::Actor* GameAccess::Target(RE::ValueModifierEffect* effect)
+{
+    return GetTargetActor(effect->target);
+}
+
+std::optional<bool> GameAccess::Hand(RE::ValueModifierEffect* effect)
+{
+    switch (effect->actorValue)
+    {
+    case RE::ActorValue::kWeaponSpeedMult:
+        return k_right;
+    case RE::ActorValue::kLeftWeaponSpeedMultiply:
+        return k_left;
+    default:
+        return std::nullopt;
+    }
+}
+
+std::optional<bool> GameAccess::SecondaryHand(RE::ValueModifierEffect* effect)
+{
+    switch (effect->GetBaseObject()->data.secondaryAV)
+    {
+    case RE::ActorValue::kWeaponSpeedMult:
+        return k_right;
+    case RE::ActorValue::kLeftWeaponSpeedMultiply:
+        return k_left;
+    default:
+        return std::nullopt;
+    }
+}
+
+//Dual value mod hasn't been done yet and prick that I am I don't feel like making it. The value plucked for dual value modifer is
+// the size of this + 98. That 4 past 94 being another multiplier value.
+float GameAccess::DualWeight(RE::ValueModifierEffect* effect)
+{
+    return *stl::adjust_pointer<float>(effect, 0x98);
+}
+
+bool GameAccess::Recovers(RE::ValueModifierEffect* effect)
+{
+    return effect->flags.all(RE::ActiveEffect::Flag::kRecovers);
+}
+
+bool GameAccess::Detrimental(RE::ValueModifierEffect* effect)
+{
+    return effect->effect->baseEffect->IsDetrimental();
+}
+
+bool GameAccess::Dispelled(RE::ValueModifierEffect* effect)
+{
+    return effect->flags.any(RE::ActiveEffect::Flag::kDispelled);
+}
+
+//BIG NOTE
+//When handling magnitude, use the base magnitude instead of the current value.
+float GameAccess::Magnitude(RE::ValueModifierEffect* effect)
+{
+    return effect->effect->GetMagnitude();
+}
+
+float GameAccess::Value(RE::ValueModifierEffect* effect)
+{
+    return effect->value;
+}
+
+bool GameAccess::Applied(RE::ValueModifierEffect* effect)
+{
+    constexpr auto applied_effect_flag = RE::ActiveEffect::Flag(1 << 16);
+
+    return effect->flags.all(applied_effect_flag);
+}
+
+bool GameAccess::ConditionsHold(RE::ValueModifierEffect* effect)
+{
+    return effect->conditionStatus == RE::ActiveEffect::ConditionStatus::kTrue ||
+        !effect->flags.any(RE::ActiveEffect::Flag::kHasConditions);
+}
+
+//The padding I had in mind for this back when there was no constructor to clear it, the mark values don't need it cleared.
+uint16_t& GameAccess::Mark(RE::ValueModifierEffect* effect)
+{
+    return effect->pad86;
+}
+
+float& GameAccess::Tag(RE::Actor* actor, bool right)
+{
+    return GetActorTag(actor, right);
+}
+
+void GameAccess::Sync(RE::Actor* actor)
+{
+    TaggedActors::Sync(actor);
+}
+
+bool GameAccess::SpeedRelevant(RE::ValueModifierEffect* effect)
+{
+    return SpeedEffectFilter::Pass(effect);
+}
+
+void GameAccess::BeforeSpeedChange(RE::Actor* actor)
+{
+    SpeedChangeEvents::MarkDirty(actor);
+}
+
+//Which of the ModifierEffects an active effect is, by its vtable, or -1 for none of them.
+int ValueEffectType(RE::ActiveEffect* effect)
+{
+    static const std::array vtables
+    {
+        ModifierEffect<0>::VTABLE[0].address(),
+        ModifierEffect<1>::VTABLE[0].address(),
+        ModifierEffect<2>::VTABLE[0].address(),
+        ModifierEffect<3>::VTABLE[0].address(),
+        ModifierEffect<4>::VTABLE[0].address(),
+    };
+
+    auto vtable = *reinterpret_cast<uintptr_t*>(effect);
+
+    for (size_t i = 0; i < vtables.size(); i++) {
+        if (vtables[i] == vtable)
+            return static_cast<int>(i);
+    }
+
+    return -1;
+}
+
+//Without the filter's counters, the auditor going over effects isn't an application.
+template <class F>
+bool GameAccess::ForEachValueEffect(RE::Actor* actor, F&& callback)
+{
+    auto effects = actor->AsMagicTarget()->GetActiveEffectList();
+
+    if (!effects)
+        return false;
+
+    for (auto active_effect : *effects)
+    {
+        if (!active_effect)
+            continue;
+
+        auto setting = active_effect->GetBaseObject();
+
+        if (!setting || !(EffectClasses::Get(setting) & EffectClasses::kSpeedRelevant))
+            continue;
+
+        int type = ValueEffectType(active_effect);
+
+        if (type < 0)
+            continue;
+
+        callback(static_cast<RE::ValueModifierEffect*>(active_effect), type);
+    }
+
+    return true;
+}
+
 
 //VTABLE
 struct ValueEffectStartHook
 {
+    static constexpr std::array sites
+    {
+        Hooks::Vfunc("ValueModifierEffect::Start", ModifierEffect<0>::VTABLE[0], 20),
+        Hooks::Vfunc("DualValueModifierEffect::Start", ModifierEffect<1>::VTABLE[0], 20),
+        Hooks::Vfunc("ValueAndConditionsEffect::Start", ModifierEffect<2>::VTABLE[0], 20),
+        Hooks::Vfunc("PeakValueModifierEffect::Start", ModifierEffect<3>::VTABLE[0], 20),
+        Hooks::Vfunc("EnhanceWeaponEffect::Start", ModifierEffect<4>::VTABLE[0], 20),
+    };
+
     static void Patch()
     {
-        func[0] = REL::Relocation<uintptr_t>{ ModifierEffect<0>::VTABLE[0] }.write_vfunc(20, thunk<0>);
-        func[1] = REL::Relocation<uintptr_t>{ ModifierEffect<1>::VTABLE[0] }.write_vfunc(20, thunk<1>);
-        func[2] = REL::Relocation<uintptr_t>{ ModifierEffect<2>::VTABLE[0] }.write_vfunc(20, thunk<2>);
-        func[3] = REL::Relocation<uintptr_t>{ ModifierEffect<3>::VTABLE[0] }.write_vfunc(20, thunk<3>);
-        func[4] = REL::Relocation<uintptr_t>{ ModifierEffect<4>::VTABLE[0] }.write_vfunc(20, thunk<4>);
+        func[0] = Hooks::write_vfunc(sites[0], thunk<0>);
+        func[1] = Hooks::write_vfunc(sites[1], thunk<1>);
+        func[2] = Hooks::write_vfunc(sites[2], thunk<2>);
+        func[3] = Hooks::write_vfunc(sites[3], thunk<3>);
+        func[4] = Hooks::write_vfunc(sites[4], thunk<4>);
         
         logger::info("ValueEffectStartHook complete...");
     }
@@ -592,35 +1977,18 @@ struct ValueEffectStartHook
     template <int I = VoidEffect>
     static void thunk(ModifierEffect<I>* a_this)
     {
-        func[I](a_this);
-        
-
-        if constexpr (I == 4)
-        {
-            if (a_this->flags.any(RE::ActiveEffect::Flag::kDispelled) == true) {
-                //logger::info("enhance effect dispelled.");
-                return;
-            }
-        }
-
-        auto effect = a_this->effect;
-
-        float alignment = a_this->value >= 0 ? 1 : -1;
-
-        float magnitude = effect->GetMagnitude();
+        //Before the effect goes on, so the change is seen from where the speed was.
+        bool relevant = EffectHooks::Prepare<GameAccess>(a_this);
 
+        func[I](a_this);
 
-        
-        if (a_this->flags.all(RE::ActiveEffect::Flag::kRecovers) == true && 
-            effect->baseEffect->IsDetrimental() == false)
-            //Redesign for it to use
-            //return HandleSpeedEffect(a_this, a_this->value, I == 1, true);
-            HandleSpeedEffect(a_this, a_this->effect->GetMagnitude() * alignment, I == 1, true);
-        else
+        if (!relevant)
             return;
         
+        CARP_PROFILE_SCOPE(std::format("ValueEffectStartHook<{}>", I));
 
-       
+        if (!EffectHooks::Start<GameAccess>(a_this, I))
+            return;
 
         static constexpr std::string_view names[]
         {
@@ -636,7 +2004,7 @@ struct ValueEffectStartHook
         }
 
         //logger::info("ON {}: {}", names[I], a_this->value);
-        logger::debug("ON {}: {}", names[I], a_this->effect->GetMagnitude() * alignment);
+        logger::debug("ON {}: {}", names[I], EffectHooks::TagValue<GameAccess>(a_this));
     }
 
 
@@ -648,13 +2016,22 @@ struct ValueEffectStartHook
 //VTABLE
 struct ValueEffectFinishHook
 {
+    static constexpr std::array sites
+    {
+        Hooks::Vfunc("ValueModifierEffect::Finish", ModifierEffect<0>::VTABLE[0], 21),
+        Hooks::Vfunc("DualValueModifierEffect::Finish", ModifierEffect<1>::VTABLE[0], 21),
+        Hooks::Vfunc("ValueAndConditionsEffect::Finish", ModifierEffect<2>::VTABLE[0], 21),
+        Hooks::Vfunc("PeakValueModifierEffect::Finish", ModifierEffect<3>::VTABLE[0], 21),
+        Hooks::Vfunc("EnhanceWeaponEffect::Finish", ModifierEffect<4>::VTABLE[0], 21),
+    };
+
     static void Patch()
     {
-        func[0] = REL::Relocation<uintptr_t>{ ModifierEffect<0>::VTABLE[0] }.write_vfunc(21, thunk<0>);
-        func[1] = REL::Relocation<uintptr_t>{ ModifierEffect<1>::VTABLE[0] }.write_vfunc(21, thunk<1>);
-        func[2] = REL::Relocation<uintptr_t>{ ModifierEffect<2>::VTABLE[0] }.write_vfunc(21, thunk<2>);
-        func[3] = REL::Relocation<uintptr_t>{ ModifierEffect<3>::VTABLE[0] }.write_vfunc(21, thunk<3>);
-        func[4] = REL::Relocation<uintptr_t>{ ModifierEffect<4>::VTABLE[0] }.write_vfunc(21, thunk<4>);
+        func[0] = Hooks::write_vfunc(sites[0], thunk<0>);
+        func[1] = Hooks::write_vfunc(sites[1], thunk<1>);
+        func[2] = Hooks::write_vfunc(sites[2], thunk<2>);
+        func[3] = Hooks::write_vfunc(sites[3], thunk<3>);
+        func[4] = Hooks::write_vfunc(sites[4], thunk<4>);
 
         logger::info("ValueEffectFinishHook complete...");
     }
@@ -663,17 +2040,16 @@ struct ValueEffectFinishHook
     template <int I = VoidEffect>
     static void thunk(ModifierEffect<I>* a_this)
     {
+        bool relevant = EffectHooks::Prepare<GameAccess>(a_this);
+
         func[I](a_this);
 
+        if (!relevant)
+            return;
 
-        auto effect = a_this->effect;
+        CARP_PROFILE_SCOPE(std::format("ValueEffectFinishHook<{}>", I));
 
-        float alignment = a_this->value >= 0 ? 1 : -1;
-        
-        if (a_this->flags.all(RE::ActiveEffect::Flag::kRecovers) == true &&
-            effect->baseEffect->IsDetrimental() == false)
-            //HandleSpeedEffect(a_this, a_this->value, I == 1, false);
-            HandleSpeedEffect(a_this, a_this->effect->GetMagnitude() * alignment, I == 1, false);
+        EffectHooks::Finish<GameAccess>(a_this, I);
 
         //return;
 
@@ -701,7 +2077,7 @@ struct ValueEffectFinishHook
         }
 
         //logger::info("OFF {}: {}", names[I], a_this->value);
-        logger::debug("OFF {}: {}", names[I], a_this->effect->GetMagnitude() * alignment);
+        logger::debug("OFF {}: {}", names[I], EffectHooks::TagValue<GameAccess>(a_this));
     }
 
 
@@ -714,71 +2090,38 @@ struct ValueEffectFinishHook
 //write_branch
 struct GetActorValueModifierHook
 {
+    //SE: 0x621350, AE: 0x658BD0, VR: ???
+    static constexpr std::array sites{ Hooks::Detour("GetActorValueModifier", REL::RelocationID(37524, 38469)) };
+
     static void Patch()
     {
-        //Use variantID at some point pls.
-        //auto hook_addr = REL::ID(37524 /*0x621350*/).address();
-        auto hook_addr = REL::RelocationID(37524, 38469).address();//SE: 0x621350, AE: 0x658BD0, VR: ???
-        auto return_addr = hook_addr + 0x6;
-        //*
-        struct Code : Xbyak::CodeGenerator
-        {
-            Code(uintptr_t ret_addr)
-            {
-                //AE/SE versions remain the same
-                push(rbx);
-                sub(rsp, 0x20);
-
-                mov(rax, ret_addr);
-                jmp(rax);
-            }
-        } static code{ return_addr };
-
-        auto& trampoline = SKSE::GetTrampoline();
-
-        //func = (uintptr_t)code.getCode();
-
-        //trampoline.write_branch<5>(hook_addr, thunk);
-
-        //return;
-        auto placed_call = IsCallOrJump(hook_addr) > 0;
-
-        auto place_query = trampoline.write_branch<5>(hook_addr, (uintptr_t)thunk);
-
-        if (!placed_call)
-            func = (uintptr_t)code.getCode();
-        else
-            func = place_query;
+        //The prologue used to be rebuilt by hand here (push rbx; sub rsp, 0x20), it's relocated by the decoder now. Works the
+        // same if another plugin got here first, the jump it left just gets carried over.
+        func = Hooks::write_detour(sites[0], thunk);
 
         logger::info("GetActorValueModifier Hook complete...");
-        //*/
     }
 
     static float thunk(RE::Character* a_this, RE::ACTOR_VALUE_MODIFIER a2, RE::ActorValue a3)
     {
         float result = func(a_this, a2, a3);
 
+        CARP_PROFILE_SCOPE("GetActorValueModifierHook");
+
         if (a2 != RE::ACTOR_VALUE_MODIFIER::kTemporary)
             return result;
-        
-        float offset;
 
         switch (a3)
         {
         case RE::ActorValue::kWeaponSpeedMult:
             //return result - a_this->pad1C;
-            offset = GetActorTag(a_this, k_right);
-            break;
+            return EffectHooks::ActorValue<GameAccess>(a_this, k_right, result);
         case RE::ActorValue::kLeftWeaponSpeedMultiply:
             //return result - a_this->GetActorRuntimeData().pad0EC;
-            offset = GetActorTag(a_this, k_left);
-            break;
+            return EffectHooks::ActorValue<GameAccess>(a_this, k_left, result);
         default:
             return result;
         }
-
-        
-        return result - offset;
     }
 
     static inline REL::Relocation<decltype(thunk)> func;
@@ -787,14 +2130,16 @@ struct GetActorValueModifierHook
 //VTABLE
 struct GetActorValueHook
 {
-    static void Patch()
+    static constexpr std::array sites
     {
-        //*
-        REL::Relocation<uintptr_t> PlayerCharacter__Actor_VTable{ RE::VTABLE_PlayerCharacter[5] };
-        REL::Relocation<uintptr_t> Character__Actor_VTable{ RE::VTABLE_Character[5] };
+        Hooks::Vfunc("PlayerCharacter::GetActorValue", RE::VTABLE_PlayerCharacter[5], 0x01),
+        Hooks::Vfunc("Character::GetActorValue", RE::VTABLE_Character[5], 0x01),
+    };
 
-        func[0] = PlayerCharacter__Actor_VTable.write_vfunc(0x01, thunk<0>);
-        func[1] = Character__Actor_VTable.write_vfunc(0x01, thunk<1>);
+    static void Patch()
+    {
+        func[0] = Hooks::write_vfunc(sites[0], thunk<0>);
+        func[1] = Hooks::write_vfunc(sites[1], thunk<1>);
 
         logger::info("GetActorValueHook complete...");
     }
@@ -802,19 +2147,21 @@ struct GetActorValueHook
     template <int I>
     static float thunk(RE::ActorValueOwner* a_this, RE::ActorValue a2)
     {
-        RE::Character* target = skyrim_cast<RE::Character*>(a_this);
-
         float result = func[I](a_this, a2);
 
+        CARP_PROFILE_SCOPE(std::format("GetActorValueHook<{}>", I));
+
+        RE::Character* target = skyrim_cast<RE::Character*>(a_this);
+
         switch (a2)
         {
         case RE::ActorValue::kWeaponSpeedMult:
             //return result - target->pad1C;
-            return result - GetActorTag(target, k_right);
+            return EffectHooks::ActorValue<GameAccess>(target, k_right, result);
 
         case RE::ActorValue::kLeftWeaponSpeedMultiply:
             //return result - target->GetActorRuntimeData().pad0EC;
-            return result - GetActorTag(target, k_left);
+            return EffectHooks::ActorValue<GameAccess>(target, k_left, result);
 
         default:
             return result;
@@ -836,14 +2183,16 @@ struct SetBaseActorValueHook
     inline static float intentionalZeroValue = std::nanf("0x69420");
 
 
-    static void Patch()
+    static constexpr std::array sites
     {
-        //*
-        REL::Relocation<uintptr_t> PlayerCharacter__Actor_VTable{ RE::VTABLE_PlayerCharacter[5] };
-        REL::Relocation<uintptr_t> Character__Actor_VTable{ RE::VTABLE_Character[5] };
+        Hooks::Vfunc("PlayerCharacter::SetBaseActorValue", RE::VTABLE_PlayerCharacter[5], 0x04),
+        Hooks::Vfunc("Character::SetBaseActorValue", RE::VTABLE_Character[5], 0x04),
+    };
 
-        func[0] = PlayerCharacter__Actor_VTable.write_vfunc(0x04, thunk<0>);
-        func[1] = Character__Actor_VTable.write_vfunc(0x04, thunk<1>);
+    static void Patch()
+    {
+        func[0] = Hooks::write_vfunc(sites[0], thunk<0>);
+        func[1] = Hooks::write_vfunc(sites[1], thunk<1>);
 
         logger::info("SetBaseActorValueHook complete...");
     }
@@ -856,6 +2205,8 @@ struct SetBaseActorValueHook
         {
         case RE::ActorValue::kWeaponSpeedMult:
         case RE::ActorValue::kLeftWeaponSpeedMultiply:
+            SpeedChangeEvents::MarkDirty(skyrim_cast<RE::Actor*>(a_this));
+
             if (a3 == intentionalZeroValue) {
                 a3 = 0;
             }
@@ -883,14 +2234,16 @@ struct SetBaseActorValueHook
 //VTABLE
 struct ModBaseActorValueHook
 {
-    static void Patch()
+    static constexpr std::array sites
     {
-        //*
-        REL::Relocation<uintptr_t> PlayerCharacter__Actor_VTable{ RE::VTABLE_PlayerCharacter[5] };
-        REL::Relocation<uintptr_t> Character__Actor_VTable{ RE::VTABLE_Character[5] };
+        Hooks::Vfunc("PlayerCharacter::ModBaseActorValue", RE::VTABLE_PlayerCharacter[5], 0x05),
+        Hooks::Vfunc("Character::ModBaseActorValue", RE::VTABLE_Character[5], 0x05),
+    };
 
-        func[0] = PlayerCharacter__Actor_VTable.write_vfunc(0x05, thunk);
-        func[1] = Character__Actor_VTable.write_vfunc(0x05, thunk);
+    static void Patch()
+    {
+        func[0] = Hooks::write_vfunc(sites[0], thunk);
+        func[1] = Hooks::write_vfunc(sites[1], thunk);
 
         logger::info("ModBaseActorValueHook complete...");
     }
@@ -908,6 +2261,8 @@ struct ModBaseActorValueHook
         {
         case RE::ActorValue::kWeaponSpeedMult:
         case RE::ActorValue::kLeftWeaponSpeedMultiply:
+            SpeedChangeEvents::MarkDirty(skyrim_cast<RE::Actor*>(a_this));
+
             if (value == 0 && true) {//Confirm that it's both equal to zero, but ALSO that the patch is active. Sending NAN is undefined behaviour otherwise.
                 value = SetBaseActorValueHook::intentionalZeroValue;
             }
@@ -932,13 +2287,22 @@ struct ModBaseActorValueHook
 //VTABLE
 struct ValueEffect_FinishLoadGameHook
 {
+    static constexpr std::array sites
+    {
+        Hooks::Vfunc("ValueModifierEffect::FinishLoadGame", ModifierEffect<0>::VTABLE[0], 10),
+        Hooks::Vfunc("DualValueModifierEffect::FinishLoadGame", ModifierEffect<1>::VTABLE[0], 10),
+        Hooks::Vfunc("ValueAndConditionsEffect::FinishLoadGame", ModifierEffect<2>::VTABLE[0], 10),
+        Hooks::Vfunc("PeakValueModifierEffect::FinishLoadGame", ModifierEffect<3>::VTABLE[0], 10),
+        Hooks::Vfunc("EnhanceWeaponEffect::FinishLoadGame", ModifierEffect<4>::VTABLE[0], 10),
+    };
+
     static void Patch()
     {
-        func[0] = REL::Relocation<uintptr_t>{ ModifierEffect<0>::VTABLE[0] }.write_vfunc(10, thunk<0>);
-        func[1] = REL::Relocation<uintptr_t>{ ModifierEffect<1>::VTABLE[0] }.write_vfunc(10, thunk<1>);
-        func[2] = REL::Relocation<uintptr_t>{ ModifierEffect<2>::VTABLE[0] }.write_vfunc(10, thunk<2>);
-        func[3] = REL::Relocation<uintptr_t>{ ModifierEffect<3>::VTABLE[0] }.write_vfunc(10, thunk<3>);
-        func[4] = REL::Relocation<uintptr_t>{ ModifierEffect<4>::VTABLE[0] }.write_vfunc(10, thunk<4>);
+        func[0] = Hooks::write_vfunc(sites[0], thunk<0>);
+        func[1] = Hooks::write_vfunc(sites[1], thunk<1>);
+        func[2] = Hooks::write_vfunc(sites[2], thunk<2>);
+        func[3] = Hooks::write_vfunc(sites[3], thunk<3>);
+        func[4] = Hooks::write_vfunc(sites[4], thunk<4>);
 
         logger::info("ValueEffectLoadGameHook complete...");
     }
@@ -947,39 +2311,17 @@ struct ValueEffect_FinishLoadGameHook
     template <int I = VoidEffect>
     static void thunk(ModifierEffect<I>* a_this)
     {
-        constexpr auto applied_effect_flag = RE::ActiveEffect::Flag(1 << 16);
-
         func[I](a_this);
 
-        auto effect = a_this->effect;
-
-        float alignment = a_this->magnitude >= 0 ? 1 : -1;
-
-
-        float magnitude = effect->GetMagnitude();
+        if (!GameAccess::SpeedRelevant(a_this))
+            return;
 
-        //If for some reason something is a value modifier that modifies speed that is zero, but the current value is equal to 1, were going to treat it like its 1.
-        // only doing in load right now, because that's where the problem
-        if (auto act_mag = abs(a_this->value); !magnitude && act_mag >= 1)
-            magnitude = act_mag;
+        CARP_PROFILE_SCOPE(std::format("ValueEffect_FinishLoadGameHook<{}>", I));
 
+        auto effect = a_this->effect;
 
-        //This hit even though it was false. Curious. 
-        // The idea works, however it will definitely have issues
-        if (a_this->flags.all(applied_effect_flag, RE::ActiveEffect::Flag::kRecovers) &&
-            effect->baseEffect->IsDetrimental() == false &&
-            (a_this->conditionStatus == RE::ActiveEffect::ConditionStatus::kTrue ||
-                !a_this->flags.any(RE::ActiveEffect::Flag::kHasConditions))) {//Has effects applied currently
-            //HandleSpeedEffect(a_this, a_this->magnitude, I == 1, true);
-            //HandleSpeedEffect(a_this, a_this->effect->GetMagnitude() * alignment, I == 1, true);
-            HandleSpeedEffect(a_this, magnitude * alignment, I == 1, true);
-        }
-        else
-        {
+        if (!EffectHooks::Load<GameAccess>(a_this, I))
             return;
-        }
-
-        
 
         static constexpr std::string_view names[]
         {
@@ -992,7 +2334,7 @@ struct ValueEffect_FinishLoadGameHook
         
 
         //logger::debug("LOAD {}: {}", names[I], a_this->magnitude);
-        logger::debug("LOAD {} ({}): {}", names[I], effect->baseEffect->GetName(), a_this->effect->GetMagnitude() * alignment);
+        logger::debug("LOAD {} ({}): {}", names[I], effect->baseEffect->GetName(), EffectHooks::TagValue<GameAccess>(a_this));
     }
 
 
@@ -1005,13 +2347,12 @@ struct ValueEffect_FinishLoadGameHook
 //write_call
 struct ActorConstructorHook
 {
+    //SE: 0x5CDBF0, AE: 0x604480, VR: ???
+    static constexpr std::array sites{ Hooks::Call("Actor::Actor", REL::RelocationID(36195, 37174), REL::VariantOffset(0x20, 0x20, 0)) };
+
     static void Patch()
     {
-        REL::Relocation<uintptr_t> ctor_hook{ REL::RelocationID { 36195, 37174 }, 0x20 };//SE: 0x5CDBF0, AE: 0x604480, VR: ???
-
-        auto& trampoline = SKSE::GetTrampoline();
-
-        func = trampoline.write_call<5>(ctor_hook.address(), thunk);
+        func = Hooks::write_call(sites[0], thunk);
 
         logger::info("ActorCtorHook complete...");
         //*/
@@ -1037,14 +2378,16 @@ struct ActorConstructorHook
 //VTABLE
 struct Actor__FinishLoadGameHook
 {
-    static void Patch()
+    static constexpr std::array sites
     {
-        //*
-        REL::Relocation<uintptr_t> PlayerCharacter__Actor_VTable{ RE::VTABLE_PlayerCharacter[0] };
-        REL::Relocation<uintptr_t> Character__Actor_VTable{ RE::VTABLE_Character[0] };
+        Hooks::Vfunc("PlayerCharacter::FinishLoadGame", RE::VTABLE_PlayerCharacter[0], 0x11),
+        Hooks::Vfunc("Character::FinishLoadGame", RE::VTABLE_Character[0], 0x11),
+    };
 
-        func[0] = PlayerCharacter__Actor_VTable.write_vfunc(0x11, thunk<0>);
-        func[1] = Character__Actor_VTable.write_vfunc(0x11, thunk<1>);
+    static void Patch()
+    {
+        func[0] = Hooks::write_vfunc(sites[0], thunk<0>);
+        func[1] = Hooks::write_vfunc(sites[1], thunk<1>);
 
         logger::info("Actor::FinishLoadGameHook complete...");
     }
@@ -1127,6 +2470,189 @@ struct Actor__FinishLoadGameHook
 
 
 
+//VTABLE
+struct AnimationEventHook
+{
+    using Sink = RE::BSTEventSink<RE::BSAnimationGraphEvent>;
+
+    static constexpr std::array sites
+    {
+        Hooks::Vfunc("PlayerCharacter::ProcessEvent(BSAnimationGraphEvent)", RE::VTABLE_PlayerCharacter[2], 0x01),
+        Hooks::Vfunc("Character::ProcessEvent(BSAnimationGraphEvent)", RE::VTABLE_Character[2], 0x01),
+    };
+
+    static void Patch()
+    {
+        func[0] = Hooks::write_vfunc(sites[0], thunk<0>);
+        func[1] = Hooks::write_vfunc(sites[1], thunk<1>);
+
+        logger::info("AnimationEventHook complete...");
+    }
+
+    template <int I>
+    static RE::BSEventNotifyControl thunk(Sink* a_this, const RE::BSAnimationGraphEvent* a_event, RE::BSTEventSource<RE::BSAnimationGraphEvent>* a_source)
+    {
+        if (a_event && a_event->holder && a_event->tag == "attackStop") {
+            if (auto actor = const_cast<RE::TESObjectREFR*>(a_event->holder)->As<RE::Actor>())
+                AttackPins::Release(actor, SpeedChangeEvents::MarkDirty);
+        }
+
+        return func[I](a_this, a_event, a_source);
+    }
+
+    static inline REL::Relocation<decltype(thunk<0>)> func[2];
+};
+
+
+
+//Goes over the actors in high process (and anyone else still tagged) a few a frame, rebuilding their tags from their active
+// effects by the same rule the start and finish hooks keep them with, and puts them right if the running count has wandered off.
+// Anything it fixes gets logged and counted so it's known how often the count goes wrong.
+struct TagAuditor
+{
+    static std::optional<std::array<float, 2>> Recompute(RE::Actor* actor)
+    {
+        return EffectHooks::Recompute<GameAccess>(actor);
+    }
+
+    static void Audit(RE::ActorHandle handle)
+    {
+        auto actor = handle.get();
+
+        if (!actor || actor->IsDeleted()) {
+            TaggedActors::Remove(handle);
+            return;
+        }
+
+        auto expected = Recompute(actor.get());
+
+        if (!expected)
+            return;
+
+        audited++;
+
+        SpeedTag& right = GetActorTag(actor.get(), k_right);
+        SpeedTag& left = GetActorTag(actor.get(), k_left);
+
+        if (right == expected->at(0) && left == expected->at(1))
+            return;
+
+        drifted++;
+        drift += abs(right - expected->at(0)) + abs(left - expected->at(1));
+
+        logger::info("Tag drift on {} ({:08X}), r: {} -> {}, l: {} -> {}.",
+            actor->GetName(), actor->GetFormID(), right, expected->at(0), left, expected->at(1));
+
+        SpeedChangeEvents::MarkDirty(actor.get());
+
+        right = expected->at(0);
+        left = expected->at(1);
+
+        TaggedActors::Sync(actor.get());
+    }
+
+    //Once a frame. A new pass over everyone starts at most once a second.
+    static void Tick(float delta)
+    {
+        float budget = auditBudget.GetValue();
+
+        if (budget <= 0)
+            return;
+
+        sincePass += delta;
+
+        if (scheduler.Exhausted())
+        {
+            constexpr float k_passInterval = 1.f;
+
+            if (sincePass < k_passInterval)
+                return;
+
+            sincePass = 0;
+
+            std::vector<RE::ActorHandle> handles;
+
+            if (auto player = RE::PlayerCharacter::GetSingleton())
+                handles.push_back(player->GetHandle());
+
+            if (auto process_lists = RE::ProcessLists::GetSingleton())
+                for (auto& handle : process_lists->highActorHandles)
+                    handles.push_back(handle);
+
+            //Tagged actors that have dropped out of high process are still worth a look, their tags still apply.
+            auto tagged = TaggedActors::Snapshot();
+            handles.insert(handles.end(), tagged.begin(), tagged.end());
+
+            std::ranges::sort(handles, {}, &RE::ActorHandle::native_handle);
+            handles.erase(std::ranges::unique(handles).begin(), handles.end());
+
+            scheduler.Refill(std::move(handles));
+        }
+
+        CARP_PROFILE_SCOPE("TagAuditor");
+
+        scheduler.Run(std::chrono::microseconds(static_cast<int64_t>(budget)),
+            [] { return std::chrono::steady_clock::now().time_since_epoch(); }, Audit);
+    }
+
+    static void Report()
+    {
+        logger::info("Tag audit: {} actors checked, {} drifted, {} off in total. {} actors tagged right now.",
+            audited, drifted, drift, TaggedActors::Count());
+    }
+
+    static void Clear()
+    {
+        scheduler.Refill({});
+        sincePass = 0;
+    }
+
+    static inline TagAudit::Scheduler<RE::ActorHandle> scheduler;
+    static inline float sincePass = 0;
+
+    static inline uint64_t audited = 0;
+    static inline uint64_t drifted = 0;
+    static inline float drift = 0;
+};
+
+
+//VTABLE
+struct PlayerUpdateHook
+{
+    static constexpr std::array sites{ Hooks::Vfunc("PlayerCharacter::Update", RE::VTABLE_PlayerCharacter[0], 0xAD) };
+
+    static void Patch()
+    {
+        func = Hooks::write_vfunc(sites[0], thunk);
+
+        logger::info("PlayerUpdateHook complete...");
+    }
+
+    //Once a frame, this is where anything CARP defers to the end of a frame happens.
+    static void thunk(RE::PlayerCharacter* a_this, float a_delta)
+    {
+        func(a_this, a_delta);
+
+        SettingsEpoch::Refresh();
+
+        FusedSpeedCache::Invalidate();
+
+        AttackPins::Sweep(SpeedChangeEvents::MarkDirty);
+
+        EvaluationTiers::Advance(a_delta);
+
+        TagAuditor::Tick(a_delta);
+
+        SpeedChangeEvents::Flush();
+
+        CARP_PROFILE_FRAME();
+    }
+
+    static inline REL::Relocation<decltype(thunk)> func;
+};
+
+
+
 //write_branch, rewrite
 struct SetEffectivenessHook
 {
@@ -1164,21 +2690,21 @@ struct SetEffectivenessHook
     }
 
 
-    static void Patch()
+    static constexpr std::array sites
     {
-        //Use variantID at some point pls.
         //SE: (0x540360), AE: NA(inlined), VR: ???
         //7B aint the real hook, nor EA
-        auto inner_hook_addr = REL::RelocationID(33320, 0, 0).address();
-        
+        Hooks::Branch("SetEffectiveness(inner)", REL::RelocationID(33320, 0, 0)),
         //SE: (0x53DEB0), AE: (0x55EEA0), VR: ???
-        auto outer_hook_addr = REL::RelocationID(33277, 34052, 0).address();
-        
+        Hooks::Branch("SetEffectiveness(outer)", REL::RelocationID(33277, 34052, 0)),
         //SE: 0x554700, AE: 0x5771B0, VR: ???//0x4A3/0x656
-        auto wrap_hook_addr = REL::RelocationID(33763, 34547, 0).address() + REL::VariantOffset(0x4A3, 0x656, 0).offset();
+        Hooks::Call("SetEffectiveness(wrap)", REL::RelocationID(33763, 34547, 0), REL::VariantOffset(0x4A3, 0x656, 0)),
+    };
 
 
-        auto& trampoline = SKSE::GetTrampoline();
+    static void Patch()
+    {
+        auto inner_hook_addr = sites[0].address();
 
 
         
@@ -1230,11 +2756,11 @@ struct SetEffectivenessHook
         /*/
         
         if (inner_hook_addr)
-            trampoline.write_branch<5>(inner_hook_addr, inner_thunk);
+            Hooks::write_branch(sites[0], inner_thunk);
 
-        trampoline.write_branch<5>(outer_hook_addr, outer_thunk);
+        Hooks::write_branch(sites[1], outer_thunk);
 
-        trampoline.write_call<5>(wrap_hook_addr, wrap_thunk);
+        Hooks::write_call(sites[2], wrap_thunk);
 
         //*/
         
@@ -1250,38 +2776,13 @@ struct SetEffectivenessHook
 
     static bool ShouldAdjustEffects(const RE::MagicItem* a_this)
     {
-        switch (a_this->GetSpellType())
-        {
-        case RE::MagicSystem::SpellType::kDisease:
-        case RE::MagicSystem::SpellType::kAbility:
-        case RE::MagicSystem::SpellType::kIngredient:
-        case RE::MagicSystem::SpellType::kAddiction:
-        {
-            return false;
-        }
-        case RE::MagicSystem::SpellType::kEnchantment:
-        {
-            return a_this->GetCastingType() != RE::MagicSystem::CastingType::kConstantEffect;
-        }
-        default:
-        {
-            return true;
-        }
-        }
+        return EffectClasses::Get(a_this) & EffectClasses::kAdjusts;
     }
 
 
     static void func(RE::ActiveEffect* a_this, float effectiveness)
     {
-        float mag_comp = fabs(magnitudeComparison.GetValue());
-
-        float next_increment = nextafter(mag_comp, INFINITY) - mag_comp;
-
-        logger::debug("next increment value: {}", next_increment);
-
-        float polarity = a_this->magnitude < 0 ? -1 : 1;
-
-        a_this->magnitude = fmax(fabs(a_this->magnitude) * effectiveness, next_increment) * polarity;
+        a_this->magnitude = Effectiveness::ScaleMagnitude(a_this->magnitude, effectiveness, SettingsEpoch::minMagnitude);
         //a_this->magnitude = fabs(a_this->magnitude) * mult * polarity;
 
     }
@@ -1342,7 +2843,7 @@ struct SetEffectivenessHook
         }
 
         //Inner func, might have to implement upper changes in as well.
-        auto effectSettingFlags = a_this->effect->baseEffect->data.flags;
+        auto effect_class = EffectClasses::Get(a_this->effect->baseEffect);
 
 
         if (effectiveness == 1.f || effectiveness < 0.f)
@@ -1354,7 +2855,7 @@ struct SetEffectivenessHook
         // Reflect these changes.
 
         //Mitigation mustnt be 1, which means it is mitigating, and scrambugs doesn't take priority
-        if (mitigation == 0 || effectSettingFlags.none(SettingFlag::kNoDuration) && effectSettingFlags.all(SettingFlag::kPowerAffectsDuration))
+        if (mitigation == 0 || (effect_class & EffectClasses::kAdjustDuration))
         {
             a_this->duration *= effectiveness;
         }
@@ -1363,7 +2864,7 @@ struct SetEffectivenessHook
         // is true, it force goes. if not, then it will evaluate
         // pad86 makes a good one. Additionally, if kernals mod is enabled with the json saying it wishes to use the other one, 
         // it will use that one.
-        if (mitigation == 1 || effectSettingFlags.none(SettingFlag::kNoMagnitude) && effectSettingFlags.all(SettingFlag::kPowerAffectsMagnitude))
+        if (mitigation == 1 || (effect_class & EffectClasses::kAdjustMagnitude))
         {
             return func(a_this, effectiveness);
         }
@@ -1371,6 +2872,8 @@ struct SetEffectivenessHook
 
     static void outer_thunk(RE::ActiveEffect* a_this, float effectiveness, bool req_hostile)
     {
+        CARP_PROFILE_SCOPE("SetEffectivenessHook");
+
         RE::MagicItem* magic_item = a_this->spell;
 
         /*
@@ -1404,7 +2907,7 @@ struct SetEffectivenessHook
             return;
         }
 
-        if (req_hostile && !a_this->effect->IsHostile())
+        if (req_hostile && !(EffectClasses::Get(a_this->effect->baseEffect) & EffectClasses::kHostile))
         {
             return;
         }
@@ -1473,11 +2976,79 @@ int32_t GetVerisonNumber(RE::StaticFunctionTag* = nullptr)
 
 
 
+AttackRatePatchAPI::SettingsSnapshot GetSettingsSnapshot()
+{
+    return AttackRatePatchAPI::SettingsSnapshot
+    {
+        .minSpeed = minSpeed.GetValue(),
+        .capSpeed = capSpeed.GetValue(),
+        .speedTaper = speedTaper.GetValue(),
+        .maxSpeed = maxSpeed.GetValue(),
+        .magnitudeComparison = magnitudeComparison.GetValue(),
+    };
+}
+
+
+//What other plugins get from CARP_RequestInterfaceImpl.
+struct AttackRateInterface : public AttackRatePatchAPI::CurrentInterface
+{
+    AttackRatePatchAPI::Version GetVersion() override
+    {
+        return AttackRatePatchAPI::Version::Current;
+    }
+
+    float GetEffectiveSpeed(RE::Actor* target, bool right) override
+    {
+        return target ? ::GetEffectiveSpeed(target->AsActorValueOwner(), right) : 0.f;
+    }
+
+    void GetEffectiveSpeeds(RE::Actor* const* targets, uint64_t count, int32_t hand_mask, float* out) override
+    {
+        if (!targets || !out)
+            return;
+
+        ::GetEffectiveSpeeds({ targets, count }, hand_mask & kBothHands, out);
+    }
+
+    float GetSpeedTag(RE::Actor* target, bool right) override
+    {
+        return target ? GetActorTag(target, right) : 0.f;
+    }
+
+    void GetSettings(AttackRatePatchAPI::SettingsSnapshot& out) override
+    {
+        out = GetSettingsSnapshot();
+    }
+
+    bool AddSpeedChangeListener(AttackRatePatchAPI::SpeedChangeCallback callback, void* user) override
+    {
+        return SpeedChangeEvents::AddListener({ callback, user });
+    }
+
+    bool RemoveSpeedChangeListener(AttackRatePatchAPI::SpeedChangeCallback callback, void* user) override
+    {
+        return SpeedChangeEvents::RemoveListener({ callback, user });
+    }
+};
+
+AttackRatePatchAPI::CurrentInterface* AttackRatePatchAPI::InterfaceSingleton()
+{
+    static AttackRateInterface intfc;
+    return &intfc;
+}
+
+
+
 bool RegisterFuncs(RE::BSScript::IVirtualMachine* a_vm)
 {
     a_vm->RegisterFunction("VersionNumber", papyrusAPIString, GetVerisonNumber);
 
     a_vm->RegisterFunction("GetEffectiveWeaponSpeed", papyrusAPIString, GetEffectiveSpeedFromActor);
+    a_vm->RegisterFunction("GetEffectiveWeaponSpeeds", papyrusAPIString, GetEffectiveSpeedsFromActors);
+    a_vm->RegisterFunction("GetEffectiveWeaponSpeedsBothHands", papyrusAPIString, GetBothEffectiveSpeedsFromActors);
+
+    a_vm->RegisterFunction("RegisterForEffectiveSpeedChange", papyrusAPIString, RegisterForEffectiveSpeedChange);
+    a_vm->RegisterFunction("UnregisterForEffectiveSpeedChange", papyrusAPIString, UnregisterForEffectiveSpeedChange);
 
     logger::info("PapyrusAPI registered.");
 
@@ -1491,42 +3062,20 @@ bool RegisterFuncs(RE::BSScript::IVirtualMachine* a_vm)
 //write_branch
 struct Condition_HasKeywordHook
 {
+    //SE: (0x2DDA40), AE: (0x2F3C80), VR: ???
+    static constexpr std::array sites{ Hooks::Detour("Condition_HasKeyword", REL::RelocationID(21187, 21644, 0)) };
+
     static void Patch()
     {
-        //SE: (0x2DDA40), AE: (0x2F3C80), VR: ???
-        auto hook_addr = REL::RelocationID(21187, 21644, 0).address();
-        auto return_addr = hook_addr + 0x6;
-        //*
-        struct Code : Xbyak::CodeGenerator
-        {
-            Code(uintptr_t ret_addr)
-            {
-                //AE/SE versions remain the same
-                push(rbx);
-                sub(rsp, 0x20);
-
-                mov(rax, ret_addr);
-                jmp(rax);
-            }
-        } static code{ return_addr };
-
-        auto& trampoline = SKSE::GetTrampoline();
-
-        auto placed_call = IsCallOrJump(hook_addr) > 0;
-
-        auto place_query = trampoline.write_branch<5>(hook_addr, (uintptr_t)thunk);
-
-        if (!placed_call)
-            func = (uintptr_t)code.getCode();
-        else
-            func = place_query;
+        func = Hooks::write_detour(sites[0], thunk);
 
         logger::info("Condition_HasKeywordHook complete...");
-        //*/
     }
 
     static bool thunk(RE::TESObjectREFR* a_this, RE::BGSKeyword* a2, void* a3, double* a4)
     {
+        CARP_PROFILE_SCOPE("Condition_HasKeywordHook");
+
         if (a2 && a2->formEditorID.c_str() && stricmp(a2->formEditorID.c_str(), installedString.data()) == 0)
         {
             //Later, this value can also mean didn't install right if it's -1
@@ -1564,6 +3113,13 @@ void AddSettings()
         collection->InsertSetting(capSpeed);
         collection->InsertSetting(speedTaper);
         collection->InsertSetting(maxSpeed);
+
+        for (auto& setting : weaponTypeSpeed)
+            collection->InsertSetting(setting);
+
+        collection->InsertSetting(tierFullProcess);
+        collection->InsertSetting(tierRefresh);
+        collection->InsertSetting(auditBudget);
     }
     {
         auto* collection = RE::INISettingCollection::GetSingleton();
@@ -1572,6 +3128,26 @@ void AddSettings()
     }
 }
 
+//Every hook, by when it goes in.
+using LoadHooks = Hooks::HookSet<
+    WeaponSpeedMultHook,
+    CreateActorValueInfoHook,
+    ValueEffectStartHook,
+    ValueEffectFinishHook,
+    ValueEffect_FinishLoadGameHook,
+    GetActorValueHook,
+    GetActorValueModifierHook,
+    ActorConstructorHook,
+    Actor__FinishLoadGameHook,
+    Condition_HasKeywordHook,
+    PlayerUpdateHook,
+    AnimationEventHook>;
+
+using PostLoadHooks = Hooks::HookSet<SetEffectivenessHook>;
+
+using DataLoadedHooks = Hooks::HookSet<SetBaseActorValueHook, ModBaseActorValueHook>;
+
+
 void InitializeMessaging() {
     //Make a function in AVG so that one can get the effective speed mult(which is the speed mult that you'd see when swings happen).
     
@@ -1581,12 +3157,22 @@ void InitializeMessaging() {
     if (!GetMessagingInterface()->RegisterListener([](MessagingInterface::Message* message) {
         switch (message->type) {
         case MessagingInterface::kPostLoad://If this is in post load it can be after scrambled bugs but before  po3's.
-            SetEffectivenessHook::Patch();//
+            PostLoadHooks::Install();
+            Hooks::Commit("PostLoad");
             break;
 
         case MessagingInterface::kDataLoaded:
-            SetBaseActorValueHook::Patch();//
-            ModBaseActorValueHook::Patch();//
+            DataLoadedHooks::Install();
+            Hooks::Commit("DataLoaded");
+
+            CurveProfiles::Load();
+
+            SettingsEpoch::Refresh(true);
+
+            WeaponOverrides::Load();
+
+            //Whatever the records say right now, see EffectClasses for what that misses.
+            EffectClasses::Build();
 
             if (auto buffer = RE::TESForm::LookupByID(0x01ADA616))
             {
@@ -1600,9 +3186,27 @@ void InitializeMessaging() {
                 }
 
             }
+
+            RE::ScriptEventSourceHolder::GetSingleton()->AddEventSink<RE::TESEquipEvent>(EquipEventHandler::GetSingleton());
             
             break;
 
+        case MessagingInterface::kPreLoadGame:
+        case MessagingInterface::kNewGame:
+            SpeedChangeEvents::Clear();
+            AttackPins::Clear();
+            EvaluationTiers::Clear();
+            TagAuditor::Clear();
+            TaggedActors::Clear();
+            break;
+
+        case MessagingInterface::kSaveGame:
+            EvaluationTiers::Report();
+            SpeedEffectFilter::Report();
+            TagAuditor::Report();
+            CARP_PROFILE_REPORT();
+            break;
+
         case MessagingInterface::kPostLoadGame:
             if (simonSpeedVariable && simonSpeedVariable->value == 0.f) {
                 logger::debug("Setting SimonrimAttackSpeedFix global to 1.");
@@ -1621,24 +3225,14 @@ SKSEPluginLoad(const LoadInterface* skse) {
 
     InitializeLogging();
     InitializeMessaging();
-    auto& trampoline = SKSE::GetTrampoline();
+    //Every call/branch site the plugin will ever write, including the ones placed later at PostLoad/DataLoaded.
+    constexpr size_t trampoline_size = Hooks::TrampolineBudget<LoadHooks, PostLoadHooks, DataLoadedHooks>();
 
-    //SKSE::AllocTrampoline(98);//Not implementing the hook that requires this
-    SKSE::AllocTrampoline(126);//+14 for 1 unimplemented hook.
+    SKSE::AllocTrampoline(trampoline_size);
     
-    WeaponSpeedMultHook::Patch();
-    CreateActorValueInfoHook::Patch();
-    ValueEffectStartHook::Patch();
-    ValueEffectFinishHook::Patch();
-    ValueEffect_FinishLoadGameHook::Patch();
-    GetActorValueHook::Patch();
-    GetActorValueModifierHook::Patch();
-    //SetBaseActorValueHook::Patch();
-    //ModBaseActorValueHook::Patch();
-
-    ActorConstructorHook::Patch();
-    Actor__FinishLoadGameHook::Patch();
-    Condition_HasKeywordHook::Patch();
+    LoadHooks::Install();
+
+    Hooks::Commit("Load");
     
 
     auto papyrus = SKSE::GetPapyrusInterface();
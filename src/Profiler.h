@@ -0,0 +1,226 @@
+#pragma once
+
+//Hook cost counters. Only built with CARP_PROFILE defined (the CARP_PROFILE cmake option), otherwise every scope compiles
+// away to nothing. Scopes cover the work CARP adds inside a thunk, so they go after the call to the original. That leaves
+// out getting into the thunk at all (the trampoline stub, the vtable slot, the relocated prologue), which is the same
+// every call and measured on its own by the dispatch cases in carp_bench (tests/bench/DispatchBench.cpp).
+//
+// Everything counted inside a frame is also added up per frame (the outermost scope only, so a hook that ends up inside
+// another isn't counted twice), which gives the p50/p99 of what CARP costs a frame over the last k_frameHistory frames.
+//
+// Each report also goes out as json next to the log, for tools/compare_profile.py to hold up against an earlier one.
+
+#ifdef CARP_PROFILE
+
+#include <intrin.h>
+
+#include "nlohmann/json.hpp"
+
+namespace Profiler
+{
+    struct Counter
+    {
+        std::string name;
+        std::atomic<uint64_t> calls{ 0 };
+        std::atomic<uint64_t> ticks{ 0 };
+    };
+
+
+    //About a minute at 60fps.
+    constexpr size_t k_frameHistory = 4096;
+
+
+    namespace detail
+    {
+        inline std::mutex lock;
+        inline std::deque<Counter> counters;
+
+        inline std::atomic<uint64_t> frameTicks{ 0 };
+        inline thread_local uint32_t depth = 0;
+
+        inline std::array<uint64_t, k_frameHistory> frames{};
+        inline size_t frameCount = 0;
+
+        inline const uint64_t startTicks = __rdtsc();
+        inline const auto startTime = std::chrono::steady_clock::now();
+    }
+
+
+    inline Counter& Register(std::string name)
+    {
+        std::lock_guard guard{ detail::lock };
+        auto& counter = detail::counters.emplace_back();
+        counter.name = std::move(name);
+        return counter;
+    }
+
+
+    struct Scope
+    {
+        Counter& counter;
+        uint64_t start = (detail::depth++, __rdtsc());
+
+        ~Scope()
+        {
+            auto ticks = __rdtsc() - start;
+
+            counter.calls.fetch_add(1, std::memory_order_relaxed);
+            counter.ticks.fetch_add(ticks, std::memory_order_relaxed);
+
+            if (--detail::depth == 0)
+                detail::frameTicks.fetch_add(ticks, std::memory_order_relaxed);
+        }
+    };
+
+
+    //Once a frame, closes off what the frame cost.
+    inline void EndFrame()
+    {
+        auto ticks = detail::frameTicks.exchange(0, std::memory_order_relaxed);
+
+        std::lock_guard guard{ detail::lock };
+        detail::frames[detail::frameCount++ % k_frameHistory] = ticks;
+    }
+
+
+    struct FrameStats
+    {
+        size_t count = 0;
+        double p50 = 0;
+        double p99 = 0;
+        double max = 0;
+    };
+
+    //In nanoseconds, over the frames still in the history. Needs the lock held.
+    inline FrameStats GetFrameStats(double rate)
+    {
+        FrameStats stats;
+
+        stats.count = std::min(detail::frameCount, k_frameHistory);
+
+        if (!stats.count)
+            return stats;
+
+        std::vector<uint64_t> sorted{ detail::frames.begin(), detail::frames.begin() + stats.count };
+
+        auto at = [&](double fraction) {
+            auto index = std::min(static_cast<size_t>(fraction * stats.count), stats.count - 1);
+            std::ranges::nth_element(sorted, sorted.begin() + index);
+            return sorted[index] / rate;
+        };
+
+        stats.p50 = at(0.50);
+        stats.p99 = at(0.99);
+        stats.max = *std::ranges::max_element(sorted) / rate;
+
+        return stats;
+    }
+
+
+    //Ticks per nanosecond, measured over the life of the plugin so far.
+    inline double TicksPerNano()
+    {
+        auto ticks = __rdtsc() - detail::startTicks;
+        auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - detail::startTime).count();
+        return nanos ? static_cast<double>(ticks) / nanos : 1.0;
+    }
+
+
+    //Overwritten every report, so it's always the whole session up to the last save.
+    inline void WriteJson(double rate, const FrameStats& frames)
+    {
+        auto path = SKSE::log::log_directory();
+
+        if (!path)
+            return;
+
+        *path /= SKSE::PluginDeclaration::GetSingleton()->GetName();
+        *path += L"_profile.json";
+
+        nlohmann::json counters = nlohmann::json::object();
+
+        for (auto& counter : detail::counters) {
+            auto calls = counter.calls.load(std::memory_order_relaxed);
+            auto ticks = counter.ticks.load(std::memory_order_relaxed);
+
+            if (!calls)
+                continue;
+
+            counters[counter.name] = {
+                { "calls", calls },
+                { "ticks", ticks },
+                { "nsPerCall", ticks / rate / calls },
+                { "totalMs", ticks / rate / 1e6 },
+            };
+        }
+
+        nlohmann::json report = {
+            { "version", SKSE::PluginDeclaration::GetSingleton()->GetVersion().string() },
+            { "ticksPerNano", rate },
+            { "frames", {
+                { "count", frames.count },
+                { "p50Ns", frames.p50 },
+                { "p99Ns", frames.p99 },
+                { "maxNs", frames.max },
+            } },
+            { "counters", std::move(counters) },
+        };
+
+        std::ofstream file{ *path };
+
+        if (!file) {
+            logger::warn("Couldn't write the hook profile to {}.", path->string());
+            return;
+        }
+
+        file << report.dump(4);
+    }
+
+
+    inline void Report()
+    {
+        std::lock_guard guard{ detail::lock };
+
+        auto rate = TicksPerNano();
+
+        auto frames = GetFrameStats(rate);
+
+        logger::info("Hook profile ({:.2f} ticks/ns):", rate);
+
+        if (frames.count)
+            logger::info("    per frame over the last {}: p50 {:.1f}us, p99 {:.1f}us, max {:.1f}us",
+                frames.count, frames.p50 / 1e3, frames.p99 / 1e3, frames.max / 1e3);
+
+        for (auto& counter : detail::counters) {
+            auto calls = counter.calls.load(std::memory_order_relaxed);
+            auto ticks = counter.ticks.load(std::memory_order_relaxed);
+
+            if (!calls)
+                continue;
+
+            logger::info("    {}: {} calls, {:.1f} ticks/call ({:.1f}ns), {:.3f}ms total",
+                counter.name, calls, static_cast<double>(ticks) / calls, ticks / rate / calls, ticks / rate / 1e6);
+        }
+
+        WriteJson(rate, frames);
+    }
+}
+
+#define CARP_PROFILE_CONCAT_IMPL(a, b) a##b
+#define CARP_PROFILE_CONCAT(a, b) CARP_PROFILE_CONCAT_IMPL(a, b)
+
+#define CARP_PROFILE_SCOPE(...) \
+    static Profiler::Counter& CARP_PROFILE_CONCAT(_profileCounter, __LINE__) = Profiler::Register(__VA_ARGS__); \
+    Profiler::Scope CARP_PROFILE_CONCAT(_profileScope, __LINE__){ CARP_PROFILE_CONCAT(_profileCounter, __LINE__) }
+
+#define CARP_PROFILE_REPORT() Profiler::Report()
+
+#define CARP_PROFILE_FRAME() Profiler::EndFrame()
+
+#else
+
+#define CARP_PROFILE_SCOPE(...)
+#define CARP_PROFILE_REPORT()
+#define CARP_PROFILE_FRAME()
+
+#endif
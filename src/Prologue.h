@@ -0,0 +1,532 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <vector>
+
+//Length decoder and relocator for x86-64 function prologues. This is what lets a branch hook copy what ever it overwrites into
+// a trampoline instead of me hand writing "push rbx; sub rsp, 0x20" and hoping the function never changes. It doesn't need
+// to know what an instruction does, only how long it is, if it addresses relative to RIP, and if it's a relative branch.
+// No game types in here on purpose, it only ever looks at bytes.
+
+namespace Prologue
+{
+    enum struct BranchType : uint8_t
+    {
+        None,
+        Call,           //E8 rel32
+        Jump,           //E9 rel32, EB rel8
+        Conditional,    //70-7F rel8, 0F 80-8F rel32
+        Loop,           //E0-E3 rel8, can't be relocated.
+    };
+
+    struct Instruction
+    {
+        uint8_t length = 0;
+
+        //Offset within the instruction of the displacement, for RIP relative memory or relative branches. Zero if neither.
+        uint8_t relOffset = 0;
+        uint8_t relSize = 0;
+
+        BranchType branch = BranchType::None;
+        uint8_t condition = 0;//low nibble of a conditional branch
+
+        bool ripRelative = false;
+
+        //ret, ret imm16, or a jmp through a register or memory. Nothing after it runs.
+        bool endsFlow = false;
+    };
+
+
+    namespace detail
+    {
+        enum : uint8_t
+        {
+            kNone = 0,
+            kModRM = 1 << 0,
+            kImm8 = 1 << 1,
+            kImmZ = 1 << 2,     //imm16 with 66, otherwise imm32
+            kImm16 = 1 << 3,
+            kRel8 = 1 << 4,
+            kRel32 = 1 << 5,
+            kGroup3 = 1 << 6,   //F6/F7, immediate only for /0 and /1
+            kInvalid = 1 << 7,
+        };
+
+
+        constexpr std::array<uint8_t, 256> MakeOneByteTable()
+        {
+            std::array<uint8_t, 256> table{};
+
+            //The arithmetic block, 00-3F. Each row of 8 is r/m,r/m,r,r, al imm8, eAX immz, then 2 odd ones.
+            for (int row = 0; row < 0x40; row += 8) {
+                table[row + 0] = table[row + 1] = table[row + 2] = table[row + 3] = kModRM;
+                table[row + 4] = kImm8;
+                table[row + 5] = kImmZ;
+            }
+
+            //push/pop segment, daa/das/aaa/aas, and the segment prefixes that would have been caught earlier.
+            for (int op : { 0x06, 0x07, 0x0E, 0x16, 0x17, 0x1E, 0x1F, 0x27, 0x2F, 0x37, 0x3F })
+                table[op] = kInvalid;
+
+            //0x0F is handled separately.
+
+            //40-5F are REX (handled earlier) and push/pop reg, no operands.
+
+            table[0x60] = table[0x61] = table[0x62] = kInvalid;
+            table[0x63] = kModRM;
+            table[0x68] = kImmZ;
+            table[0x69] = kModRM | kImmZ;
+            table[0x6A] = kImm8;
+            table[0x6B] = kModRM | kImm8;
+
+            for (int op = 0x70; op <= 0x7F; op++)
+                table[op] = kRel8;
+
+            table[0x80] = kModRM | kImm8;
+            table[0x81] = kModRM | kImmZ;
+            table[0x82] = kInvalid;
+            table[0x83] = kModRM | kImm8;
+
+            for (int op = 0x84; op <= 0x8F; op++)
+                table[op] = kModRM;
+
+            table[0x9A] = kInvalid;
+
+            //A0-A3 are moffs and get sorted out in Decode.
+            table[0xA8] = kImm8;
+            table[0xA9] = kImmZ;
+
+            for (int op = 0xB0; op <= 0xB7; op++)
+                table[op] = kImm8;
+
+            //B8-BF, same as A0-A3.
+            for (int op = 0xB8; op <= 0xBF; op++)
+                table[op] = kImmZ;
+
+            table[0xC0] = table[0xC1] = kModRM | kImm8;
+            table[0xC2] = kImm16;
+            table[0xC6] = kModRM | kImm8;
+            table[0xC7] = kModRM | kImmZ;
+            table[0xC8] = kImm16 | kImm8;
+            table[0xCA] = kImm16;
+            table[0xCD] = kImm8;
+            table[0xCE] = kInvalid;
+
+            for (int op = 0xD0; op <= 0xD3; op++)
+                table[op] = kModRM;
+
+            table[0xD4] = table[0xD5] = table[0xD6] = kInvalid;
+
+            for (int op = 0xD8; op <= 0xDF; op++)
+                table[op] = kModRM;
+
+            for (int op = 0xE0; op <= 0xE3; op++)
+                table[op] = kRel8;
+
+            for (int op = 0xE4; op <= 0xE7; op++)
+                table[op] = kImm8;
+
+            table[0xE8] = table[0xE9] = kRel32;
+            table[0xEA] = kInvalid;
+            table[0xEB] = kRel8;
+
+            table[0xF6] = table[0xF7] = kModRM | kGroup3;
+            table[0xFE] = table[0xFF] = kModRM;
+
+            return table;
+        }
+
+        constexpr std::array<uint8_t, 256> MakeTwoByteTable()
+        {
+            std::array<uint8_t, 256> table{};
+
+            table.fill(kModRM);
+
+            for (int op : { 0x05, 0x06, 0x07, 0x08, 0x09, 0x0B, 0x0E, 0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x37, 0x77, 0xA0, 0xA1, 0xA2, 0xA8, 0xA9, 0xAA })
+                table[op] = kNone;
+
+            for (int op : { 0x04, 0x0A, 0x0C, 0x0F, 0x24, 0x25, 0x26, 0x27, 0x36, 0x39, 0x3B, 0x3C, 0x3D, 0x3E, 0x3F, 0x7A, 0x7B, 0xA6, 0xA7, 0xFF })
+                table[op] = kInvalid;
+
+            for (int op = 0x70; op <= 0x73; op++)
+                table[op] = kModRM | kImm8;
+
+            for (int op = 0x80; op <= 0x8F; op++)
+                table[op] = kRel32;
+
+            for (int op : { 0xA4, 0xAC, 0xBA, 0xC2, 0xC4, 0xC5, 0xC6 })
+                table[op] = kModRM | kImm8;
+
+            for (int op = 0xC8; op <= 0xCF; op++)
+                table[op] = kNone;
+
+            return table;
+        }
+
+        inline constexpr auto oneByte = MakeOneByteTable();
+        inline constexpr auto twoByte = MakeTwoByteTable();
+    }
+
+
+
+    //Decodes the length and relative operands of the instruction at code. Returns nothing for what ever it doesn't understand,
+    // which callers should treat as "can't hook here" rather than guess.
+    inline std::optional<Instruction> Decode(const uint8_t* code, size_t available = 15)
+    {
+        using namespace detail;
+
+        constexpr size_t k_maxLength = 15;
+
+        Instruction result{};
+
+        size_t limit = available < k_maxLength ? available : k_maxLength;
+        size_t i = 0;
+
+        bool operand_size = false;
+        bool address_size = false;
+        bool rex_w = false;
+
+        auto has = [&](size_t n) { return i + n <= limit; };
+
+        //Legacy prefixes
+        while (has(1)) {
+            switch (code[i]) {
+            case 0x66:
+                operand_size = true;
+                break;
+            case 0x67:
+                address_size = true;
+                break;
+            case 0xF0: case 0xF2: case 0xF3:
+            case 0x2E: case 0x36: case 0x3E: case 0x26: case 0x64: case 0x65:
+                break;
+            default:
+                goto prefixes_done;
+            }
+            i++;
+        }
+    prefixes_done:
+
+        if (!has(1))
+            return std::nullopt;
+
+        //REX
+        if ((code[i] & 0xF0) == 0x40) {
+            rex_w = code[i] & 0x8;
+            i++;
+
+            if (!has(1))
+                return std::nullopt;
+        }
+
+        uint8_t flags;
+        uint8_t opcode = code[i++];
+
+        bool imm8_suffix = false;//For the VEX 0F3A map
+        bool group5 = false;//FF, where /4 and /5 are jumps
+
+        if (opcode == 0xC4 || opcode == 0xC5) {
+            //VEX, always in long mode.
+            size_t map = 1;
+
+            if (opcode == 0xC5) {
+                if (!has(1))
+                    return std::nullopt;
+                i += 1;
+            }
+            else {
+                if (!has(2))
+                    return std::nullopt;
+                map = code[i] & 0x1F;
+                i += 2;
+            }
+
+            if (map < 1 || map > 3 || !has(1))
+                return std::nullopt;
+
+            opcode = code[i++];
+
+            if (map == 1) {
+                //Same lengths as the legacy 0F map, except nothing here branches.
+                flags = twoByte[opcode];
+
+                if (flags & kRel32)
+                    return std::nullopt;
+            }
+            else {
+                flags = kModRM;
+                imm8_suffix = map == 3;
+            }
+        }
+        else if (opcode == 0x0F) {
+            if (!has(1))
+                return std::nullopt;
+
+            opcode = code[i++];
+
+            if (opcode == 0x38 || opcode == 0x3A) {
+                if (!has(1))
+                    return std::nullopt;
+
+                imm8_suffix = opcode == 0x3A;
+                opcode = code[i++];
+                flags = kModRM;
+            }
+            else {
+                flags = twoByte[opcode];
+
+                if (opcode >= 0x80 && opcode <= 0x8F) {
+                    result.branch = BranchType::Conditional;
+                    result.condition = opcode & 0xF;
+                }
+            }
+        }
+        else {
+            flags = oneByte[opcode];
+
+            switch (opcode) {
+            case 0xA0: case 0xA1: case 0xA2: case 0xA3:
+                //moffs, absolute so nothing to relocate.
+                i += address_size ? 4 : 8;
+                break;
+
+            case 0xB8: case 0xB9: case 0xBA: case 0xBB: case 0xBC: case 0xBD: case 0xBE: case 0xBF:
+                if (rex_w) {
+                    flags = kNone;
+                    i += 8;
+                }
+                break;
+
+            case 0xE8:
+                result.branch = BranchType::Call;
+                break;
+
+            case 0xE9: case 0xEB:
+                result.branch = BranchType::Jump;
+                break;
+
+            case 0xE0: case 0xE1: case 0xE2: case 0xE3:
+                result.branch = BranchType::Loop;
+                break;
+
+            case 0xC2: case 0xC3: case 0xCA: case 0xCB:
+                result.endsFlow = true;
+                break;
+
+            case 0xFF:
+                group5 = true;
+                break;
+
+            default:
+                if (opcode >= 0x70 && opcode <= 0x7F) {
+                    result.branch = BranchType::Conditional;
+                    result.condition = opcode & 0xF;
+                }
+                break;
+            }
+        }
+
+        if (flags & kInvalid)
+            return std::nullopt;
+
+        if (flags & kModRM) {
+            if (!has(1))
+                return std::nullopt;
+
+            uint8_t modrm = code[i++];
+            uint8_t mod = modrm >> 6;
+            uint8_t reg = (modrm >> 3) & 0x7;
+            uint8_t rm = modrm & 0x7;
+
+            if (mod != 3) {
+                if (rm == 4) {
+                    if (!has(1))
+                        return std::nullopt;
+
+                    uint8_t sib = code[i++];
+
+                    if (mod == 0 && (sib & 0x7) == 5)
+                        i += 4;
+                }
+
+                if (mod == 0 && rm == 5) {
+                    result.ripRelative = true;
+                    result.relOffset = static_cast<uint8_t>(i);
+                    result.relSize = 4;
+                    i += 4;
+                }
+                else if (mod == 1) {
+                    i += 1;
+                }
+                else if (mod == 2) {
+                    i += 4;
+                }
+            }
+
+            if (group5 && (reg == 4 || reg == 5))
+                result.endsFlow = true;
+
+            if ((flags & kGroup3) && reg <= 1)
+                flags |= opcode == 0xF6 ? kImm8 : kImmZ;
+        }
+
+        if (flags & kImm16)
+            i += 2;
+
+        if (flags & kImmZ)
+            i += operand_size ? 2 : 4;
+
+        if ((flags & kImm8) || imm8_suffix)
+            i += 1;
+
+        if (flags & kRel8) {
+            result.relOffset = static_cast<uint8_t>(i);
+            result.relSize = 1;
+            i += 1;
+        }
+
+        if (flags & kRel32) {
+            result.relOffset = static_cast<uint8_t>(i);
+            result.relSize = 4;
+            i += 4;
+        }
+
+        if (i > limit)
+            return std::nullopt;
+
+        result.length = static_cast<uint8_t>(i);
+        return result;
+    }
+
+
+    //Where a relative operand points, as an absolute address for code that lives at "address".
+    inline uintptr_t GetTarget(const uint8_t* code, uintptr_t address, const Instruction& instruction)
+    {
+        if (!instruction.relSize)
+            return address + instruction.length;
+
+        //A byte at a time, so nothing is read past an operand that's only one byte long.
+        uint64_t raw = 0;
+
+        for (size_t i = 0; i < instruction.relSize; i++)
+            raw |= static_cast<uint64_t>(code[instruction.relOffset + i]) << (i * 8);
+
+        int shift = 64 - instruction.relSize * 8;
+        auto disp = static_cast<int64_t>(raw << shift) >> shift;
+
+        return address + instruction.length + disp;
+    }
+
+
+
+    struct Relocation
+    {
+        std::vector<uint8_t> code;
+
+        //How many bytes were taken from the source. Everything past the hook's jump up to this should be padded out.
+        size_t consumed = 0;
+    };
+
+
+    namespace detail
+    {
+        inline void EmitAbsoluteJump(std::vector<uint8_t>& out, uintptr_t target)
+        {
+            //jmp [rip]; dq target
+            const uint8_t jmp[]{ 0xFF, 0x25, 0x00, 0x00, 0x00, 0x00 };
+            out.insert(out.end(), std::begin(jmp), std::end(jmp));
+            out.insert(out.end(), reinterpret_cast<uint8_t*>(&target), reinterpret_cast<uint8_t*>(&target) + sizeof(target));
+        }
+
+        inline void EmitAbsoluteCall(std::vector<uint8_t>& out, uintptr_t target)
+        {
+            //call [rip+2]; jmp +8; dq target
+            const uint8_t call[]{ 0xFF, 0x15, 0x02, 0x00, 0x00, 0x00, 0xEB, 0x08 };
+            out.insert(out.end(), std::begin(call), std::end(call));
+            out.insert(out.end(), reinterpret_cast<uint8_t*>(&target), reinterpret_cast<uint8_t*>(&target) + sizeof(target));
+        }
+    }
+
+
+    //Copies whole instructions from code (which lives at src) until at least min_length bytes are covered, rewritten so they
+    // can run at dst, followed by a jump back to the rest of the function. Relative branches become absolute ones, RIP relative
+    // operands get their displacement fixed up (which means dst must be within 2GB of the source, the trampoline always is).
+    inline std::optional<Relocation> Relocate(const uint8_t* code, uintptr_t src, size_t min_length, uintptr_t dst, size_t max_size = 0x80)
+    {
+        Relocation result;
+
+        auto& out = result.code;
+
+        bool falls_through = true;
+
+        while (result.consumed < min_length) {
+            const uint8_t* at = code + result.consumed;
+            uintptr_t address = src + result.consumed;
+
+            auto instruction = Decode(at);
+
+            if (!instruction)
+                return std::nullopt;
+
+            switch (instruction->branch) {
+            case BranchType::Loop:
+                return std::nullopt;
+
+            case BranchType::Call:
+                detail::EmitAbsoluteCall(out, GetTarget(at, address, *instruction));
+                falls_through = true;
+                break;
+
+            case BranchType::Jump:
+                detail::EmitAbsoluteJump(out, GetTarget(at, address, *instruction));
+                falls_through = false;
+                break;
+
+            case BranchType::Conditional:
+            {
+                //Inverted short jcc over an absolute jump to the original target.
+                out.push_back(static_cast<uint8_t>(0x70 | (instruction->condition ^ 1)));
+                out.push_back(0x0E);
+                detail::EmitAbsoluteJump(out, GetTarget(at, address, *instruction));
+                falls_through = true;
+                break;
+            }
+
+            default:
+            {
+                size_t start = out.size();
+                out.insert(out.end(), at, at + instruction->length);
+
+                if (instruction->ripRelative) {
+                    auto target = GetTarget(at, address, *instruction);
+                    auto new_end = static_cast<int64_t>(dst + start + instruction->length);
+                    auto disp = static_cast<int64_t>(target) - new_end;
+
+                    if (disp < INT32_MIN || disp > INT32_MAX)
+                        return std::nullopt;
+
+                    auto disp32 = static_cast<int32_t>(disp);
+                    std::memcpy(out.data() + start + instruction->relOffset, &disp32, sizeof(disp32));
+                }
+
+                //A ret or jmp through a register or memory means there's nothing after this to return to.
+                falls_through = !instruction->endsFlow;
+                break;
+            }
+            }
+
+            result.consumed += instruction->length;
+        }
+
+        if (falls_through)
+            detail::EmitAbsoluteJump(out, src + result.consumed);
+
+        if (out.size() > max_size)
+            return std::nullopt;
+
+        return result;
+    }
+}
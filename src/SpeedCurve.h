@@ -0,0 +1,98 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+
+//The numbers side of the effective speed, what happens to a speed once it's been read off the actor. Min and max, the built
+// in taper past the cap, or a user curve in its place.
+//
+// Doesn't know anything about the game.
+
+namespace SpeedCurve
+{
+    //An undisclosed value that serves as the very limits to how slow an attack can be. Made to ensure that low values never mean normal attack speed.
+    constexpr float k_closeToZero = 0.01f;
+
+    //What a custom curve is handed, ordered the same as CurveExpression::Var.
+    using Inputs = std::array<float, 6>;
+
+
+    //The curve settings, cleaned up once when they're set instead of every time someone swings. The only part that still
+    // needs doing per call is clamping the min to the base speed.
+    struct Params
+    {
+        float minSpeed = 0.5f;
+        float capSpeed = 2.f;
+        float speedTaper = 0.2f;
+        float maxSpeed = 3.f;
+
+        void Set(float min, float cap, float taper, float max)
+        {
+            maxSpeed = !max ? std::numeric_limits<float>::infinity() : std::fmax(max, 1.f);//If zero, no maximum
+            minSpeed = std::fmax(min, k_closeToZero);
+            speedTaper = std::fmin(taper, 1.f);//Not allowed to exceed 1. Gets fucky if it does.
+            capSpeed = cap;
+        }
+    };
+
+
+    //Past the cap, speed grows with the root of what's over it, scaled by the taper.
+    inline float Taper(float speed, float cap_speed, float speed_taper)
+    {
+        if (speed <= cap_speed)
+            return speed;
+
+        if (speed_taper <= 0)
+            return cap_speed;
+
+        float extra_speed = speed - cap_speed;
+
+        return cap_speed + std::sqrt(extra_speed) * std::pow(speed_taper, 1.0f / extra_speed);
+    }
+
+
+    //custom, when given, is called with the Inputs and replaces the taper.
+    template <class Custom = std::nullptr_t>
+    float Apply(const Params& curve, float speed, float base_av, const Custom& custom = nullptr)
+    {
+        if (base_av == 0)
+            base_av = k_closeToZero;
+
+        float max_speed = curve.maxSpeed;
+
+        //It's absolutely minimum value is a save value away from 0
+        // additionally, your minimum speed can never be higher than your base attack speed.
+        // this is allowed because no base game system ever messes with that, it's an active choice on the part of a developer or player. As such, let em.
+        float min_speed = std::clamp(curve.minSpeed, k_closeToZero, base_av);
+        float speed_taper = curve.speedTaper;
+        float cap_speed = !curve.capSpeed ? std::clamp(curve.capSpeed, min_speed, max_speed) : 0;
+
+
+        if (speed <= min_speed)
+            return min_speed;
+
+
+        if constexpr (!std::is_same_v<Custom, std::nullptr_t>)
+        {
+            speed = custom(Inputs{ speed, base_av, curve.minSpeed, curve.capSpeed, curve.speedTaper, curve.maxSpeed });
+
+            //Catches NaN too, a user curve can't go under the min any more than the built in one can.
+            if (!(speed > min_speed))
+                return min_speed;
+        }
+        else if (cap_speed)
+        {
+            speed = Taper(speed, cap_speed, speed_taper);
+        }
+
+
+        if (speed >= max_speed)
+            return max_speed;
+
+        return speed;
+    }
+}
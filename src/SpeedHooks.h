@@ -0,0 +1,314 @@
+#pragma once
+
+#include "ActorSlots.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <optional>
+
+//How an actor's effective weapon speed gets worked out, from WeaponSpeedMultHook down to the perk entry, kept apart from
+// the game so the same bodies run in the plugin and in the tests. Each struct here keeps its own state per Game, so the
+// tests' stand-in never shares a cache with anything else.
+//
+// Game is a set of static functions over whatever stands for the game (GameAccess in Main.cpp, Host::Game in the tests):
+//
+//  Owner, Actor, Weapon            what the engine asks about, the actor behind it, and the weapon in the asked for hand
+//  AsActor(owner)                  the actor, or null for an owner that isn't one
+//  GetActorValue(owner, right)     the speed actor value, GetBaseActorValue(owner, right) its base
+//  IsPlayer(owner)                 only used to log the player's curve
+//  FormID(actor), Lookup(id)       and back, null for an actor that's gone
+//  IsAttacking(actor)              anywhere in an attack, IsDrawing(actor) in the draw at the start of one
+//  AttackSpeedPerk(actor, right, speed&)   the AttackSpeed perk entry for what's in the hand
+//  Curve(actor), ApplyCurve(curve, speed, base, is_player)   the actor's speed curve and putting a speed through it
+//  ProcessLevel(actor)             the AI process level, nothing if it isn't processed
+//  TierFullProcess(), TierRefresh() the settings
+//  DualWielding(actor)             one handers or fists in both hands, so both get asked for one after the other
+//  WeaponTypeMult(weapon), WeaponSpeed(weapon)   what the speed gets multiplied by at the end
+
+namespace SpeedHooks
+{
+    //The AttackSpeed perk entry's result, held for the rest of the attack once it's been worked out. The engine asks for the speed
+    // over and over during a swing, this makes every ask after the first a lookup and keeps the perks at one strength the whole
+    // way. What's held is how much the perks changed the speed by, not the speed, so an effect landing mid swing still moves
+    // it, and the change events see the change. That's exact for perks that multiply, ones that add get scaled along with the rest.
+    // Pins go on "attackStop" from the actor's animation graph. The graph has no matching start event to hang the other end
+    // on, so the frame sweep also drops pins for actors that stopped attacking without saying so, or that have gone back to
+    // drawing a new attack in a combo. Either way the actor's handed to before_release first, dropping the pin changes its speed.
+    template <class Game>
+    struct AttackPins
+    {
+        using Actor = typename Game::Actor;
+
+        struct Pin
+        {
+            float ratio[2]{};
+            bool set[2]{};
+            bool pastDraw = false;
+        };
+
+        static bool Find(Actor* actor, bool right, float& speed)
+        {
+            auto pin = pins.find(Game::FormID(actor));
+
+            if (!pin || !pin->set[!right])
+                return false;
+
+            speed *= pin->ratio[!right];
+            return true;
+        }
+
+        //Nothing's held for a speed of 0, there's no ratio to take from it.
+        static void Set(Actor* actor, bool right, float before, float after)
+        {
+            if (!before)
+                return;
+
+            Pin pin = pins.find(Game::FormID(actor)).value_or(Pin{});
+
+            pin.set[!right] = true;
+            pin.ratio[!right] = after / before;
+
+            pins.set(Game::FormID(actor), pin);
+        }
+
+        template <class F>
+        static void Release(Actor* actor, F&& before_release)
+        {
+            if (!pins.find(Game::FormID(actor)))
+                return;
+
+            before_release(actor);
+            pins.erase(Game::FormID(actor));
+        }
+
+        //Once a frame.
+        template <class F>
+        static void Sweep(F&& before_release)
+        {
+            pins.for_each([&](uint32_t id, Pin pin) {
+                auto actor = Game::Lookup(id);
+
+                if (!actor) {
+                    pins.erase(id);
+                    return;
+                }
+
+                bool attacking = Game::IsAttacking(actor);
+                bool draw = attacking && Game::IsDrawing(actor);
+
+                if (!attacking || (draw && pin.pastDraw)) {
+                    before_release(actor);
+                    pins.erase(id);
+                }
+                else if (!draw && !pin.pastDraw) {
+                    pin.pastDraw = true;
+                    pins.set(id, pin);
+                }
+            });
+        }
+
+        static void Clear()
+        {
+            pins.clear();
+        }
+
+        static inline ActorSlots<Pin, 256> pins;
+    };
+
+
+    //Runs the AttackSpeed perk entry for what ever is in the given hand, once per attack.
+    template <class Game>
+    void ApplyAttackSpeedPerks(typename Game::Actor* actor, bool right, float& speed)
+    {
+        if (AttackPins<Game>::Find(actor, right, speed))
+            return;
+
+        float before = speed;
+
+        Game::AttackSpeedPerk(actor, right, speed);
+
+        AttackPins<Game>::Set(actor, right, before, speed);
+    }
+
+
+    template <class Game>
+    float GetEffectiveSpeed(typename Game::Owner* target, bool right)
+    {
+        float speed = Game::GetActorValue(target, right);
+
+        auto actor = Game::AsActor(target);
+
+        const auto& curve = Game::Curve(actor);
+
+        //TODO:Check the performance of this, if by chance it makes things slow, I can curb it by only firing if someone is in a non-idle attack state.
+        if (actor && Game::IsAttacking(actor))
+            ApplyAttackSpeedPerks<Game>(actor, right, speed);
+
+        return Game::ApplyCurve(curve, speed, Game::GetBaseActorValue(target, right), Game::IsPlayer(target));
+    }
+
+    //Right then left, with the cast, curve pick and attack check done once for both. The perk entry still goes once per hand,
+    // it takes one weapon and changes the value in place so there's no sharing it.
+    template <class Game>
+    std::array<float, 2> GetBothEffectiveSpeeds(typename Game::Owner* target, bool perks = true)
+    {
+        std::array<float, 2> speeds{ Game::GetActorValue(target, true), Game::GetActorValue(target, false) };
+
+        auto actor = Game::AsActor(target);
+
+        const auto& curve = Game::Curve(actor);
+
+        if (perks && actor && Game::IsAttacking(actor)) {
+            ApplyAttackSpeedPerks<Game>(actor, true, speeds[0]);
+            ApplyAttackSpeedPerks<Game>(actor, false, speeds[1]);
+        }
+
+        bool is_player = Game::IsPlayer(target);
+
+        for (size_t i = 0; i < 2; i++)
+            speeds[i] = Game::ApplyCurve(curve, speeds[i], Game::GetBaseActorValue(target, i == 0), is_player);
+
+        return speeds;
+    }
+
+
+    //Actors off in a lower AI process don't need their speed exact or current. They get both hands without perks, held for
+    // fWeaponSpeedTierRefresh seconds in a lock free table by form id.
+    template <class Game>
+    struct EvaluationTiers
+    {
+        using Actor = typename Game::Actor;
+
+        struct Entry
+        {
+            float stamp;
+            std::array<float, 2> speeds;
+        };
+
+        static bool Tiered(Actor* actor)
+        {
+            auto level = Game::ProcessLevel(actor);
+
+            //Not processed at all is as low as it gets.
+            if (!level)
+                return true;
+
+            return *level > static_cast<int32_t>(Game::TierFullProcess());
+        }
+
+        static float Get(Actor* actor, typename Game::Owner* owner, bool right)
+        {
+            float now = clock.load(std::memory_order_relaxed);
+
+            if (auto entry = entries.find(Game::FormID(actor)); entry && now - entry->stamp < Game::TierRefresh()) {
+                cached.fetch_add(1, std::memory_order_relaxed);
+                return entry->speeds[!right];
+            }
+
+            refreshed.fetch_add(1, std::memory_order_relaxed);
+
+            auto speeds = GetBothEffectiveSpeeds<Game>(owner, false);
+
+            entries.set(Game::FormID(actor), { now, speeds });
+
+            return speeds[!right];
+        }
+
+        //Once a frame. Nothing needs clearing out, an old entry is just one the next lookup refreshes.
+        static void Advance(float delta)
+        {
+            clock.store(clock.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+        }
+
+        static void Clear()
+        {
+            entries.clear();
+        }
+
+        //Whoever doesn't fit pushes someone out, who just gets refreshed again when they're next asked about.
+        static inline ActorSlots<Entry, 1024> entries;
+
+        static inline std::atomic<float> clock = 0.f;
+
+        static inline std::atomic<uint64_t> full = 0;
+        static inline std::atomic<uint64_t> cached = 0;
+        static inline std::atomic<uint64_t> refreshed = 0;
+    };
+
+
+    //When someone dual wields (fists count) the engine asks for one hand right after the other, so the first ask works out both
+    // and leaves the other hand waiting here. Anything that could change a speed bumps the generation, and each frame does too,
+    // so at worst a leftover gets thrown out.
+    template <class Game>
+    struct FusedSpeedCache
+    {
+        using Owner = typename Game::Owner;
+
+        struct Entry
+        {
+            Owner* owner = nullptr;
+            uint32_t generation = 0;
+            bool pending[2]{};
+            std::array<float, 2> speeds{};
+        };
+
+        static void Invalidate()
+        {
+            generation.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        static float Get(Owner* owner, bool right)
+        {
+            auto current = generation.load(std::memory_order_relaxed);
+
+            size_t hand = right ? 0 : 1;
+
+            if (entry.owner == owner && entry.generation == current && entry.pending[hand]) {
+                entry.pending[hand] = false;
+                return entry.speeds[hand];
+            }
+
+            auto actor = Game::AsActor(owner);
+
+            if (actor && EvaluationTiers<Game>::Tiered(actor))
+                return EvaluationTiers<Game>::Get(actor, owner, right);
+
+            EvaluationTiers<Game>::full.fetch_add(1, std::memory_order_relaxed);
+
+            if (!actor || !Game::DualWielding(actor))
+                return GetEffectiveSpeed<Game>(owner, right);
+
+            entry.owner = owner;
+            entry.generation = current;
+            entry.speeds = GetBothEffectiveSpeeds<Game>(owner);
+            entry.pending[hand] = false;
+            entry.pending[1 - hand] = true;
+
+            return entry.speeds[hand];
+        }
+
+        static inline std::atomic<uint32_t> generation = 0;
+        static inline thread_local Entry entry;
+    };
+
+
+    //What WeaponSpeedMultHook hands back for one hand, weapon being what's in it (fists for nothing).
+    template <class Game>
+    float WeaponSpeedMult(typename Game::Owner* owner, typename Game::Weapon* weapon, bool is_left)
+    {
+        float speed = FusedSpeedCache<Game>::Get(owner, !is_left);
+
+        return speed * Game::WeaponTypeMult(weapon) * Game::WeaponSpeed(weapon);
+    }
+
+
+    //Everything held between asks, for a load.
+    template <class Game>
+    void Clear()
+    {
+        AttackPins<Game>::Clear();
+        EvaluationTiers<Game>::Clear();
+        FusedSpeedCache<Game>::Invalidate();
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <span>
+
+//Laying out the speeds of a batch of actors, what the batch Papyrus functions and the native interface hand back. Each
+// actor gets an entry per hand asked for, right then left, null actors get 0.
+//
+// Doesn't know anything about the game, where the speeds come from is passed in.
+
+namespace SpeedQuery
+{
+    //Same bits as AttackRatePatchAPI::HandMask.
+    constexpr int32_t k_rightHand = 1 << 0;
+    constexpr int32_t k_leftHand = 1 << 1;
+    constexpr int32_t k_bothHands = k_rightHand | k_leftHand;
+
+    //How many floats each actor takes up.
+    inline size_t Stride(int32_t hand_mask)
+    {
+        return std::popcount(static_cast<uint32_t>(hand_mask & k_bothHands));
+    }
+
+    //both(target) returns right then left in one go, one(target, right) a single hand. out has to have room for all of it,
+    // nothing here allocates.
+    template <class Target, class Both, class One>
+    void Fill(std::span<Target* const> targets, int32_t hand_mask, float* out, Both&& both, One&& one)
+    {
+        for (auto target : targets)
+        {
+            if (target && (hand_mask & k_bothHands) == k_bothHands) {
+                std::array<float, 2> speeds = both(target);
+                *out++ = speeds[0];
+                *out++ = speeds[1];
+                continue;
+            }
+
+            if (hand_mask & k_rightHand)
+                *out++ = target ? one(target, true) : 0.f;
+
+            if (hand_mask & k_leftHand)
+                *out++ = target ? one(target, false) : 0.f;
+        }
+    }
+}
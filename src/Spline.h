@@ -0,0 +1,134 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <expected>
+#include <format>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <emmintrin.h>
+
+//Monotone piecewise cubic curves from a handful of control points. Tangents are picked the way PCHIP does (weighted harmonic
+// mean of the neighbouring slopes, flat at a local extreme), which keeps the curve from overshooting between points, so a
+// rising set of points gives a curve that never dips. Segments are baked into fixed size arrays so finding one is a count
+// over every knot rather than a search, no branches and the same work for any input.
+//
+// Doesn't know anything about the game.
+
+namespace Spline
+{
+    constexpr size_t k_maxKnots = 16;
+
+    struct Table
+    {
+        //Where each segment starts, unused ones are infinity so they never count.
+        alignas(64) std::array<float, k_maxKnots> x;
+
+        //y = a + b*t + c*t^2 + d*t^3, t being how far into the segment.
+        alignas(64) std::array<float, k_maxKnots> a;
+        alignas(64) std::array<float, k_maxKnots> b;
+        alignas(64) std::array<float, k_maxKnots> c;
+        alignas(64) std::array<float, k_maxKnots> d;
+
+        float low;
+        float high;
+
+        //Outside of the points the curve holds at the first or last one.
+        float Evaluate(float value) const
+        {
+            //Written so a NaN comes out as low.
+            value = value > low ? value : low;
+            value = value < high ? value : high;
+
+            //Every lane where value >= x is all ones, which is -1, so subtracting the masks counts them. The first knot
+            // always counts since value was clamped to it.
+            __m128 broadcast = _mm_set1_ps(value);
+            __m128i count = _mm_setzero_si128();
+
+            for (size_t i = 0; i < k_maxKnots; i += 4)
+                count = _mm_sub_epi32(count, _mm_castps_si128(_mm_cmpge_ps(broadcast, _mm_load_ps(&x[i]))));
+
+            count = _mm_add_epi32(count, _mm_shuffle_epi32(count, _MM_SHUFFLE(1, 0, 3, 2)));
+            count = _mm_add_epi32(count, _mm_shuffle_epi32(count, _MM_SHUFFLE(2, 3, 0, 1)));
+
+            size_t segment = _mm_cvtsi128_si32(count) - 1;
+
+            float t = value - x[segment];
+
+            return ((d[segment] * t + c[segment]) * t + b[segment]) * t + a[segment];
+        }
+    };
+
+
+    //Points need x strictly rising, between 2 and k_maxKnots of them.
+    inline std::expected<Table, std::string> Build(const std::vector<std::pair<float, float>>& points)
+    {
+        const size_t n = points.size();
+
+        if (n < 2 || n > k_maxKnots)
+            return std::unexpected(std::format("A spline needs between 2 and {} points, {} given", k_maxKnots, n));
+
+        for (size_t i = 0; i < n; i++)
+        {
+            if (!std::isfinite(points[i].first) || !std::isfinite(points[i].second))
+                return std::unexpected(std::format("Point {} isn't a finite number", i));
+
+            if (i && points[i].first <= points[i - 1].first)
+                return std::unexpected(std::format("Point {} doesn't come after the one before it", i));
+        }
+
+        //Done in double, only the finished coefficients get rounded.
+        std::vector<double> h(n - 1);
+        std::vector<double> delta(n - 1);
+
+        for (size_t i = 0; i + 1 < n; i++)
+        {
+            h[i] = static_cast<double>(points[i + 1].first) - points[i].first;
+            delta[i] = (static_cast<double>(points[i + 1].second) - points[i].second) / h[i];
+        }
+
+        std::vector<double> m(n);
+
+        m.front() = delta.front();
+        m.back() = delta.back();
+
+        for (size_t i = 1; i + 1 < n; i++)
+        {
+            if (delta[i - 1] * delta[i] <= 0) {
+                m[i] = 0;
+            }
+            else {
+                double w1 = 2 * h[i] + h[i - 1];
+                double w2 = h[i] + 2 * h[i - 1];
+                m[i] = (w1 + w2) / (w1 / delta[i - 1] + w2 / delta[i]);
+            }
+        }
+
+        Table table;
+
+        table.x.fill(std::numeric_limits<float>::infinity());
+        table.a.fill(0);
+        table.b.fill(0);
+        table.c.fill(0);
+        table.d.fill(0);
+
+        for (size_t i = 0; i + 1 < n; i++)
+        {
+            table.x[i] = points[i].first;
+            table.a[i] = points[i].second;
+            table.b[i] = static_cast<float>(m[i]);
+            table.c[i] = static_cast<float>((3 * delta[i] - 2 * m[i] - m[i + 1]) / h[i]);
+            table.d[i] = static_cast<float>((m[i] + m[i + 1] - 2 * delta[i]) / (h[i] * h[i]));
+        }
+
+        table.low = points.front().first;
+        table.high = points.back().first;
+
+        return table;
+    }
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+//Working out what an actor's speed tags should be from scratch, and spreading that work over frames. The tags are kept as a
+// running +1/-1 as effects start and finish, so anything that gets missed stays missed until a reload rebuilds them. This
+// redoes what the load does for a few actors at a time so the difference can be caught and fixed in place.
+//
+// Doesn't know anything about the game, effects come in already reduced to the value they put on a hand.
+
+namespace TagAudit
+{
+    //One value an effect puts on one hand, the same value the effect hooks hand to HandleSpeedEffect.
+    struct Contribution
+    {
+        bool right;
+        float value;
+    };
+
+    //Whether a value effect counts toward the tags when it starts (or is loaded). An enhance weapon effect that's already
+    // dispelled is left out, start has always skipped those. Only asked the once, what it says is kept on the effect as a Mark
+    // and finish and the audit go by that, an effect that gets dispelled later on is still one start counted.
+    inline bool Applies(bool recovers, bool detrimental, bool dispelled_enhance)
+    {
+        return recovers && !detrimental && !dispelled_enhance;
+    }
+
+    //What start or the load decided about an effect, left in padding on the effect. Anything but these two is whatever the
+    // padding had in it, nothing was decided.
+    enum Mark : uint16_t
+    {
+        kCounted = 0xCA51,
+        kSkipped = 0xCA50,
+    };
+
+    inline uint16_t MarkFor(bool applies)
+    {
+        return applies ? kCounted : kSkipped;
+    }
+
+    //Whether finish takes an effect back off, and whether the audit expects it. Without a mark it's the rule start goes by,
+    // less the dispel check, nothing but start sets that one.
+    inline bool Counts(uint16_t mark, bool recovers, bool detrimental)
+    {
+        if (mark == kCounted)
+            return true;
+
+        if (mark == kSkipped)
+            return false;
+
+        return Applies(recovers, detrimental, false);
+    }
+
+    //What an effect going on or off does to the tag.
+    inline int Count(bool is_on, float value)
+    {
+        if (!value)
+            return 0;
+
+        if (is_on)
+        {
+            //Disabled that for now because of no constructor.
+            if (value < 1.f) //|| !a_this->pad86)
+                return 0;
+        }
+        else
+        {
+            if (value > -1.f)//if value is returning a small sum or restoring a large decrement.
+                return 0;
+        }
+
+        return value > 0 ? 1 : -1;
+    }
+
+    //What an effect that's on right now counts for.
+    inline float Step(float value)
+    {
+        return static_cast<float>(Count(true, value));
+    }
+
+    //Right then left.
+    inline std::array<float, 2> Expected(std::span<const Contribution> contributions)
+    {
+        std::array<float, 2> result{};
+
+        for (auto& contribution : contributions)
+            result[!contribution.right] += Step(contribution.value);
+
+        return result;
+    }
+
+
+    //One value an active effect puts on a hand, with what Counts needs to know about the effect. A dual value effect on
+    // both speed values is two of these.
+    struct Effect
+    {
+        Contribution contribution;
+        bool recovers = true;
+        bool detrimental = false;
+        uint16_t mark = 0;
+    };
+
+    //What an actor's tags should be from the effects on it right now, right then left.
+    inline std::array<float, 2> Recompute(std::span<const Effect> effects)
+    {
+        std::array<float, 2> result{};
+
+        for (auto& effect : effects)
+        {
+            if (Counts(effect.mark, effect.recovers, effect.detrimental))
+                result[!effect.contribution.right] += Step(effect.contribution.value);
+        }
+
+        return result;
+    }
+
+
+    //Goes through a snapshot of ids a piece at a time, taking a new snapshot once the last one is done. Always gets through
+    // at least one id a call so a budget that's too small still moves.
+    template <class Id>
+    class Scheduler
+    {
+    public:
+        bool Exhausted() const { return _cursor >= _queue.size(); }
+
+        void Refill(std::vector<Id> ids)
+        {
+            _queue = std::move(ids);
+            _cursor = 0;
+        }
+
+        //now returns a std::chrono duration, visit takes an id. Returns how many were visited.
+        template <class Now, class Visit>
+        size_t Run(std::chrono::nanoseconds budget, Now&& now, Visit&& visit)
+        {
+            if (Exhausted())
+                return 0;
+
+            auto start = now();
+
+            size_t count = 0;
+
+            do
+            {
+                visit(_queue[_cursor++]);
+                count++;
+            } while (!Exhausted() && now() - start < budget);
+
+            return count;
+        }
+
+        size_t Remaining() const { return _queue.size() - _cursor; }
+
+    private:
+        std::vector<Id> _queue;
+        size_t _cursor = 0;
+    };
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+//Everyone who currently has a speed tag, packed tight so going over them costs what there is of them rather than every actor
+// loaded. Each column is its own array, keys in one, right tags in another, left in a third, and the same index lines them up.
+// Taking one out moves the last one into its place, so nothing ever has holes and order isn't kept.
+//
+// Doesn't know anything about the game, the key is whatever identifies an actor.
+
+template <class Key, class Hash = std::hash<Key>>
+class TagRegistry
+{
+public:
+    //Adds the key if either tag is nonzero, updates it if it's there, and drops it once both are zero.
+    void Set(Key key, float right, float left)
+    {
+        auto it = _slots.find(key);
+
+        if (right == 0 && left == 0)
+        {
+            if (it != _slots.end())
+                Erase(it);
+
+            return;
+        }
+
+        if (it != _slots.end()) {
+            _right[it->second] = right;
+            _left[it->second] = left;
+            return;
+        }
+
+        _slots.emplace(key, static_cast<uint32_t>(_keys.size()));
+        _keys.push_back(key);
+        _right.push_back(right);
+        _left.push_back(left);
+    }
+
+    bool Remove(Key key)
+    {
+        auto it = _slots.find(key);
+
+        if (it == _slots.end())
+            return false;
+
+        Erase(it);
+        return true;
+    }
+
+    bool contains(Key key) const { return _slots.contains(key); }
+
+    size_t size() const { return _keys.size(); }
+    bool empty() const { return _keys.empty(); }
+
+    std::span<const Key> keys() const { return _keys; }
+    std::span<const float> right() const { return _right; }
+    std::span<const float> left() const { return _left; }
+
+    void clear()
+    {
+        _slots.clear();
+        _keys.clear();
+        _right.clear();
+        _left.clear();
+    }
+
+private:
+    void Erase(typename std::unordered_map<Key, uint32_t, Hash>::iterator it)
+    {
+        uint32_t slot = it->second;
+        uint32_t last = static_cast<uint32_t>(_keys.size() - 1);
+
+        if (slot != last)
+        {
+            _keys[slot] = _keys[last];
+            _right[slot] = _right[last];
+            _left[slot] = _left[last];
+
+            _slots[_keys[slot]] = slot;
+        }
+
+        _slots.erase(it);
+        _keys.pop_back();
+        _right.pop_back();
+        _left.pop_back();
+    }
+
+    std::unordered_map<Key, uint32_t, Hash> _slots;
+
+    std::vector<Key> _keys;
+    std::vector<float> _right;
+    std::vector<float> _left;
+};
+
@@ -0,0 +1,130 @@
+#include "Catch.h"
+
+#include "ActorSlots.h"
+
+#include <array>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    struct Pair
+    {
+        float a;
+        float b;
+    };
+}
+
+
+TEST_CASE("Slots give back what was put in", "[ActorSlots]")
+{
+    ActorSlots<Pair, 16> slots;
+
+    CHECK_FALSE(slots.find(0x14));
+
+    REQUIRE(slots.set(0x14, { 1.f, 2.f }));
+    REQUIRE(slots.set(0xFF000801, { 3.f, 4.f }));
+
+    REQUIRE(slots.find(0x14));
+    CHECK(slots.find(0x14)->a == 1.f);
+    CHECK(slots.find(0x14)->b == 2.f);
+    CHECK(slots.find(0xFF000801)->a == 3.f);
+
+    //Setting again replaces, it doesn't take another slot.
+    REQUIRE(slots.set(0x14, { 5.f, 6.f }));
+    CHECK(slots.find(0x14)->a == 5.f);
+
+    size_t count = 0;
+    slots.for_each([&](uint32_t, Pair) { count++; });
+    CHECK(count == 2);
+
+    CHECK(slots.erase(0x14));
+    CHECK_FALSE(slots.erase(0x14));
+    CHECK_FALSE(slots.find(0x14));
+    CHECK(slots.find(0xFF000801));
+
+    slots.clear();
+    CHECK_FALSE(slots.find(0xFF000801));
+}
+
+TEST_CASE("0 is never a key", "[ActorSlots]")
+{
+    ActorSlots<Pair, 16> slots;
+
+    CHECK_FALSE(slots.set(0, { 1.f, 1.f }));
+    CHECK_FALSE(slots.find(0));
+    CHECK_FALSE(slots.erase(0));
+}
+
+TEST_CASE("A full table pushes out older keys instead of failing", "[ActorSlots]")
+{
+    ActorSlots<Pair, 16> slots;
+
+    for (uint32_t id = 1; id <= 64; id++)
+        CHECK(slots.set(id, { float(id), 0.f }));
+
+    //The last one in is always there, and nothing comes back with someone else's value.
+    CHECK(slots.find(64));
+
+    size_t found = 0;
+
+    for (uint32_t id = 1; id <= 64; id++) {
+        if (auto value = slots.find(id)) {
+            CHECK(value->a == float(id));
+            found++;
+        }
+    }
+
+    CHECK(found <= slots.capacity());
+}
+
+TEST_CASE("Readers never see half of a write", "[ActorSlots]")
+{
+    ActorSlots<std::array<uint32_t, 4>, 8> slots;
+
+    std::atomic<bool> stop = false;
+    std::atomic<size_t> torn = 0;
+
+    std::vector<std::thread> threads;
+
+    //Every write has all 4 words the same, so a value that doesn't was caught mid write.
+    for (uint32_t writer = 0; writer < 2; writer++)
+    {
+        threads.emplace_back([&, writer] {
+            for (uint32_t i = 1; !stop.load(std::memory_order_relaxed); i++) {
+                uint32_t value = i * 2 + writer;
+                slots.set(1 + i % 3, { value, value, value, value });
+            }
+        });
+    }
+
+    for (size_t reader = 0; reader < 2; reader++)
+    {
+        threads.emplace_back([&] {
+            while (!stop.load(std::memory_order_relaxed)) {
+                for (uint32_t key = 1; key <= 3; key++) {
+                    if (auto value = slots.find(key); value && ((*value)[0] != (*value)[1] || (*value)[0] != (*value)[3]))
+                        torn.fetch_add(1);
+                }
+            }
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    stop = true;
+
+    for (auto& thread : threads)
+        thread.join();
+
+    CHECK(torn == 0);
+
+    //And removing is never lost to a writer that had the slot.
+    slots.erase(1);
+    slots.erase(2);
+    slots.erase(3);
+
+    CHECK_FALSE(slots.find(1));
+    CHECK_FALSE(slots.find(2));
+    CHECK_FALSE(slots.find(3));
+}
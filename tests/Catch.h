@@ -0,0 +1,8 @@
+#pragma once
+
+//Catch2 3 split the single header up, 2 didn't. Tests only use the basic macros, which both have.
+#if __has_include(<catch2/catch_test_macros.hpp>)
+#include <catch2/catch_test_macros.hpp>
+#else
+#include <catch2/catch.hpp>
+#endif
@@ -0,0 +1,144 @@
+#include "Catch.h"
+
+#include "CurveExpression.h"
+
+#include <bit>
+#include <cmath>
+#include <string>
+
+//The interpreter against plain C++, and where Xbyak was found, the compiled code against the interpreter bit for bit.
+
+namespace
+{
+    using CurveExpression::Program;
+    using CurveExpression::Var;
+
+    //speed, base, minSpeed, capSpeed, speedTaper, maxSpeed
+    constexpr CurveExpression::Inputs k_inputs{ 2.5f, 1.f, 0.5f, 2.f, 0.2f, 3.f };
+
+    float Run(const char* text, const CurveExpression::Inputs& inputs = k_inputs)
+    {
+        auto program = Program::Parse(text);
+        REQUIRE(program);
+        return program->Run(inputs.data());
+    }
+
+    Program BindSettings(const Program& program, const CurveExpression::Inputs& inputs)
+    {
+        return program.
+            Bind(Var::MinSpeed, inputs[2]).
+            Bind(Var::CapSpeed, inputs[3]).
+            Bind(Var::SpeedTaper, inputs[4]).
+            Bind(Var::MaxSpeed, inputs[5]);
+    }
+
+    //Different enough to hit every op, including the calls out and select.
+    const char* const k_curves[]
+    {
+        "x",
+        "-x^2 + 2^3^2 - 10 / 4",
+        "clamp(x, minSpeed, maxSpeed)",
+        "select(x > capSpeed, capSpeed + sqrt(x - capSpeed) * pow(speedTaper, 1 / (x - capSpeed)), max(x, minSpeed))",
+        "min(x, base) + abs(-x) + exp(x / 4) + log(x + 1)",
+        "(x < base) * base + (x > base) * x",
+    };
+}
+
+
+TEST_CASE("Expressions follow the usual precedence", "[CurveExpression]")
+{
+    CHECK(Run("1+2*3") == 7.f);
+    CHECK(Run("(1+2)*3") == 9.f);
+    CHECK(Run("10-4-3") == 3.f);
+    CHECK(Run("8/2/2") == 2.f);
+
+    //^ is right associative and binds tighter than unary minus.
+    CHECK(Run("2^3^2") == 512.f);
+    CHECK(Run("-x^2") == -6.25f);
+
+    CHECK(Run(" speed*  2 ") == 5.f);
+}
+
+TEST_CASE("Builtins match plain C++", "[CurveExpression]")
+{
+    float extra = 2.5f - 2.f;
+
+    CHECK(Run("capSpeed + sqrt(x - capSpeed) * pow(speedTaper, 1 / (x - capSpeed))") == 2.f + std::sqrt(extra) * std::pow(0.2f, 1.f / extra));
+    CHECK(Run("min(x, base) + max(1, 2) + abs(-3) + exp(0) + log(1)") == 1.f + 2.f + 3.f + 1.f + 0.f);
+
+    CHECK(Run("clamp(x, 0, 1)") == 1.f);
+    CHECK(Run("clamp(-x, 0, 1)") == 0.f);
+
+    CHECK(Run("select(x > capSpeed, 1, 2)") == 1.f);
+    CHECK(Run("select(x < capSpeed, 1, 2)") == 2.f);
+    CHECK(Run("x < 3") == 1.f);
+}
+
+TEST_CASE("Bad expressions are turned away", "[CurveExpression]")
+{
+    for (auto text : { "", "1+", "foo", "sqrt(1,2)", "(1", "1)", "bar(1)", "1 $ 2" })
+    {
+        INFO(text);
+        CHECK_FALSE(Program::Parse(text));
+    }
+
+    std::string deep;
+
+    for (int i = 0; i < 40; i++)
+        deep = "x+(" + deep + "1)";
+
+    CHECK_FALSE(Program::Parse(deep));
+
+    //Nothing that long gets to run out the parser's stack either.
+    CHECK_FALSE(Program::Parse(std::string(100000, '-') + "1"));
+    CHECK_FALSE(Program::Parse(std::string(100000, '(')));
+}
+
+TEST_CASE("Binding every variable folds down to a constant", "[CurveExpression]")
+{
+    for (auto text : k_curves)
+    {
+        INFO(text);
+
+        auto program = Program::Parse(text);
+        REQUIRE(program);
+
+        auto bound = BindSettings(*program, k_inputs).Bind(Var::Speed, k_inputs[0]).Bind(Var::Base, k_inputs[1]);
+
+        REQUIRE(bound.code().size() == 1);
+        CHECK(bound.code()[0].op == CurveExpression::Op::Const);
+        CHECK(bound.code()[0].value == program->Run(k_inputs.data()));
+    }
+}
+
+#ifdef CARP_CURVE_JIT
+TEST_CASE("Compiled curves give exactly what the interpreter does", "[CurveExpression]")
+{
+    for (auto text : k_curves)
+    {
+        INFO(text);
+
+        auto program = Program::Parse(text);
+        REQUIRE(program);
+
+        auto bound = BindSettings(*program, k_inputs);
+
+        CurveExpression::Compiled compiled{ bound };
+        auto native = compiled.get();
+
+        CurveExpression::Inputs inputs = k_inputs;
+
+        //Both sides of the cap, zero, negatives, and the NaNs the logs and roots make there.
+        for (float speed = -1.f; speed <= 4.f; speed += 0.03125f)
+        {
+            inputs[0] = speed;
+
+            float expected = bound.Run(inputs.data());
+            float result = native(inputs.data());
+
+            INFO(speed);
+            CHECK(std::bit_cast<uint32_t>(result) == std::bit_cast<uint32_t>(expected));
+        }
+    }
+}
+#endif
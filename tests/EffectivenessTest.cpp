@@ -0,0 +1,37 @@
+#include "Catch.h"
+
+#include "Effectiveness.h"
+
+#include <cmath>
+#include <limits>
+
+TEST_CASE("The min magnitude is the step just past the comparison", "[Effectiveness]")
+{
+    CHECK(Effectiveness::MinMagnitude(1.f) == std::nextafter(1.f, INFINITY) - 1.f);
+    CHECK(Effectiveness::MinMagnitude(-1.f) == Effectiveness::MinMagnitude(1.f));
+    CHECK(Effectiveness::MinMagnitude(0.f) == std::numeric_limits<float>::denorm_min());
+
+    //Anything at least that big moves the comparison.
+    float comparison = 0.8f;
+    CHECK(comparison + Effectiveness::MinMagnitude(comparison) > comparison);
+}
+
+TEST_CASE("Scaled magnitudes keep their sign", "[Effectiveness]")
+{
+    float min = Effectiveness::MinMagnitude(1.f);
+
+    CHECK(Effectiveness::ScaleMagnitude(2.f, 0.5f, min) == 1.f);
+    CHECK(Effectiveness::ScaleMagnitude(-2.f, 0.5f, min) == -1.f);
+    CHECK(Effectiveness::ScaleMagnitude(2.f, 1.5f, min) == 3.f);
+}
+
+TEST_CASE("Scaled magnitudes never reach zero", "[Effectiveness]")
+{
+    float min = Effectiveness::MinMagnitude(1.f);
+
+    CHECK(Effectiveness::ScaleMagnitude(2.f, 0.f, min) == min);
+    CHECK(Effectiveness::ScaleMagnitude(-2.f, 0.f, min) == -min);
+
+    //Zero itself counts as positive.
+    CHECK(Effectiveness::ScaleMagnitude(0.f, 1.f, min) == min);
+}
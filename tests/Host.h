@@ -0,0 +1,381 @@
+#pragma once
+
+#include "Effectiveness.h"
+#include "EffectHooks.h"
+#include "SpeedCurve.h"
+#include "SpeedHooks.h"
+#include "TagAudit.h"
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+//A stand-in for the parts of the game the game-free headers get fed from, so they can be run together off the game. Only
+// carries what the plugin reads: the two speed values, the tags hidden in the actor, the value effects on it, whether it's
+// attacking and what its perks do, and the settings the curve is built from. Host::Game is the accessor SpeedHooks.h and
+// EffectHooks.h take, so what runs here are the plugin's own hook bodies, only what the game itself does is stood in for.
+
+namespace Host
+{
+    constexpr bool k_right = true;
+    constexpr bool k_left = false;
+
+    struct Actor;
+
+    //A value modifier effect on one of the speed values. value is what it puts on the actor value, magnitude the effect's
+    // magnitude when that isn't just the size of value.
+    struct Effect
+    {
+        bool right = k_right;
+        float value = 1.f;
+        bool recovers = true;
+        bool detrimental = false;
+        int type = EffectHooks::kValueMod;
+        bool dispelled = false;
+
+        //A dual value modifier's second value, and what it's scaled by.
+        std::optional<bool> secondary = std::nullopt;
+        float dualWeight = 1.f;
+
+        std::optional<float> magnitude = std::nullopt;
+
+        //What a loaded effect reads off its flags.
+        bool applied = true;
+        bool conditionsHold = true;
+
+        bool active = false;
+        uint16_t mark = 0;
+        Actor* target = nullptr;
+
+        //What the game has in the effect's value right now. Finish leaves what it took back off in there, which is how
+        // the finish hook tells a step coming off from one going on.
+        float current = 0.f;
+    };
+
+    struct Actor
+    {
+        uint32_t formID = 0;
+
+        //Right then left, same as the tags.
+        std::array<float, 2> base{};
+        std::array<float, 2> modifier{};
+        std::array<float, 2> tags{};
+
+        std::vector<Effect> effects;
+
+        bool player = false;
+        bool attacking = false;
+        bool drawing = false;
+        bool twoHanded = false;
+        std::optional<int32_t> processLevel = 0;
+
+        //What the AttackSpeed perk entry multiplies each hand by, and how many times it's been run.
+        std::array<float, 2> perks{ 1.f, 1.f };
+        uint32_t perkRuns = 0;
+
+
+        //What GetActorValueHook hands back, the game's value with the tag taken back off.
+        float GetActorValue(bool right);
+
+        float GetBaseActorValue(bool right) const
+        {
+            return base[!right];
+        }
+
+        size_t AddEffect(Effect effect)
+        {
+            effect.target = this;
+            effects.push_back(effect);
+            return effects.size() - 1;
+        }
+
+        //What the game and ValueEffectStartHook do, in the order the thunk does it.
+        void Start(size_t index);
+
+        //The same for ValueEffectFinishHook.
+        void Finish(size_t index);
+
+        //The same for ValueEffect_FinishLoadGameHook, on an effect that was saved active.
+        void Load(size_t index);
+
+        //What TagAuditor::Recompute reads off the actor's active effects.
+        std::array<float, 2> Recompute();
+
+    private:
+        void Apply(const Effect& effect, float sign)
+        {
+            modifier[!effect.right] += sign * effect.value;
+
+            if (effect.type == EffectHooks::kDualMod && effect.secondary)
+                modifier[!*effect.secondary] += sign * effect.value * effect.dualWeight;
+        }
+    };
+
+
+    //A float setting the way the plugin keeps them, prevValue is only ever written by the plugin.
+    struct Setting
+    {
+        float currValue = 0.f;
+        float prevValue = 0.f;
+
+        float GetValue() const { return currValue; }
+        void Update() { prevValue = currValue; }
+    };
+
+
+    //The settings SettingsEpoch looks over once a frame, and what it rebuilds when one of them moves.
+    struct Settings
+    {
+        static constexpr size_t k_weaponTypes = 10;
+        static constexpr size_t k_twoHanded[]{ 5, 6, 9 };
+
+        Setting minSpeed{ 0.5f, 0.5f };
+        Setting capSpeed{ 2.f, 2.f };
+        Setting speedTaper{ 0.2f, 0.2f };
+        Setting maxSpeed{ 3.f, 3.f };
+        Setting magnitudeComparison{ 1.f, 1.f };
+        std::array<Setting, k_weaponTypes> weaponTypeSpeed{};
+        Setting tierFullProcess{ 1.f, 1.f };
+        Setting tierRefresh{ 1.f, 1.f };
+
+        float twoHandedValue = 1.f;
+
+        std::array<float, k_weaponTypes> weaponTypeMult{};
+        std::vector<SpeedCurve::Params> profiles = std::vector<SpeedCurve::Params>(1);
+        float minMagnitude = 0.f;
+        uint32_t epoch = 0;
+
+
+        Settings()
+        {
+            for (auto& setting : weaponTypeSpeed)
+                setting = { 1.f, 1.f };
+        }
+
+        static bool Changed(Setting& setting)
+        {
+            if (setting.currValue == setting.prevValue)
+                return false;
+
+            setting.Update();
+            return true;
+        }
+
+        //Same checks and the same rebuild as SettingsEpoch::Refresh, every profile here shares the global settings.
+        bool Refresh(bool force = false)
+        {
+            bool changed = force;
+
+            changed |= Changed(minSpeed);
+            changed |= Changed(capSpeed);
+            changed |= Changed(speedTaper);
+            changed |= Changed(maxSpeed);
+            changed |= Changed(magnitudeComparison);
+
+            for (auto& setting : weaponTypeSpeed)
+                changed |= Changed(setting);
+
+            changed |= Changed(tierFullProcess);
+            changed |= Changed(tierRefresh);
+
+            if (!changed)
+                return false;
+
+            for (size_t i = 0; i < k_weaponTypes; i++)
+                weaponTypeMult[i] = weaponTypeSpeed[i].currValue;
+
+            for (auto i : k_twoHanded)
+                weaponTypeMult[i] *= twoHandedValue;
+
+            minMagnitude = Effectiveness::MinMagnitude(magnitudeComparison.GetValue());
+
+            for (auto& profile : profiles)
+                profile.Set(minSpeed.GetValue(), capSpeed.GetValue(), speedTaper.GetValue(), maxSpeed.GetValue());
+
+            epoch++;
+
+            return true;
+        }
+    };
+
+    struct Weapon
+    {
+        uint8_t type = 0;
+        float speed = 1.f;
+    };
+
+
+    //What SpeedHooks.h and EffectHooks.h get the game through, the same functions GameAccess has in Main.cpp. The settings
+    // and everything else here are shared by whatever runs, Reset puts it all back.
+    struct Game
+    {
+        using Owner = Host::Actor;
+        using Actor = Host::Actor;
+        using Weapon = Host::Weapon;
+        using Effect = Host::Effect;
+
+        //What MarkDirty was handed, with the speeds from before the change.
+        struct Change
+        {
+            Actor* actor;
+            std::array<float, 2> old;
+        };
+
+        static inline Settings settings = [] { Settings result; result.Refresh(true); return result; }();
+
+        static inline std::unordered_map<uint32_t, Actor*> loaded;
+        static inline std::vector<Change> changes;
+        static inline size_t syncs = 0;
+
+
+        //SpeedHooks.h
+        static Actor* AsActor(Owner* owner) { return owner; }
+        static float GetActorValue(Owner* owner, bool right) { return owner->GetActorValue(right); }
+        static float GetBaseActorValue(Owner* owner, bool right) { return owner->GetBaseActorValue(right); }
+        static bool IsPlayer(Owner* owner) { return owner->player; }
+
+        static uint32_t FormID(Actor* actor) { return actor->formID; }
+
+        static Actor* Lookup(uint32_t id)
+        {
+            auto it = loaded.find(id);
+            return it != loaded.end() ? it->second : nullptr;
+        }
+
+        static bool IsAttacking(Actor* actor) { return actor->attacking; }
+        static bool IsDrawing(Actor* actor) { return actor->drawing; }
+
+        static void AttackSpeedPerk(Actor* actor, bool right, float& speed)
+        {
+            actor->perkRuns++;
+            speed *= actor->perks[!right];
+        }
+
+        static const SpeedCurve::Params& Curve(Actor*) { return settings.profiles.front(); }
+
+        static float ApplyCurve(const SpeedCurve::Params& curve, float speed, float base_av, bool)
+        {
+            return SpeedCurve::Apply(curve, speed, base_av);
+        }
+
+        static std::optional<int32_t> ProcessLevel(Actor* actor) { return actor->processLevel; }
+        static float TierFullProcess() { return settings.tierFullProcess.GetValue(); }
+        static float TierRefresh() { return settings.tierRefresh.GetValue(); }
+
+        static bool DualWielding(Actor* actor) { return !actor->twoHanded; }
+
+        static float WeaponTypeMult(Weapon* weapon) { return settings.weaponTypeMult[weapon->type]; }
+        static float WeaponSpeed(Weapon* weapon) { return weapon->speed; }
+
+
+        //EffectHooks.h
+        static Actor* Target(Effect* effect) { return effect->target; }
+        static std::optional<bool> Hand(Effect* effect) { return effect->right; }
+        static std::optional<bool> SecondaryHand(Effect* effect) { return effect->secondary; }
+        static float DualWeight(Effect* effect) { return effect->dualWeight; }
+        static bool Recovers(Effect* effect) { return effect->recovers; }
+        static bool Detrimental(Effect* effect) { return effect->detrimental; }
+        static bool Dispelled(Effect* effect) { return effect->dispelled; }
+        static float Magnitude(Effect* effect) { return effect->magnitude.value_or(std::abs(effect->value)); }
+        static float Value(Effect* effect) { return effect->current; }
+        static bool Applied(Effect* effect) { return effect->applied; }
+        static bool ConditionsHold(Effect* effect) { return effect->conditionsHold; }
+        static uint16_t& Mark(Effect* effect) { return effect->mark; }
+        static float& Tag(Actor* actor, bool right) { return actor->tags[!right]; }
+        static void Sync(Actor*) { syncs++; }
+        static bool SpeedRelevant(Effect*) { return true; }
+
+        //What SpeedChangeEvents::MarkDirty does with it.
+        static void BeforeSpeedChange(Actor* actor)
+        {
+            SpeedHooks::FusedSpeedCache<Game>::Invalidate();
+
+            if (actor)
+                changes.push_back({ actor, SpeedHooks::GetBothEffectiveSpeeds<Game>(actor) });
+        }
+
+        template <class F>
+        static bool ForEachValueEffect(Actor* actor, F&& callback)
+        {
+            for (auto& effect : actor->effects)
+            {
+                if (effect.active)
+                    callback(&effect, effect.type);
+            }
+
+            return true;
+        }
+
+
+        static void Reset()
+        {
+            settings = [] { Settings result; result.Refresh(true); return result; }();
+            loaded.clear();
+            changes.clear();
+            syncs = 0;
+            SpeedHooks::Clear<Game>();
+        }
+    };
+
+
+    inline float Actor::GetActorValue(bool right)
+    {
+        return EffectHooks::ActorValue<Game>(this, right, base[!right] + modifier[!right]);
+    }
+
+    inline void Actor::Start(size_t index)
+    {
+        auto& effect = effects[index];
+
+        if (effect.active)
+            return;
+
+        bool relevant = EffectHooks::Prepare<Game>(&effect);
+
+        effect.active = true;
+        effect.current = effect.value;
+        Apply(effect, 1);
+
+        if (relevant)
+            EffectHooks::Start<Game>(&effect, effect.type);
+    }
+
+    inline void Actor::Finish(size_t index)
+    {
+        auto& effect = effects[index];
+
+        if (!effect.active)
+            return;
+
+        bool relevant = EffectHooks::Prepare<Game>(&effect);
+
+        effect.active = false;
+        effect.current = -effect.value;
+        Apply(effect, -1);
+
+        if (relevant)
+            EffectHooks::Finish<Game>(&effect, effect.type);
+    }
+
+    inline void Actor::Load(size_t index)
+    {
+        auto& effect = effects[index];
+
+        effect.active = true;
+        effect.current = effect.value;
+
+        if (effect.applied && effect.conditionsHold)
+            Apply(effect, 1);
+
+        if (Game::SpeedRelevant(&effect))
+            EffectHooks::Load<Game>(&effect, effect.type);
+    }
+
+    inline std::array<float, 2> Actor::Recompute()
+    {
+        return EffectHooks::Recompute<Game>(this).value_or(std::array<float, 2>{});
+    }
+}
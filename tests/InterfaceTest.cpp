@@ -0,0 +1,172 @@
+#include "Catch.h"
+
+#include "StandIn.h"
+
+#include <dlfcn.h>
+
+#include <vector>
+
+//Uses the API header the way another plugin would, against the stand-in library in place of the DLL. The first case
+// runs before anything loads it, the rest after.
+
+namespace
+{
+    void* LoadStandIn()
+    {
+        static void* module = dlopen(CARP_STANDIN_PATH, RTLD_NOW);
+        return module;
+    }
+
+    void Flush(const std::vector<AttackRatePatchAPI::SpeedChange>& changes)
+    {
+        auto flush = reinterpret_cast<decltype(&CARP_StandInFlush)>(dlsym(LoadStandIn(), "CARP_StandInFlush"));
+        REQUIRE(flush);
+        flush(changes.data(), changes.size());
+    }
+}
+
+
+TEST_CASE("Nothing comes back before the plugin is loaded", "[Interface]")
+{
+    CHECK(AttackRatePatchAPI::RequestInterface(AttackRatePatchAPI::Version::Version1) == nullptr);
+    CHECK(AttackRatePatchAPI::RequestInterface(AttackRatePatchAPI::Version::Version2) == nullptr);
+}
+
+TEST_CASE("Each version can be asked for by itself", "[Interface]")
+{
+    REQUIRE(LoadStandIn());
+
+    auto version1 = AttackRatePatchAPI::RequestInterface<AttackRatePatchAPI::InterfaceVersion1>();
+    auto current = AttackRatePatchAPI::RequestInterface<>();
+
+    REQUIRE(version1);
+    REQUIRE(current);
+
+    CHECK(version1->GetVersion() == AttackRatePatchAPI::Version::Current);
+    CHECK(AttackRatePatchAPI::Interface == current);
+
+    //Both are the same object seen through a different version.
+    CHECK(static_cast<AttackRatePatchAPI::InterfaceVersion1*>(current) == version1);
+
+    CHECK(AttackRatePatchAPI::RequestInterface(static_cast<AttackRatePatchAPI::Version>(7)) == nullptr);
+}
+
+TEST_CASE("Batch speeds are laid out right then left", "[Interface]")
+{
+    REQUIRE(LoadStandIn());
+
+    auto api = AttackRatePatchAPI::RequestInterface<>();
+    REQUIRE(api);
+
+    RE::Actor first;
+    first.base = { 1.5f, 1.25f };
+
+    RE::Actor second;
+    second.base = { 0.1f, 9.f };
+
+    RE::Actor* targets[]{ &first, nullptr, &second };
+
+    //The stand-in runs on the default settings.
+    Host::Game::Reset();
+
+    auto speed = [](RE::Actor& actor, bool right) { return SpeedHooks::GetEffectiveSpeed<Host::Game>(&actor, right); };
+
+    std::vector<float> both(6, -1.f);
+    api->GetEffectiveSpeeds(targets, 3, AttackRatePatchAPI::kBothHands, both.data());
+
+    CHECK(both == std::vector{
+        speed(first, true), speed(first, false),
+        0.f, 0.f,
+        speed(second, true), speed(second, false) });
+
+    std::vector<float> left(3, -1.f);
+    api->GetEffectiveSpeeds(targets, 3, AttackRatePatchAPI::kLeftHand, left.data());
+
+    CHECK(left == std::vector{ both[1], 0.f, both[5] });
+
+    CHECK(api->GetEffectiveSpeed(&first, true) == both[0]);
+    CHECK(api->GetEffectiveSpeed(nullptr, true) == 0.f);
+
+    first.tags = { 1.f, 2.f };
+    CHECK(api->GetSpeedTag(&first, false) == 2.f);
+}
+
+TEST_CASE("Settings come back as they are", "[Interface]")
+{
+    REQUIRE(LoadStandIn());
+
+    AttackRatePatchAPI::SettingsSnapshot settings{};
+    AttackRatePatchAPI::RequestInterface<>()->GetSettings(settings);
+
+    CHECK(settings.minSpeed == 0.5f);
+    CHECK(settings.capSpeed == 2.f);
+    CHECK(settings.speedTaper == 0.2f);
+    CHECK(settings.maxSpeed == 3.f);
+    CHECK(settings.magnitudeComparison == 1.f);
+}
+
+TEST_CASE("A listener is only added once", "[Interface]")
+{
+    REQUIRE(LoadStandIn());
+
+    auto api = AttackRatePatchAPI::RequestInterface<>();
+
+    auto callback = [](const AttackRatePatchAPI::SpeedChange*, uint64_t, void* user) { ++*static_cast<int*>(user); };
+
+    int calls = 0;
+
+    CHECK(api->AddSpeedChangeListener(callback, &calls));
+    CHECK_FALSE(api->AddSpeedChangeListener(callback, &calls));
+    CHECK_FALSE(api->AddSpeedChangeListener(nullptr, &calls));
+
+    RE::Actor actor;
+    Flush({ { &actor, true, 1.f, 1.5f } });
+
+    CHECK(calls == 1);
+
+    CHECK(api->RemoveSpeedChangeListener(callback, &calls));
+    CHECK_FALSE(api->RemoveSpeedChangeListener(callback, &calls));
+
+    Flush({ { &actor, true, 1.5f, 1.f } });
+
+    CHECK(calls == 1);
+}
+
+TEST_CASE("A listener can remove itself and others from its callback", "[Interface]")
+{
+    REQUIRE(LoadStandIn());
+
+    struct State
+    {
+        AttackRatePatchAPI::CurrentInterface* api;
+        int first = 0;
+        int second = 0;
+        std::vector<AttackRatePatchAPI::SpeedChange> seen;
+    };
+
+    static auto second = [](const AttackRatePatchAPI::SpeedChange*, uint64_t, void* user) { static_cast<State*>(user)->second++; };
+
+    auto first = [](const AttackRatePatchAPI::SpeedChange* changes, uint64_t count, void* user) {
+        auto state = static_cast<State*>(user);
+        state->first++;
+        state->seen.assign(changes, changes + count);
+
+        state->api->RemoveSpeedChangeListener(+second, user);
+    };
+
+    State state{ .api = AttackRatePatchAPI::RequestInterface<>(), .first = 0, .second = 0, .seen = {} };
+
+    REQUIRE(state.api->AddSpeedChangeListener(first, &state));
+    REQUIRE(state.api->AddSpeedChangeListener(+second, &state));
+
+    RE::Actor actor;
+    Flush({ { &actor, true, 1.f, 1.5f }, { &actor, false, 1.f, 0.75f } });
+
+    //second was taken out before its turn came.
+    CHECK(state.first == 1);
+    CHECK(state.second == 0);
+    REQUIRE(state.seen.size() == 2);
+    CHECK(state.seen[1].newSpeed == 0.75f);
+
+    CHECK(state.api->RemoveSpeedChangeListener(first, &state));
+}
@@ -0,0 +1,251 @@
+#include "Catch.h"
+
+#include "Prologue.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+//Byte fixtures for the length decoder, mostly lifted from the starts of functions CARP hooks or might, plus the encodings
+// that tend to trip decoders up (prefixes, VEX, group 3, SIB with no base).
+
+namespace
+{
+    struct Fixture
+    {
+        const char* name;
+        std::vector<uint8_t> bytes;
+        int length;
+        bool ripRelative = false;
+    };
+
+    const std::vector<Fixture> k_fixtures
+    {
+        { "push rbx", { 0x40, 0x53 }, 2 },
+        { "sub rsp, 20h", { 0x48, 0x83, 0xEC, 0x20 }, 4 },
+        { "mov [rsp+8], rbx", { 0x48, 0x89, 0x5C, 0x24, 0x08 }, 5 },
+        { "mov rax, [rip+x]", { 0x48, 0x8B, 0x05, 1, 2, 3, 4 }, 7, true },
+        { "lea rcx, [rip+x]", { 0x48, 0x8D, 0x0D, 1, 2, 3, 4 }, 7, true },
+        { "call rel32", { 0xE8, 1, 2, 3, 4 }, 5 },
+        { "jmp rel32", { 0xE9, 1, 2, 3, 4 }, 5 },
+        { "jmp rel8", { 0xEB, 0x10 }, 2 },
+        { "je rel8", { 0x74, 0x10 }, 2 },
+        { "je rel32", { 0x0F, 0x84, 1, 2, 3, 4 }, 6 },
+        { "mov rax, imm64", { 0x48, 0xB8, 1, 2, 3, 4, 5, 6, 7, 8 }, 10 },
+        { "mov eax, imm32", { 0xB8, 1, 2, 3, 4 }, 5 },
+        { "mov ax, imm16", { 0x66, 0xB8, 1, 2 }, 4 },
+        { "sub rsp, 100h", { 0x48, 0x81, 0xEC, 0x00, 0x01, 0, 0 }, 7 },
+        { "mov dword [rsp+10h], imm32", { 0xC7, 0x44, 0x24, 0x10, 1, 2, 3, 4 }, 8 },
+        { "mov dword [rip+x], imm32", { 0xC7, 0x05, 1, 2, 3, 4, 5, 6, 7, 8 }, 10, true },
+        { "test cl, 1", { 0xF6, 0xC1, 0x01 }, 3 },
+        { "not cl", { 0xF6, 0xD1 }, 2 },
+        { "test ecx, imm32", { 0xF7, 0xC1, 1, 2, 3, 4 }, 6 },
+        { "movaps [rsp+20h], xmm6", { 0x0F, 0x29, 0x74, 0x24, 0x20 }, 5 },
+        { "vzeroupper", { 0xC5, 0xF8, 0x77 }, 3 },
+        { "vmovss xmm0, [rip+x]", { 0xC5, 0xFA, 0x10, 0x05, 1, 2, 3, 4 }, 8, true },
+        { "vpalignr", { 0xC4, 0xE3, 0x79, 0x0F, 0xC1, 0x08 }, 6 },
+        { "palignr", { 0x66, 0x0F, 0x3A, 0x0F, 0xC1, 0x08 }, 6 },
+        { "movss xmm0, [rip+x]", { 0xF3, 0x0F, 0x10, 0x05, 1, 2, 3, 4 }, 8, true },
+        { "mov r11, rsp", { 0x4C, 0x8B, 0xDC }, 3 },
+        { "mov rax, [abs32]", { 0x48, 0x8B, 0x04, 0x25, 1, 2, 3, 4 }, 8 },
+        { "ret", { 0xC3 }, 1 },
+        { "int3", { 0xCC }, 1 },
+        { "nop dword [rax+rax]", { 0x0F, 0x1F, 0x44, 0x00, 0x00 }, 5 },
+        { "mov rax, gs:[58h]", { 0x65, 0x48, 0x8B, 0x04, 0x25, 0x58, 0, 0, 0 }, 9 },
+        { "invalid in 64 bit", { 0x06 }, -1 },
+    };
+
+
+    uint64_t ReadQword(const std::vector<uint8_t>& code, size_t offset)
+    {
+        uint64_t result;
+        std::memcpy(&result, code.data() + offset, sizeof(result));
+        return result;
+    }
+
+    int32_t ReadDword(const std::vector<uint8_t>& code, size_t offset)
+    {
+        int32_t result;
+        std::memcpy(&result, code.data() + offset, sizeof(result));
+        return result;
+    }
+}
+
+
+TEST_CASE("Instruction lengths match the fixtures", "[Prologue]")
+{
+    for (auto& fixture : k_fixtures)
+    {
+        INFO(fixture.name);
+
+        //Padded with nops so running past the end would show up as a wrong length rather than a bad read.
+        auto bytes = fixture.bytes;
+        bytes.resize(20, 0x90);
+
+        auto instruction = Prologue::Decode(bytes.data());
+
+        if (fixture.length < 0)
+        {
+            CHECK_FALSE(instruction);
+            continue;
+        }
+
+        REQUIRE(instruction);
+        CHECK(instruction->length == fixture.length);
+        CHECK(instruction->ripRelative == fixture.ripRelative);
+    }
+}
+
+TEST_CASE("Decoding stops at the end of what's available", "[Prologue]")
+{
+    const uint8_t code[]{ 0x48, 0x8B, 0x05, 1, 2, 3, 4 };
+
+    CHECK(Prologue::Decode(code, sizeof(code)));
+    CHECK_FALSE(Prologue::Decode(code, sizeof(code) - 1));
+}
+
+TEST_CASE("Branch targets come out absolute", "[Prologue]")
+{
+    const uint8_t code[]{ 0xE8, 0x00, 0x10, 0x00, 0x00 };
+
+    auto instruction = Prologue::Decode(code);
+
+    REQUIRE(instruction);
+    CHECK(instruction->branch == Prologue::BranchType::Call);
+    CHECK(Prologue::GetTarget(code, 0x140001000, *instruction) == 0x140001000 + 5 + 0x1000);
+
+    const uint8_t back[]{ 0xEB, 0xFE };
+
+    instruction = Prologue::Decode(back);
+
+    REQUIRE(instruction);
+    CHECK(Prologue::GetTarget(back, 0x1000, *instruction) == 0x1000);
+}
+
+TEST_CASE("A plain prologue is copied and jumps back", "[Prologue]")
+{
+    const uint8_t code[]{ 0x40, 0x53, 0x48, 0x83, 0xEC, 0x20, 0x90, 0x90 };
+
+    auto relocation = Prologue::Relocate(code, 0x140001000, 5, 0x140100000);
+
+    REQUIRE(relocation);
+    CHECK(relocation->consumed == 6);
+    REQUIRE(relocation->code.size() == 6 + 14);
+    CHECK(std::equal(code, code + 6, relocation->code.begin()));
+    CHECK(relocation->code[6] == 0xFF);
+    CHECK(relocation->code[7] == 0x25);
+    CHECK(ReadQword(relocation->code, 12) == 0x140001006);
+}
+
+TEST_CASE("RIP relative operands still point at the same place", "[Prologue]")
+{
+    const uint8_t code[]{ 0x48, 0x8B, 0x05, 0x10, 0, 0, 0 };
+
+    auto relocation = Prologue::Relocate(code, 0x140001000, 5, 0x140002000);
+
+    REQUIRE(relocation);
+    CHECK(0x140002000 + 7 + ReadDword(relocation->code, 3) == 0x140001000 + 7 + 0x10);
+
+    //Out of rel32 reach from the new spot, has to be refused.
+    CHECK_FALSE(Prologue::Relocate(code, 0x140001000, 5, 0x240002000));
+}
+
+TEST_CASE("A jump left by someone else is carried over", "[Prologue]")
+{
+    const uint8_t code[]{ 0xE9, 0x00, 0x10, 0, 0 };
+
+    auto relocation = Prologue::Relocate(code, 0x140001000, 5, 0x140100000);
+
+    REQUIRE(relocation);
+    CHECK(relocation->consumed == 5);
+
+    //No jump back, nothing after it ever ran.
+    REQUIRE(relocation->code.size() == 14);
+    CHECK(ReadQword(relocation->code, 6) == 0x140001000 + 5 + 0x1000);
+}
+
+TEST_CASE("Calls become absolute calls that fall through", "[Prologue]")
+{
+    const uint8_t code[]{ 0xE8, 0x00, 0x10, 0, 0 };
+
+    auto relocation = Prologue::Relocate(code, 0x140001000, 5, 0x140100000);
+
+    REQUIRE(relocation);
+    REQUIRE(relocation->code.size() == 16 + 14);
+    CHECK(relocation->code[0] == 0xFF);
+    CHECK(relocation->code[1] == 0x15);
+    CHECK(ReadQword(relocation->code, 8) == 0x140001000 + 5 + 0x1000);
+    CHECK(ReadQword(relocation->code, 16 + 6) == 0x140001005);
+}
+
+TEST_CASE("Conditional branches are inverted over an absolute jump", "[Prologue]")
+{
+    const uint8_t code[]{ 0x74, 0x10, 0x48, 0x83, 0xEC, 0x20 };
+
+    auto relocation = Prologue::Relocate(code, 0x1000, 5, 0x2000);
+
+    REQUIRE(relocation);
+    CHECK(relocation->code[0] == 0x75);
+    CHECK(relocation->code[1] == 0x0E);
+    CHECK(ReadQword(relocation->code, 8) == 0x1000 + 2 + 0x10);
+}
+
+TEST_CASE("Returns and indirect jumps don't get a jump back", "[Prologue]")
+{
+    struct Case
+    {
+        const char* name;
+        std::vector<uint8_t> code;
+        bool endsFlow;
+    };
+
+    const Case cases[]
+    {
+        { "ret", { 0xC3, 0x90, 0x90, 0x90, 0x90 }, true },
+        { "ret 8", { 0xC2, 0x08, 0x00, 0x90, 0x90 }, true },
+        { "jmp rax", { 0xFF, 0xE0, 0x90, 0x90, 0x90 }, true },
+        { "jmp [rip+x]", { 0xFF, 0x25, 0x00, 0x10, 0x00, 0x00 }, true },
+        { "jmp far [rax]", { 0xFF, 0x28, 0x90, 0x90, 0x90 }, true },
+        { "call rax", { 0xFF, 0xD0, 0x90, 0x90, 0x90 }, false },
+        { "push [rax]", { 0xFF, 0x30, 0x90, 0x90, 0x90 }, false },
+    };
+
+    for (auto& test : cases)
+    {
+        INFO(test.name);
+
+        auto instruction = Prologue::Decode(test.code.data(), test.code.size());
+
+        REQUIRE(instruction);
+        CHECK(instruction->endsFlow == test.endsFlow);
+
+        //Only ever the one instruction, so there's a jump back exactly when it falls through.
+        auto relocation = Prologue::Relocate(test.code.data(), 0x140001000, instruction->length, 0x140002000);
+
+        REQUIRE(relocation);
+        CHECK(relocation->code.size() == instruction->length + (test.endsFlow ? 0u : 14u));
+    }
+}
+
+TEST_CASE("Anything the decoder can't handle refuses to relocate", "[Prologue]")
+{
+    const uint8_t invalid[]{ 0x40, 0x53, 0x06, 0x90, 0x90 };
+    CHECK_FALSE(Prologue::Relocate(invalid, 0x1000, 5, 0x2000));
+
+    const uint8_t loop[]{ 0xE2, 0x10, 0x90, 0x90, 0x90 };
+    CHECK_FALSE(Prologue::Relocate(loop, 0x1000, 5, 0x2000));
+}
+
+TEST_CASE("A relocated prologue fits the room a detour budgets for it", "[Prologue]")
+{
+    //The worst the hooked functions are likely to start with, a call and a jcc inside the first 5 bytes.
+    const uint8_t code[]{ 0x74, 0x10, 0xE8, 0x00, 0x10, 0, 0 };
+
+    auto relocation = Prologue::Relocate(code, 0x140001000, 5, 0x140100000);
+
+    REQUIRE(relocation);
+
+    //k_prologueSize in HookRegistry.h.
+    CHECK(relocation->code.size() <= 0x80);
+}
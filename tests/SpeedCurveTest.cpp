@@ -0,0 +1,94 @@
+#include "Catch.h"
+
+#include "SpeedCurve.h"
+
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    SpeedCurve::Params MakeParams(float min, float cap, float taper, float max)
+    {
+        SpeedCurve::Params params;
+        params.Set(min, cap, taper, max);
+        return params;
+    }
+}
+
+
+TEST_CASE("Params are cleaned up when they're set", "[SpeedCurve]")
+{
+    auto params = MakeParams(0.f, 2.f, 5.f, 0.f);
+
+    CHECK(params.minSpeed == SpeedCurve::k_closeToZero);
+    CHECK(params.speedTaper == 1.f);
+    CHECK(params.maxSpeed == std::numeric_limits<float>::infinity());
+    CHECK(params.capSpeed == 2.f);
+
+    //A max under normal speed would mean nothing could ever be normal.
+    CHECK(MakeParams(0.5f, 2.f, 0.2f, 0.5f).maxSpeed == 1.f);
+}
+
+TEST_CASE("Speeds are held between the min and max", "[SpeedCurve]")
+{
+    auto params = MakeParams(0.5f, 2.f, 0.2f, 3.f);
+
+    CHECK(SpeedCurve::Apply(params, 0.1f, 1.f) == 0.5f);
+    CHECK(SpeedCurve::Apply(params, -4.f, 1.f) == 0.5f);
+    CHECK(SpeedCurve::Apply(params, 1.25f, 1.f) == 1.25f);
+    CHECK(SpeedCurve::Apply(params, 3.f, 1.f) == 3.f);
+    CHECK(SpeedCurve::Apply(params, 7.f, 1.f) == 3.f);
+}
+
+TEST_CASE("The min never goes over the base speed", "[SpeedCurve]")
+{
+    auto params = MakeParams(0.5f, 2.f, 0.2f, 3.f);
+
+    CHECK(SpeedCurve::Apply(params, 0.1f, 0.3f) == 0.3f);
+
+    //A base of zero would leave nothing to clamp to, it's treated as the smallest speed allowed.
+    CHECK(SpeedCurve::Apply(params, 0.f, 0.f) == SpeedCurve::k_closeToZero);
+}
+
+TEST_CASE("The taper only kicks in when the cap setting is zero", "[SpeedCurve]")
+{
+    //What the settings have always done, a zero cap tapers from the min speed up.
+    auto params = MakeParams(0.5f, 0.f, 0.2f, 3.f);
+
+    float expected = SpeedCurve::Taper(1.5f, 0.5f, 0.2f);
+
+    CHECK(expected == 0.5f + 0.2f);
+    CHECK(SpeedCurve::Apply(params, 1.5f, 1.f) == expected);
+
+    //Any other cap leaves the speed alone below the max.
+    CHECK(SpeedCurve::Apply(MakeParams(0.5f, 2.f, 0.2f, 3.f), 2.5f, 1.f) == 2.5f);
+}
+
+TEST_CASE("Taper leaves speeds under the cap alone", "[SpeedCurve]")
+{
+    CHECK(SpeedCurve::Taper(1.f, 2.f, 0.2f) == 1.f);
+    CHECK(SpeedCurve::Taper(2.f, 2.f, 0.2f) == 2.f);
+    CHECK(SpeedCurve::Taper(4.f, 2.f, 0.f) == 2.f);
+    CHECK(SpeedCurve::Taper(4.f, 2.f, 1.f) == 2.f + std::sqrt(2.f));
+}
+
+TEST_CASE("A custom curve replaces the taper but not the limits", "[SpeedCurve]")
+{
+    auto params = MakeParams(0.5f, 2.f, 0.2f, 3.f);
+
+    SpeedCurve::Inputs seen{};
+
+    auto half = [&](const SpeedCurve::Inputs& inputs) { seen = inputs; return inputs[0] / 2; };
+
+    CHECK(SpeedCurve::Apply(params, 2.f, 1.5f, half) == 1.f);
+    CHECK(seen == SpeedCurve::Inputs{ 2.f, 1.5f, 0.5f, 2.f, 0.2f, 3.f });
+
+    CHECK(SpeedCurve::Apply(params, 0.8f, 1.f, half) == 0.5f);
+    CHECK(SpeedCurve::Apply(params, 1.f, 1.f, [](const SpeedCurve::Inputs&) { return 100.f; }) == 3.f);
+    CHECK(SpeedCurve::Apply(params, 1.f, 1.f, [](const SpeedCurve::Inputs&) { return std::nanf(""); }) == 0.5f);
+
+    //Speeds under the min never reach the curve.
+    bool called = false;
+    SpeedCurve::Apply(params, 0.2f, 1.f, [&](const SpeedCurve::Inputs&) { called = true; return 1.f; });
+    CHECK_FALSE(called);
+}
@@ -0,0 +1,225 @@
+#include "Catch.h"
+
+#include "Host.h"
+#include "SpeedHooks.h"
+
+#include <array>
+
+namespace
+{
+    using Pins = SpeedHooks::AttackPins<Host::Game>;
+    using Tiers = SpeedHooks::EvaluationTiers<Host::Game>;
+    using Fused = SpeedHooks::FusedSpeedCache<Host::Game>;
+
+    std::array<float, 2> Speeds(Host::Actor& actor)
+    {
+        return SpeedHooks::GetBothEffectiveSpeeds<Host::Game>(&actor);
+    }
+
+    Host::Actor& Loaded(Host::Actor& actor, uint32_t id)
+    {
+        actor.formID = id;
+        actor.base = { 1.f, 1.f };
+        Host::Game::loaded[id] = &actor;
+        return actor;
+    }
+}
+
+
+TEST_CASE("The perks run once a swing", "[SpeedHooks]")
+{
+    Host::Game::Reset();
+
+    Host::Actor actor;
+    Loaded(actor, 0x14);
+    actor.perks = { 1.5f, 1.f };
+
+    auto idle = Speeds(actor);
+    CHECK(actor.perkRuns == 0);
+
+    actor.attacking = true;
+
+    auto swing = Speeds(actor);
+    CHECK(swing[0] > idle[0]);
+    CHECK(swing[1] == idle[1]);
+    CHECK(actor.perkRuns == 2);
+
+    CHECK(Speeds(actor) == swing);
+    CHECK(SpeedHooks::GetEffectiveSpeed<Host::Game>(&actor, Host::k_right) == swing[0]);
+    CHECK(actor.perkRuns == 2);
+}
+
+TEST_CASE("An effect landing mid swing still moves the speed", "[SpeedHooks]")
+{
+    Host::Game::Reset();
+
+    Host::Actor actor;
+    Loaded(actor, 0x14);
+    actor.perks = { 1.5f, 1.f };
+    actor.attacking = true;
+
+    auto haste = actor.AddEffect({ .right = Host::k_right, .value = 0.25f });
+
+    auto before = Speeds(actor);
+
+    actor.Start(haste);
+
+    //What the change events hold against each other, they'd be the same if the speed itself were held.
+    REQUIRE(Host::Game::changes.size() == 1);
+    CHECK(Host::Game::changes[0].old == before);
+    CHECK(Speeds(actor)[0] > before[0]);
+
+    //The perks still weren't asked again.
+    CHECK(actor.perkRuns == 2);
+}
+
+TEST_CASE("Dropping a pin marks the actor first", "[SpeedHooks]")
+{
+    Host::Game::Reset();
+
+    Host::Actor actor;
+    Loaded(actor, 0x14);
+    actor.perks = { 1.5f, 1.f };
+    actor.attacking = true;
+
+    auto swing = Speeds(actor);
+
+    //The perk changed during the swing, the pin holds the old one until the attack ends.
+    actor.perks = { 1.2f, 1.f };
+    CHECK(Speeds(actor) == swing);
+
+    //attackStop comes while the actor still reads as attacking.
+    Pins::Release(&actor, Host::Game::BeforeSpeedChange);
+    actor.attacking = false;
+
+    REQUIRE(Host::Game::changes.size() == 1);
+    CHECK(Host::Game::changes[0].old == swing);
+    CHECK(Speeds(actor)[0] < swing[0]);
+
+    //Nothing to drop the second time.
+    Pins::Release(&actor, Host::Game::BeforeSpeedChange);
+    CHECK(Host::Game::changes.size() == 1);
+}
+
+TEST_CASE("The sweep drops pins for finished attacks and new draws", "[SpeedHooks]")
+{
+    Host::Game::Reset();
+
+    Host::Actor stopped;
+    Host::Actor combo;
+    Host::Actor swinging;
+    Host::Actor gone;
+
+    for (auto [actor, id] : { std::pair{ &stopped, 1u }, { &combo, 2u }, { &swinging, 3u }, { &gone, 4u } })
+    {
+        Loaded(*actor, id);
+        actor->attacking = true;
+        actor->drawing = true;
+        Speeds(*actor);
+    }
+
+    Host::Game::loaded.erase(4);
+
+    auto sweep = [] { Pins::Sweep(Host::Game::BeforeSpeedChange); };
+
+    //Everyone's still in the draw, only the one that isn't loaded goes.
+    sweep();
+    CHECK(Host::Game::changes.empty());
+    CHECK_FALSE(Pins::pins.find(4));
+
+    combo.drawing = false;
+    swinging.drawing = false;
+    sweep();
+
+    stopped.attacking = false;
+    combo.drawing = true;
+    sweep();
+
+    REQUIRE(Host::Game::changes.size() == 2);
+    CHECK_FALSE(Pins::pins.find(1));
+    CHECK_FALSE(Pins::pins.find(2));
+    CHECK(Pins::pins.find(3));
+}
+
+TEST_CASE("Lower process actors are held without perks until the refresh", "[SpeedHooks]")
+{
+    Host::Game::Reset();
+    Host::Game::settings.tierFullProcess.currValue = 0.f;
+    Host::Game::settings.tierRefresh.currValue = 1.f;
+    Host::Game::settings.Refresh();
+
+    Host::Actor actor;
+    Loaded(actor, 0x14);
+    actor.processLevel = 2;
+    actor.attacking = true;
+    actor.perks = { 1.5f, 1.5f };
+
+    Host::Actor unprocessed;
+    Loaded(unprocessed, 0x15);
+    unprocessed.processLevel = std::nullopt;
+
+    Host::Actor high;
+    Loaded(high, 0x16);
+
+    CHECK(Tiers::Tiered(&actor));
+    CHECK(Tiers::Tiered(&unprocessed));
+    CHECK_FALSE(Tiers::Tiered(&high));
+
+    float first = Fused::Get(&actor, Host::k_right);
+    CHECK(actor.perkRuns == 0);
+
+    actor.base = { 2.f, 2.f };
+    CHECK(Fused::Get(&actor, Host::k_right) == first);
+
+    Tiers::Advance(1.5f);
+    CHECK(Fused::Get(&actor, Host::k_right) > first);
+    CHECK(actor.perkRuns == 0);
+}
+
+TEST_CASE("Dual wielders get both hands from one ask", "[SpeedHooks]")
+{
+    Host::Game::Reset();
+
+    Host::Actor actor;
+    Loaded(actor, 0x14);
+    actor.base = { 1.2f, 0.8f };
+
+    auto full = Tiers::full.load();
+
+    CHECK(Fused::Get(&actor, Host::k_right) == Speeds(actor)[0]);
+    CHECK(Fused::Get(&actor, Host::k_left) == Speeds(actor)[1]);
+    CHECK(Tiers::full.load() == full + 1);
+
+    //A change in between throws the other hand out.
+    CHECK(Fused::Get(&actor, Host::k_right) == Speeds(actor)[0]);
+    Host::Game::BeforeSpeedChange(&actor);
+    actor.base[1] = 1.f;
+    CHECK(Fused::Get(&actor, Host::k_left) == Speeds(actor)[1]);
+    CHECK(Tiers::full.load() == full + 3);
+
+    //Two handers are asked one hand at a time, from the next frame on.
+    Fused::Invalidate();
+    actor.twoHanded = true;
+    Fused::Get(&actor, Host::k_right);
+    Fused::Get(&actor, Host::k_left);
+    CHECK(Tiers::full.load() == full + 5);
+}
+
+TEST_CASE("WeaponSpeedMult scales by weapon type and speed", "[SpeedHooks]")
+{
+    Host::Game::Reset();
+    Host::Game::settings.weaponTypeSpeed[5].currValue = 0.5f;
+    Host::Game::settings.Refresh();
+
+    Host::Actor actor;
+    Loaded(actor, 0x14);
+    actor.twoHanded = true;
+
+    Host::Weapon sword{ .type = 1, .speed = 1.3f };
+    Host::Weapon greatsword{ .type = 5, .speed = 0.7f };
+
+    float speed = Speeds(actor)[0];
+
+    CHECK(SpeedHooks::WeaponSpeedMult<Host::Game>(&actor, &sword, false) == speed * 1.3f);
+    CHECK(SpeedHooks::WeaponSpeedMult<Host::Game>(&actor, &greatsword, false) == speed * 0.5f * 0.7f);
+}
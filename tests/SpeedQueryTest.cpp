@@ -0,0 +1,49 @@
+#include "Catch.h"
+
+#include "Host.h"
+#include "SpeedQuery.h"
+
+#include <array>
+#include <vector>
+
+namespace
+{
+    std::vector<float> Query(std::vector<Host::Actor*> targets, int32_t hand_mask)
+    {
+        Host::Game::Reset();
+
+        std::vector<float> result(targets.size() * SpeedQuery::Stride(hand_mask));
+
+        SpeedQuery::Fill(std::span<Host::Actor* const>{ targets }, hand_mask, result.data(),
+            [&](Host::Actor* target) { return SpeedHooks::GetBothEffectiveSpeeds<Host::Game>(target); },
+            [&](Host::Actor* target, bool right) { return SpeedHooks::GetEffectiveSpeed<Host::Game>(target, right); });
+
+        return result;
+    }
+}
+
+
+TEST_CASE("Each actor takes a slot per hand asked for", "[SpeedQuery]")
+{
+    CHECK(SpeedQuery::Stride(0) == 0);
+    CHECK(SpeedQuery::Stride(SpeedQuery::k_rightHand) == 1);
+    CHECK(SpeedQuery::Stride(SpeedQuery::k_leftHand) == 1);
+    CHECK(SpeedQuery::Stride(SpeedQuery::k_bothHands) == 2);
+
+    //Bits past the hands don't count.
+    CHECK(SpeedQuery::Stride(SpeedQuery::k_bothHands | 0x10) == 2);
+}
+
+TEST_CASE("Speeds come out right then left, nulls as zero", "[SpeedQuery]")
+{
+    Host::Actor fast;
+    fast.base = { 1.5f, 1.25f };
+
+    Host::Actor slow;
+    slow.base = { 0.75f, 1.f };
+
+    CHECK(Query({ &fast, nullptr, &slow }, SpeedQuery::k_bothHands) == std::vector{ 1.5f, 1.25f, 0.f, 0.f, 0.75f, 1.f });
+    CHECK(Query({ &fast, nullptr, &slow }, SpeedQuery::k_rightHand) == std::vector{ 1.5f, 0.f, 0.75f });
+    CHECK(Query({ &fast, nullptr, &slow }, SpeedQuery::k_leftHand) == std::vector{ 1.25f, 0.f, 1.f });
+    CHECK(Query({ &fast }, 0).empty());
+}
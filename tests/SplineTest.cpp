@@ -0,0 +1,141 @@
+#include "Catch.h"
+
+#include "Spline.h"
+
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    using Points = std::vector<std::pair<float, float>>;
+
+    Spline::Table Make(const Points& points)
+    {
+        auto table = Spline::Build(points);
+        REQUIRE(table);
+        return *table;
+    }
+
+    //Walks every segment in small steps, including the very ends.
+    template <class Check>
+    void Sweep(const Points& points, Check&& check)
+    {
+        constexpr int k_steps = 4096;
+
+        float low = points.front().first;
+        float high = points.back().first;
+
+        for (int i = 0; i <= k_steps; i++)
+            check(low + (high - low) * i / k_steps);
+    }
+
+    const Points k_speeds{ { 0.5f, 0.6f }, { 1.f, 1.f }, { 2.f, 1.8f }, { 3.f, 2.2f } };
+}
+
+
+TEST_CASE("Splines go through their points", "[Spline]")
+{
+    for (const Points& points : { k_speeds, Points{ { 0.f, 0.f }, { 1.f, 3.f } }, Points{ { 0.f, 1.f }, { 1.f, 0.f }, { 2.f, 1.f } } })
+    {
+        auto table = Make(points);
+
+        for (auto [x, y] : points)
+        {
+            INFO(x);
+            CHECK(table.Evaluate(x) == Approx(y).margin(1e-6));
+        }
+    }
+}
+
+TEST_CASE("Splines hold at the end points outside of them", "[Spline]")
+{
+    auto table = Make(k_speeds);
+
+    CHECK(table.Evaluate(0.f) == table.Evaluate(0.5f));
+    CHECK(table.Evaluate(-std::numeric_limits<float>::infinity()) == table.Evaluate(0.5f));
+    CHECK(table.Evaluate(10.f) == table.Evaluate(3.f));
+    CHECK(table.Evaluate(std::numeric_limits<float>::infinity()) == table.Evaluate(3.f));
+
+    CHECK(table.Evaluate(std::numeric_limits<float>::quiet_NaN()) == table.Evaluate(0.5f));
+}
+
+TEST_CASE("Rising points give a curve that never dips", "[Spline]")
+{
+    //Some with long flat stretches and sudden jumps, what a plain cubic spline would overshoot on.
+    const Points sets[]
+    {
+        k_speeds,
+        { { 0.f, 0.f }, { 1.f, 0.f }, { 1.1f, 1.f }, { 3.f, 1.f }, { 3.5f, 4.f } },
+        { { 0.1f, 0.1f }, { 0.2f, 0.9f }, { 0.3f, 0.95f }, { 4.f, 1.f } },
+    };
+
+    for (auto& points : sets)
+    {
+        auto table = Make(points);
+
+        float last = -std::numeric_limits<float>::infinity();
+
+        Sweep(points, [&](float x) {
+            float y = table.Evaluate(x);
+
+            INFO(x);
+            CHECK(y >= last);
+
+            //Never leaves the range of the points either.
+            CHECK(y >= points.front().second - 1e-6f);
+            CHECK(y <= points.back().second + 1e-6f);
+
+            last = y;
+        });
+    }
+}
+
+TEST_CASE("Splines flatten out at a peak instead of overshooting it", "[Spline]")
+{
+    Points points{ { 0.f, 0.f }, { 1.f, 2.f }, { 2.f, 0.f } };
+
+    auto table = Make(points);
+
+    Sweep(points, [&](float x) {
+        INFO(x);
+        CHECK(table.Evaluate(x) <= 2.f + 1e-6f);
+    });
+}
+
+TEST_CASE("Points on a line give the line", "[Spline]")
+{
+    Points points;
+
+    for (int i = 0; i < 16; i++)
+        points.emplace_back(i * 0.25f, 0.5f + i * 0.5f);
+
+    auto table = Make(points);
+
+    Sweep(points, [&](float x) {
+        INFO(x);
+        CHECK(table.Evaluate(x) == Approx(0.5f + x * 2.f).margin(1e-5));
+    });
+}
+
+TEST_CASE("Bad points are turned away", "[Spline]")
+{
+    CHECK_FALSE(Spline::Build({}));
+    CHECK_FALSE(Spline::Build({ { 1.f, 1.f } }));
+
+    Points many;
+
+    for (size_t i = 0; i <= Spline::k_maxKnots; i++)
+        many.emplace_back(static_cast<float>(i), 1.f);
+
+    CHECK_FALSE(Spline::Build(many));
+
+    many.pop_back();
+    CHECK(Spline::Build(many));
+
+    CHECK_FALSE(Spline::Build({ { 1.f, 1.f }, { 1.f, 2.f } }));
+    CHECK_FALSE(Spline::Build({ { 2.f, 1.f }, { 1.f, 2.f } }));
+    CHECK_FALSE(Spline::Build({ { 0.f, 1.f }, { 1.f, std::numeric_limits<float>::quiet_NaN() } }));
+    CHECK_FALSE(Spline::Build({ { 0.f, 1.f }, { std::numeric_limits<float>::infinity(), 2.f } }));
+}
@@ -0,0 +1,317 @@
+#include "Catch.h"
+
+#include "Host.h"
+#include "TagAudit.h"
+
+#include <chrono>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+TEST_CASE("Only whole steps count", "[TagAudit]")
+{
+    CHECK(TagAudit::Count(true, 1.f) == 1);
+    CHECK(TagAudit::Count(true, 2.5f) == 1);
+    CHECK(TagAudit::Count(true, 0.5f) == 0);
+    CHECK(TagAudit::Count(true, -1.f) == 0);
+    CHECK(TagAudit::Count(true, 0.f) == 0);
+
+    CHECK(TagAudit::Count(false, -1.f) == -1);
+    CHECK(TagAudit::Count(false, -3.f) == -1);
+    CHECK(TagAudit::Count(false, -0.5f) == 0);
+    CHECK(TagAudit::Count(false, 1.f) == 0);
+    CHECK(TagAudit::Count(false, 0.f) == 0);
+}
+
+TEST_CASE("Expected sums each hand on its own", "[TagAudit]")
+{
+    std::vector<TagAudit::Contribution> contributions
+    {
+        { true, 1.f },
+        { true, 2.f },
+        { true, 0.5f },
+        { false, 1.f },
+        { false, -1.f },
+    };
+
+    CHECK(TagAudit::Expected(contributions) == std::array{ 2.f, 1.f });
+    CHECK(TagAudit::Expected({}) == std::array{ 0.f, 0.f });
+}
+
+TEST_CASE("Tags kept up by start and finish match what's expected", "[TagAudit]")
+{
+    Host::Actor actor;
+
+    auto haste = actor.AddEffect({ .right = Host::k_right, .value = 1.f });
+    auto left = actor.AddEffect({ .right = Host::k_left, .value = 2.f });
+    auto slow = actor.AddEffect({ .right = Host::k_right, .value = -0.5f });
+    auto curse = actor.AddEffect({ .right = Host::k_right, .value = 1.f, .detrimental = true });
+
+    actor.Start(haste);
+    actor.Start(left);
+    actor.Start(slow);
+    actor.Start(curse);
+
+    CHECK(actor.tags == actor.Recompute());
+    CHECK(actor.tags == std::array{ 1.f, 1.f });
+
+    actor.Finish(haste);
+    actor.Finish(left);
+
+    CHECK(actor.tags == actor.Recompute());
+    CHECK(actor.tags == std::array{ 0.f, 0.f });
+}
+
+TEST_CASE("Only recovering, beneficial effects count", "[TagAudit]")
+{
+    CHECK(TagAudit::Applies(true, false, false));
+    CHECK_FALSE(TagAudit::Applies(false, false, false));
+    CHECK_FALSE(TagAudit::Applies(true, true, false));
+    CHECK_FALSE(TagAudit::Applies(true, false, true));
+}
+
+TEST_CASE("Finish and the audit go by what start decided", "[TagAudit]")
+{
+    //Either way the flags say now.
+    CHECK(TagAudit::Counts(TagAudit::kCounted, true, false));
+    CHECK(TagAudit::Counts(TagAudit::kCounted, false, true));
+    CHECK_FALSE(TagAudit::Counts(TagAudit::kSkipped, true, false));
+
+    //Padding that was never marked falls back on the rule, without the dispel check.
+    CHECK(TagAudit::Counts(0, true, false));
+    CHECK(TagAudit::Counts(0xCDCD, true, false));
+    CHECK_FALSE(TagAudit::Counts(0, false, false));
+    CHECK_FALSE(TagAudit::Counts(0, true, true));
+}
+
+TEST_CASE("Recompute counts by the same rule start and finish do", "[TagAudit]")
+{
+    Host::Actor actor;
+
+    std::vector<size_t> all
+    {
+        actor.AddEffect({ .right = Host::k_right, .value = 1.f }),
+        actor.AddEffect({ .right = Host::k_right, .value = 1.f, .recovers = false }),
+        actor.AddEffect({ .right = Host::k_right, .value = 2.f, .detrimental = true }),
+        actor.AddEffect({ .right = Host::k_left, .value = 1.f, .type = EffectHooks::kEnhance, .dispelled = true }),
+        actor.AddEffect({ .right = Host::k_left, .value = 3.f }),
+        actor.AddEffect({ .right = Host::k_left, .value = -2.f }),
+    };
+
+    for (auto index : all)
+    {
+        actor.Start(index);
+        CHECK(actor.tags == actor.Recompute());
+    }
+
+    CHECK(actor.tags == std::array{ 1.f, 1.f });
+
+    for (auto index : all)
+    {
+        actor.Finish(index);
+        CHECK(actor.tags == actor.Recompute());
+    }
+
+    CHECK(actor.tags == std::array{ 0.f, 0.f });
+}
+
+TEST_CASE("An enhance dispelled after it started still comes off on finish", "[TagAudit]")
+{
+    Host::Actor actor;
+
+    auto enhance = actor.AddEffect({ .right = Host::k_right, .value = 1.f, .type = EffectHooks::kEnhance });
+    auto haste = actor.AddEffect({ .right = Host::k_right, .value = 1.f });
+
+    actor.Start(enhance);
+    actor.Start(haste);
+
+    //A dispel flags the effect before it finishes.
+    actor.effects[enhance].dispelled = true;
+
+    CHECK(actor.tags == std::array{ 2.f, 0.f });
+    CHECK(actor.Recompute() == actor.tags);
+
+    actor.Finish(enhance);
+
+    CHECK(actor.tags == std::array{ 1.f, 0.f });
+    CHECK(actor.Recompute() == actor.tags);
+
+    actor.Finish(haste);
+
+    CHECK(actor.tags == std::array{ 0.f, 0.f });
+}
+
+TEST_CASE("An enhance dispelled before it started never counts", "[TagAudit]")
+{
+    Host::Actor actor;
+
+    auto enhance = actor.AddEffect({ .right = Host::k_right, .value = 1.f, .type = EffectHooks::kEnhance, .dispelled = true });
+
+    actor.Start(enhance);
+
+    CHECK(actor.tags == std::array{ 0.f, 0.f });
+    CHECK(actor.Recompute() == actor.tags);
+
+    actor.Finish(enhance);
+
+    CHECK(actor.tags == std::array{ 0.f, 0.f });
+}
+
+TEST_CASE("A dual modifier counts its second value on its own", "[TagAudit]")
+{
+    Host::Actor actor;
+
+    auto dual = actor.AddEffect({ .right = Host::k_right, .value = 1.f, .type = EffectHooks::kDualMod, .secondary = Host::k_left, .dualWeight = 2.f });
+    auto weak = actor.AddEffect({ .right = Host::k_right, .value = 1.f, .type = EffectHooks::kDualMod, .secondary = Host::k_left, .dualWeight = 0.5f });
+
+    actor.Start(dual);
+    actor.Start(weak);
+
+    //Half a step on the left is no step.
+    CHECK(actor.tags == std::array{ 2.f, 1.f });
+    CHECK(actor.Recompute() == actor.tags);
+
+    actor.Finish(dual);
+    actor.Finish(weak);
+
+    CHECK(actor.tags == std::array{ 0.f, 0.f });
+}
+
+TEST_CASE("A zero magnitude goes by the value instead", "[TagAudit]")
+{
+    Host::Actor actor;
+
+    auto odd = actor.AddEffect({ .right = Host::k_right, .value = 1.f, .magnitude = 0.f });
+    auto small = actor.AddEffect({ .right = Host::k_left, .value = 0.5f, .magnitude = 0.f });
+
+    actor.Start(odd);
+    actor.Start(small);
+
+    CHECK(actor.tags == std::array{ 1.f, 0.f });
+
+    actor.Finish(odd);
+    actor.Finish(small);
+
+    CHECK(actor.tags == std::array{ 0.f, 0.f });
+}
+
+TEST_CASE("A load only counts what has its values on", "[TagAudit]")
+{
+    Host::Actor actor;
+
+    auto on = actor.AddEffect({ .right = Host::k_right, .value = 1.f });
+    auto off = actor.AddEffect({ .right = Host::k_right, .value = 1.f, .applied = false });
+    auto failing = actor.AddEffect({ .right = Host::k_left, .value = 1.f, .conditionsHold = false });
+
+    actor.Load(on);
+    actor.Load(off);
+    actor.Load(failing);
+
+    CHECK(actor.tags == std::array{ 1.f, 0.f });
+    CHECK(actor.Recompute() == actor.tags);
+
+    //And what wasn't counted doesn't come off when it finishes.
+    actor.Finish(off);
+    actor.Finish(failing);
+
+    CHECK(actor.tags == std::array{ 1.f, 0.f });
+
+    actor.Finish(on);
+
+    CHECK(actor.tags == std::array{ 0.f, 0.f });
+}
+
+TEST_CASE("Start and finish mark the actor from where its speed was", "[TagAudit]")
+{
+    Host::Game::Reset();
+
+    Host::Actor actor;
+    actor.base = { 1.f, 1.f };
+
+    auto haste = actor.AddEffect({ .right = Host::k_right, .value = 0.5f });
+
+    auto before = SpeedHooks::GetBothEffectiveSpeeds<Host::Game>(&actor);
+
+    actor.Start(haste);
+
+    REQUIRE(Host::Game::changes.size() == 1);
+    CHECK(Host::Game::changes[0].actor == &actor);
+    CHECK(Host::Game::changes[0].old == before);
+
+    auto during = SpeedHooks::GetBothEffectiveSpeeds<Host::Game>(&actor);
+    CHECK(during[0] > before[0]);
+
+    actor.Finish(haste);
+
+    REQUIRE(Host::Game::changes.size() == 2);
+    CHECK(Host::Game::changes[1].old == during);
+    CHECK(SpeedHooks::GetBothEffectiveSpeeds<Host::Game>(&actor) == before);
+}
+
+TEST_CASE("The scheduler always gets through one", "[TagAudit]")
+{
+    TagAudit::Scheduler<int> scheduler;
+
+    CHECK(scheduler.Exhausted());
+
+    scheduler.Refill({ 1, 2, 3 });
+
+    std::vector<int> seen;
+    auto now = [] { return 0ns; };
+    auto visit = [&](int id) { seen.push_back(id); };
+
+    //No time at all still moves along.
+    CHECK(scheduler.Run(0ns, now, visit) == 1);
+    CHECK(scheduler.Remaining() == 2);
+
+    CHECK(scheduler.Run(0ns, now, visit) == 1);
+    CHECK(scheduler.Run(0ns, now, visit) == 1);
+    CHECK(scheduler.Exhausted());
+    CHECK(scheduler.Run(0ns, now, visit) == 0);
+
+    CHECK(seen == std::vector{ 1, 2, 3 });
+}
+
+TEST_CASE("The scheduler stops when the budget runs out", "[TagAudit]")
+{
+    TagAudit::Scheduler<int> scheduler;
+
+    scheduler.Refill({ 1, 2, 3, 4, 5, 6 });
+
+    //Each visit takes 10ns.
+    std::chrono::nanoseconds clock = 0ns;
+    auto now = [&] { return clock; };
+    auto visit = [&](int) { clock += 10ns; };
+
+    CHECK(scheduler.Run(25ns, now, visit) == 3);
+    CHECK(scheduler.Remaining() == 3);
+
+    CHECK(scheduler.Run(1000ns, now, visit) == 3);
+    CHECK(scheduler.Exhausted());
+
+    scheduler.Refill({ 7 });
+    CHECK(scheduler.Remaining() == 1);
+}
+
+TEST_CASE("A refill drops whatever was left of the last pass", "[TagAudit]")
+{
+    TagAudit::Scheduler<int> scheduler;
+
+    scheduler.Refill({ 1, 2, 3 });
+
+    std::vector<int> seen;
+    auto now = [] { return 0ns; };
+    auto visit = [&](int id) { seen.push_back(id); };
+
+    scheduler.Run(0ns, now, visit);
+    scheduler.Refill({ 4, 5 });
+
+    CHECK(scheduler.Remaining() == 2);
+    CHECK(scheduler.Run(1s, now, visit) == 2);
+    CHECK(seen == std::vector{ 1, 4, 5 });
+
+    //And an empty one is just done.
+    scheduler.Refill({});
+    CHECK(scheduler.Exhausted());
+    CHECK(scheduler.Run(1s, now, visit) == 0);
+}
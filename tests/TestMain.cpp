@@ -0,0 +1,3 @@
+//Catch2 2 wants its main defined in exactly one file, 3 links it in with Catch2WithMain.
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//A small timing harness for carp_bench. Each case is run in growing batches until a batch takes long enough to trust,
+// then that batch is timed a few more times and the fastest is kept, the rest is the machine doing something else.
+//
+// Results go out in the same json as a CARP_PROFILE build, so tools/compare_profile.py reads both. Times are in
+// nanoseconds here, so ticksPerNano is 1.
+
+namespace Bench
+{
+    using Clock = std::chrono::steady_clock;
+
+    //Keeps the compiler from throwing away work whose result is never used.
+    template <class T>
+    inline void DoNotOptimize(const T& value)
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    inline void ClobberMemory()
+    {
+        asm volatile("" : : : "memory");
+    }
+
+
+    struct Result
+    {
+        std::string name;
+        uint64_t calls = 0;
+        double totalNs = 0;
+
+        double NsPerCall() const { return calls ? totalNs / calls : 0; }
+    };
+
+    struct FrameStats
+    {
+        size_t count = 0;
+        double p50 = 0;
+        double p99 = 0;
+        double max = 0;
+    };
+
+
+    class Suite
+    {
+    public:
+        explicit Suite(std::string_view filter) : _filter{ filter } {}
+
+        //body is handed how many times to do the thing, and does it that many times.
+        template <class Body>
+        void Run(std::string name, Body&& body)
+        {
+            if (!_filter.empty() && name.find(_filter) == std::string::npos)
+                return;
+
+            constexpr auto k_minBatch = std::chrono::milliseconds{ 10 };
+            constexpr int k_repeats = 11;
+
+            uint64_t iterations = 1;
+
+            for (;;)
+            {
+                if (Time(body, iterations) >= k_minBatch || iterations >= (uint64_t{ 1 } << 40))
+                    break;
+
+                iterations *= 2;
+            }
+
+            auto best = Clock::duration::max();
+
+            for (int i = 0; i < k_repeats; i++)
+                best = std::min(best, Time(body, iterations));
+
+            Result result{ std::move(name), iterations, static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(best).count()) };
+
+            std::printf("%-56s %12.2f ns %14llu calls\n", result.name.c_str(), result.NsPerCall(), static_cast<unsigned long long>(result.calls));
+
+            _results.push_back(std::move(result));
+        }
+
+        //For a case that times itself, like the frame scenario.
+        void Add(Result result)
+        {
+            std::printf("%-56s %12.2f ns %14llu calls\n", result.name.c_str(), result.NsPerCall(), static_cast<unsigned long long>(result.calls));
+
+            _results.push_back(std::move(result));
+        }
+
+        bool Wants(std::string_view name) const
+        {
+            return _filter.empty() || name.find(_filter) != std::string_view::npos;
+        }
+
+        void SetFrames(std::vector<double> frames)
+        {
+            _frames = {};
+            _frames.count = frames.size();
+
+            if (frames.empty())
+                return;
+
+            std::ranges::sort(frames);
+
+            auto at = [&](double fraction) { return frames[std::min(static_cast<size_t>(fraction * frames.size()), frames.size() - 1)]; };
+
+            _frames.p50 = at(0.50);
+            _frames.p99 = at(0.99);
+            _frames.max = frames.back();
+
+            std::printf("%-56s p50 %.1fns, p99 %.1fns, max %.1fns over %zu frames\n", "frame", _frames.p50, _frames.p99, _frames.max, _frames.count);
+        }
+
+        bool WriteJson(const std::string& path, std::string_view version) const
+        {
+            std::ofstream file{ path };
+
+            if (!file)
+                return false;
+
+            file << "{\n";
+            file << "    \"version\": \"" << version << "\",\n";
+            file << "    \"ticksPerNano\": 1.0,\n";
+            file << "    \"frames\": {\n";
+            file << "        \"count\": " << _frames.count << ",\n";
+            file << "        \"p50Ns\": " << _frames.p50 << ",\n";
+            file << "        \"p99Ns\": " << _frames.p99 << ",\n";
+            file << "        \"maxNs\": " << _frames.max << "\n";
+            file << "    },\n";
+            file << "    \"counters\": {";
+
+            for (size_t i = 0; i < _results.size(); i++)
+            {
+                auto& result = _results[i];
+
+                file << (i ? ",\n" : "\n");
+                file << "        \"" << result.name << "\": { ";
+                file << "\"calls\": " << result.calls << ", ";
+                file << "\"ticks\": " << static_cast<uint64_t>(result.totalNs) << ", ";
+                file << "\"nsPerCall\": " << result.NsPerCall() << ", ";
+                file << "\"totalMs\": " << result.totalNs / 1e6 << " }";
+            }
+
+            file << "\n    }\n}\n";
+
+            return static_cast<bool>(file);
+        }
+
+    private:
+        template <class Body>
+        static Clock::duration Time(Body& body, uint64_t iterations)
+        {
+            auto start = Clock::now();
+            body(iterations);
+            ClobberMemory();
+            return Clock::now() - start;
+        }
+
+        std::string _filter;
+        std::vector<Result> _results;
+        FrameStats _frames;
+    };
+
+
+    //Cheap and the same every run, so a baseline always sees the same inputs.
+    class Random
+    {
+    public:
+        explicit Random(uint64_t seed = 0x9E3779B97F4A7C15) : _state{ seed } {}
+
+        uint64_t Next()
+        {
+            _state ^= _state << 13;
+            _state ^= _state >> 7;
+            _state ^= _state << 17;
+            return _state;
+        }
+
+        float Uniform(float low, float high)
+        {
+            return low + (high - low) * static_cast<float>(Next() >> 40) / static_cast<float>(1 << 24);
+        }
+
+    private:
+        uint64_t _state;
+    };
+}
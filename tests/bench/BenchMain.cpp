@@ -0,0 +1,81 @@
+#include "Bench.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+//carp_bench [--filter text] [--out file.json]
+//
+// Runs every case whose name has the filter in it, and writes the results for tools/compare_profile.py. The baseline next
+// to this file was taken on the machine named in its version, compare against one taken on the same machine.
+
+void CoreBenches(Bench::Suite& suite);
+void HookBenches(Bench::Suite& suite);
+void DispatchBenches(Bench::Suite& suite);
+void QueryBenches(Bench::Suite& suite);
+void FormTableBenches(Bench::Suite& suite);
+void ClassifyBenches(Bench::Suite& suite);
+void RegistryBenches(Bench::Suite& suite);
+void SlotsBenches(Bench::Suite& suite);
+void FrameBenches(Bench::Suite& suite);
+
+
+namespace
+{
+    std::string CpuName()
+    {
+        std::ifstream file{ "/proc/cpuinfo" };
+
+        for (std::string line; std::getline(file, line);)
+        {
+            if (line.starts_with("model name"))
+            {
+                auto colon = line.find(':');
+                return colon != std::string::npos ? line.substr(colon + 2) : line;
+            }
+        }
+
+        return "unknown cpu";
+    }
+}
+
+
+int main(int argc, char** argv)
+{
+    std::string filter;
+    std::string out;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!std::strcmp(argv[i], "--filter") && i + 1 < argc)
+            filter = argv[++i];
+        else if (!std::strcmp(argv[i], "--out") && i + 1 < argc)
+            out = argv[++i];
+        else
+        {
+            std::fprintf(stderr, "usage: %s [--filter text] [--out file.json]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    Bench::Suite suite{ filter };
+
+    CoreBenches(suite);
+    HookBenches(suite);
+    DispatchBenches(suite);
+    QueryBenches(suite);
+    FormTableBenches(suite);
+    ClassifyBenches(suite);
+    RegistryBenches(suite);
+    SlotsBenches(suite);
+    FrameBenches(suite);
+
+    if (!out.empty() && !suite.WriteJson(out, "carp_bench, " + CpuName()))
+    {
+        std::fprintf(stderr, "couldn't write %s\n", out.c_str());
+        return 1;
+    }
+
+    return 0;
+}
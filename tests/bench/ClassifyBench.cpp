@@ -0,0 +1,145 @@
+#include "Bench.h"
+
+#include "EffectIndex.h"
+#include "FormTable.h"
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+//What the effect hooks pay to know what an effect or spell is: the lookup in the table EffectClasses builds on data loaded,
+// against working it out from the record every time like before (and still for anything made at runtime). The records are
+// made up but the ids, flags and actor values are spread like a real load order's, with 2 of the 164 actor values being
+// the speed ones. Only the record side's own reads are here, not the cache misses of getting at a form in the game.
+
+namespace
+{
+    constexpr size_t k_forms = 8192;
+
+    struct Setting
+    {
+        uint32_t formID;
+        uint32_t flags;
+        int32_t primaryAV;
+        int32_t secondaryAV;
+    };
+
+    //Spell and casting type are virtual calls on MagicItem, so they are here too.
+    struct Item
+    {
+        virtual ~Item() = default;
+        virtual uint32_t GetSpellType() const = 0;
+        virtual uint32_t GetCastingType() const = 0;
+
+        uint32_t formID = 0;
+    };
+
+    struct Spell : Item
+    {
+        uint32_t GetSpellType() const override { return spellType; }
+        uint32_t GetCastingType() const override { return castingType; }
+
+        uint32_t spellType = 0;
+        uint32_t castingType = 0;
+    };
+
+    struct Enchantment : Item
+    {
+        uint32_t GetSpellType() const override { return EffectIndex::k_spellEnchantment; }
+        uint32_t GetCastingType() const override { return castingType; }
+
+        uint32_t castingType = 0;
+    };
+
+    constexpr int32_t k_weaponSpeedMult = 156;
+    constexpr int32_t k_leftWeaponSpeedMultiply = 157;
+
+    bool IsSpeed(int32_t av)
+    {
+        return av == k_weaponSpeedMult || av == k_leftWeaponSpeedMultiply;
+    }
+
+    //Same as EffectClasses::Classify.
+    uint8_t Classify(const Setting& setting)
+    {
+        uint8_t result = EffectIndex::ClassifyEffect(setting.flags);
+
+        if (IsSpeed(setting.primaryAV) || IsSpeed(setting.secondaryAV))
+            result |= EffectIndex::kSpeedRelevant;
+
+        return result;
+    }
+}
+
+
+void ClassifyBenches(Bench::Suite& suite)
+{
+    Bench::Random random;
+
+    auto id = [&] { return (static_cast<uint32_t>(random.Uniform(0.f, 8.f)) << 24) | static_cast<uint32_t>(random.Uniform(1.f, 0xFFFFFF)); };
+
+    std::vector<Setting> settings(k_forms);
+    std::vector<std::unique_ptr<Item>> items(k_forms);
+
+    std::vector<std::pair<uint32_t, uint8_t>> entries;
+
+    for (auto& setting : settings)
+    {
+        setting = { id(), static_cast<uint32_t>(random.Uniform(0.f, 1.f) * 0xFFFFFF),
+            static_cast<int32_t>(random.Uniform(-1.f, 164.f)), static_cast<int32_t>(random.Uniform(-1.f, 164.f)) };
+
+        entries.emplace_back(setting.formID, Classify(setting));
+    }
+
+    for (auto& item : items)
+    {
+        auto casting = static_cast<uint32_t>(random.Uniform(0.f, 3.f));
+
+        if (random.Uniform(0.f, 1.f) < 0.5f) {
+            auto spell = std::make_unique<Spell>();
+            spell->spellType = static_cast<uint32_t>(random.Uniform(0.f, 12.f));
+            spell->castingType = casting;
+            item = std::move(spell);
+        }
+        else {
+            auto enchantment = std::make_unique<Enchantment>();
+            enchantment->castingType = casting;
+            item = std::move(enchantment);
+        }
+
+        item->formID = id();
+
+        entries.emplace_back(item->formID, EffectIndex::ClassifyItem(item->GetSpellType(), item->GetCastingType()));
+    }
+
+    FormTable<uint8_t> table{ std::move(entries) };
+
+    //Hooks see effects in no particular order, so neither do these.
+    std::vector<uint32_t> order(k_forms);
+
+    for (auto& index : order)
+        index = static_cast<uint32_t>(random.Uniform(0.f, k_forms - 1));
+
+    suite.Run("classify/effect table", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++)
+            Bench::DoNotOptimize(*table.find(settings[order[i % k_forms]].formID));
+    });
+
+    suite.Run("classify/effect from record", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++)
+            Bench::DoNotOptimize(Classify(settings[order[i % k_forms]]));
+    });
+
+    suite.Run("classify/item table", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++)
+            Bench::DoNotOptimize(*table.find(items[order[i % k_forms]]->formID));
+    });
+
+    suite.Run("classify/item from record", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            auto& item = *items[order[i % k_forms]];
+            Bench::DoNotOptimize(EffectIndex::ClassifyItem(item.GetSpellType(), item.GetCastingType()));
+        }
+    });
+}
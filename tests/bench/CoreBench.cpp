@@ -0,0 +1,203 @@
+#include "Bench.h"
+#include "Host.h"
+
+#include "CurveExpression.h"
+#include "Effectiveness.h"
+#include "Spline.h"
+#include "SpeedCurve.h"
+#include "TagAudit.h"
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+//The math every hook ends up in: the curve, the tag counting, the effectiveness scaling, and the per frame settings check.
+
+namespace
+{
+    constexpr size_t k_inputs = 1024;
+
+    std::vector<float> Speeds(float low, float high)
+    {
+        Bench::Random random;
+        std::vector<float> result(k_inputs);
+
+        for (auto& speed : result)
+            speed = random.Uniform(low, high);
+
+        return result;
+    }
+
+
+    void CurveBenches(Bench::Suite& suite)
+    {
+        auto speeds = Speeds(0.f, 4.f);
+
+        SpeedCurve::Params clamped;
+        clamped.Set(0.5f, 2.f, 0.2f, 3.f);
+
+        SpeedCurve::Params tapered;
+        tapered.Set(0.5f, 0.f, 0.2f, 3.f);
+
+        suite.Run("curve/apply clamp", [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++)
+                Bench::DoNotOptimize(SpeedCurve::Apply(clamped, speeds[i % k_inputs], 1.f));
+        });
+
+        suite.Run("curve/apply taper", [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++)
+                Bench::DoNotOptimize(SpeedCurve::Apply(tapered, speeds[i % k_inputs], 1.f));
+        });
+
+        //The taper written out as a custom curve, with the settings bound like a profile's would be.
+        auto program = CurveExpression::Program::Parse(
+            "select(x > capSpeed, capSpeed + sqrt(x - capSpeed) * pow(speedTaper, 1 / (x - capSpeed)), max(x, minSpeed))")->
+            Bind(CurveExpression::Var::MinSpeed, 0.5f).
+            Bind(CurveExpression::Var::CapSpeed, 2.f).
+            Bind(CurveExpression::Var::SpeedTaper, 0.2f).
+            Bind(CurveExpression::Var::MaxSpeed, 3.f);
+
+        auto inputs = [&](uint64_t i) { return CurveExpression::Inputs{ speeds[i % k_inputs], 1.f }; };
+
+        suite.Run("curve/expression interpreted", [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++)
+                Bench::DoNotOptimize(program.Run(inputs(i).data()));
+        });
+
+#ifdef CARP_CURVE_JIT
+        CurveExpression::Compiled compiled{ program };
+        auto native = compiled.get();
+
+        suite.Run("curve/expression compiled", [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++)
+                Bench::DoNotOptimize(native(inputs(i).data()));
+        });
+#endif
+
+        //The same shape as a spline, and one using every knot there is. Should cost the same, it's a count over all of them
+        // either way.
+        auto spline = *Spline::Build({ { 0.5f, 0.5f }, { 1.f, 1.f }, { 2.f, 2.f }, { 3.f, 2.3f } });
+
+        std::vector<std::pair<float, float>> points;
+
+        for (size_t i = 0; i < Spline::k_maxKnots; i++)
+            points.emplace_back(0.25f * (i + 1), std::sqrt(0.25f * (i + 1)));
+
+        auto full = *Spline::Build(points);
+
+        suite.Run("curve/spline 4 knots", [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++)
+                Bench::DoNotOptimize(spline.Evaluate(speeds[i % k_inputs]));
+        });
+
+        suite.Run("curve/spline 16 knots", [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++)
+                Bench::DoNotOptimize(full.Evaluate(speeds[i % k_inputs]));
+        });
+
+        suite.Run("curve/params set", [&](uint64_t n) {
+            SpeedCurve::Params params;
+            for (uint64_t i = 0; i < n; i++) {
+                params.Set(speeds[i % k_inputs], 2.f, 0.2f, 3.f);
+                Bench::DoNotOptimize(params);
+            }
+        });
+    }
+
+
+    void TagBenches(Bench::Suite& suite)
+    {
+        auto values = Speeds(-3.f, 3.f);
+
+        suite.Run("tags/count", [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++)
+                Bench::DoNotOptimize(TagAudit::Count(i & 1, values[i % k_inputs]));
+        });
+
+        //About what a buffed actor in the middle of a fight carries.
+        std::vector<TagAudit::Contribution> contributions;
+
+        for (size_t i = 0; i < 8; i++)
+            contributions.push_back({ (i & 1) == 0, values[i] });
+
+        suite.Run("tags/expected 8 effects", [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++) {
+                Bench::DoNotOptimize(contributions.data());
+                Bench::DoNotOptimize(TagAudit::Expected(contributions));
+            }
+        });
+
+        TagAudit::Scheduler<uint32_t> scheduler;
+        std::vector<uint32_t> ids(256);
+
+        for (uint32_t i = 0; i < ids.size(); i++)
+            ids[i] = i;
+
+        suite.Run("tags/scheduler visit", [&](uint64_t n) {
+            uint64_t sum = 0;
+            auto now = [] { return std::chrono::steady_clock::now().time_since_epoch(); };
+
+            for (uint64_t i = 0; i < n; i++) {
+                if (scheduler.Exhausted())
+                    scheduler.Refill(ids);
+
+                scheduler.Run(std::chrono::nanoseconds{ 0 }, now, [&](uint32_t id) { sum += id; });
+            }
+
+            Bench::DoNotOptimize(sum);
+        });
+    }
+
+
+    void EffectivenessBenches(Bench::Suite& suite)
+    {
+        auto magnitudes = Speeds(-5.f, 5.f);
+        auto effectiveness = Speeds(0.f, 2.f);
+
+        float min = Effectiveness::MinMagnitude(1.f);
+
+        suite.Run("effectiveness/scale magnitude", [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++)
+                Bench::DoNotOptimize(Effectiveness::ScaleMagnitude(magnitudes[i % k_inputs], effectiveness[(i * 7) % k_inputs], min));
+        });
+
+        suite.Run("effectiveness/min magnitude", [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++)
+                Bench::DoNotOptimize(Effectiveness::MinMagnitude(magnitudes[i % k_inputs]));
+        });
+    }
+
+
+    void SettingsBenches(Bench::Suite& suite)
+    {
+        Host::Settings settings;
+        settings.profiles.resize(16);
+        settings.Refresh(true);
+
+        //What every frame pays when nothing moved.
+        suite.Run("settings/epoch check", [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++) {
+                Bench::ClobberMemory();
+                Bench::DoNotOptimize(settings.Refresh());
+            }
+        });
+
+        //And when the MCM touched one, taking a new snapshot of everything into 16 profiles.
+        suite.Run("settings/epoch rebuild 16 profiles", [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++) {
+                settings.minSpeed.currValue = (i & 1) ? 0.5f : 0.6f;
+                Bench::DoNotOptimize(settings.Refresh());
+            }
+        });
+    }
+}
+
+
+void CoreBenches(Bench::Suite& suite)
+{
+    CurveBenches(suite);
+    TagBenches(suite);
+    EffectivenessBenches(suite);
+    SettingsBenches(suite);
+}
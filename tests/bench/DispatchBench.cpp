@@ -0,0 +1,292 @@
+#include "Bench.h"
+
+#include "Prologue.h"
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <sys/mman.h>
+
+//What each hook style costs to get into and back out of, apart from anything a thunk does. The game's side of each chain
+// is machine code written into an executable buffer the same way HookRegistry.h writes it into the game: a rel32 call or
+// jmp to a trampoline stub, an absolute jump from the stub to the thunk, a vtable slot swapped for thunk<I>, and a prologue
+// relocated by Prologue::Relocate for the detour to call back into.
+//
+// Every chain ends in the same original (push rbx; sub rsp, 20h; addss xmm0, xmm0; ...), and every thunk just forwards,
+// so the difference between a chain and the unhooked call is the dispatch. Each call feeds the next, so it's latency
+// that's measured, not how many can be in flight at once.
+
+namespace
+{
+    using Function = float (*)(float);
+    using VirtualFunction = float (*)(void*, float);
+
+    constexpr size_t k_vfuncs = 5;
+
+
+    //sub rsp, 28h; call rel32; add rsp, 28h; ret. The call is at +4.
+    std::vector<uint8_t> Caller(uintptr_t at, uintptr_t target)
+    {
+        std::vector<uint8_t> code{ 0x48, 0x83, 0xEC, 0x28, 0xE8, 0, 0, 0, 0, 0x48, 0x83, 0xC4, 0x28, 0xC3 };
+        auto disp = static_cast<int32_t>(static_cast<intptr_t>(target) - static_cast<intptr_t>(at + 9));
+        std::memcpy(code.data() + 5, &disp, sizeof(disp));
+        return code;
+    }
+
+
+    class CodeBuffer
+    {
+    public:
+        explicit CodeBuffer(size_t size) : _size{ size }
+        {
+            auto memory = mmap(nullptr, size, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            _base = memory != MAP_FAILED ? static_cast<uint8_t*>(memory) : nullptr;
+        }
+
+        ~CodeBuffer()
+        {
+            if (_base)
+                munmap(_base, _size);
+        }
+
+        CodeBuffer(const CodeBuffer&) = delete;
+        CodeBuffer& operator=(const CodeBuffer&) = delete;
+
+        explicit operator bool() const { return _base != nullptr; }
+
+        //Functions start 16 aligned, the same as what MSVC puts out.
+        uintptr_t Reserve(size_t size)
+        {
+            _used = (_used + 15) & ~size_t{ 15 };
+
+            auto address = reinterpret_cast<uintptr_t>(_base + _used);
+            _used += size;
+
+            return address;
+        }
+
+        uintptr_t Emit(const std::vector<uint8_t>& code)
+        {
+            auto address = Reserve(code.size());
+            std::memcpy(reinterpret_cast<void*>(address), code.data(), code.size());
+            return address;
+        }
+
+        //A caller has to know where it lives to reach its target.
+        uintptr_t EmitCaller(uintptr_t target)
+        {
+            auto address = Reserve(14);
+            auto code = Caller(address, target);
+            std::memcpy(reinterpret_cast<void*>(address), code.data(), code.size());
+            return address;
+        }
+
+        //jmp [rip]; dq dst. What WriteRelative puts in the trampoline.
+        uintptr_t EmitStub(uintptr_t dst)
+        {
+            std::vector<uint8_t> code{ 0xFF, 0x25, 0x00, 0x00, 0x00, 0x00 };
+            code.resize(14);
+            std::memcpy(code.data() + 6, &dst, sizeof(dst));
+            return Emit(code);
+        }
+
+    private:
+        uint8_t* _base = nullptr;
+        size_t _size = 0;
+        size_t _used = 0;
+    };
+
+
+    //push rbx; sub rsp, 20h; addss xmm0, xmm0; add rsp, 20h; pop rbx; ret
+    const std::vector<uint8_t> k_original
+    {
+        0x40, 0x53,
+        0x48, 0x83, 0xEC, 0x20,
+        0xF3, 0x0F, 0x58, 0xC0,
+        0x48, 0x83, 0xC4, 0x20,
+        0x5B,
+        0xC3,
+    };
+
+    //sub rsp, 28h; mov rax, [rdi]; call [rax + index * 8]; add rsp, 28h; ret
+    std::vector<uint8_t> VirtualCaller(size_t index)
+    {
+        return { 0x48, 0x83, 0xEC, 0x28, 0x48, 0x8B, 0x07, 0xFF, 0x50, static_cast<uint8_t>(index * 8), 0x48, 0x83, 0xC4, 0x28, 0xC3 };
+    }
+
+    //Points the rel32 call or jmp at address to stub and hands back where it went before, like WriteRelative.
+    uintptr_t PatchRelative(uintptr_t address, uint8_t opcode, uintptr_t stub)
+    {
+        auto code = reinterpret_cast<uint8_t*>(address);
+
+        int32_t old_disp;
+        std::memcpy(&old_disp, code + 1, sizeof(old_disp));
+        auto original = address + 5 + old_disp;
+
+        auto disp = static_cast<int32_t>(static_cast<intptr_t>(stub) - static_cast<intptr_t>(address + 5));
+        code[0] = opcode;
+        std::memcpy(code + 1, &disp, sizeof(disp));
+
+        return original;
+    }
+
+
+    struct CallHook
+    {
+        static float thunk(float x)
+        {
+            return func(x);
+        }
+
+        static inline Function func;
+    };
+
+    //Replaces the function outright, like WeaponSpeedMultHook, so it does the original's work itself.
+    struct BranchHook
+    {
+        static float thunk(float x)
+        {
+            return x + x;
+        }
+    };
+
+    struct DetourHook
+    {
+        static float thunk(float x)
+        {
+            return func(x);
+        }
+
+        static inline Function func;
+    };
+
+    struct VfuncHook
+    {
+        template <int I>
+        static float thunk(void* a_this, float x)
+        {
+            return func[I](a_this, x);
+        }
+
+        static inline VirtualFunction func[k_vfuncs];
+    };
+
+
+    struct Object
+    {
+        const uintptr_t* vtable;
+    };
+
+
+    template <class Call>
+    void RunChain(Bench::Suite& suite, std::string name, Call call)
+    {
+        //Anything that doesn't come back doubled isn't running the chain it claims to be.
+        if (call(1.5f) != 3.f) {
+            std::fprintf(stderr, "%s is broken, got %f\n", name.c_str(), call(1.5f));
+            return;
+        }
+
+        suite.Run(std::move(name), [&](uint64_t n) {
+            float x = 1.f;
+
+            for (uint64_t i = 0; i < n; i++)
+                x = call(x) * 0.5f;
+
+            Bench::DoNotOptimize(x);
+        });
+    }
+}
+
+
+void DispatchBenches(Bench::Suite& suite)
+{
+    CodeBuffer buffer{ 0x4000 };
+
+    if (!buffer) {
+        std::fprintf(stderr, "dispatch: couldn't map executable memory, skipped\n");
+        return;
+    }
+
+    auto original = buffer.Emit(k_original);
+    auto branched = buffer.Emit(k_original);
+    auto detoured = buffer.Emit(k_original);
+
+    auto plain_caller = buffer.EmitCaller(original);
+    auto call_caller = buffer.EmitCaller(original);
+    auto branch_caller = buffer.EmitCaller(branched);
+    auto detour_caller = buffer.EmitCaller(detoured);
+
+    std::array<uintptr_t, k_vfuncs> virtual_callers;
+
+    for (size_t i = 0; i < k_vfuncs; i++)
+        virtual_callers[i] = buffer.Emit(VirtualCaller(i));
+
+
+    //write_call: the call site goes to a stub, the stub to the thunk, the thunk back to what the call used to reach.
+    auto call_stub = buffer.EmitStub(reinterpret_cast<uintptr_t>(&CallHook::thunk));
+    CallHook::func = reinterpret_cast<Function>(PatchRelative(call_caller + 4, 0xE8, call_stub));
+
+    //write_branch: the function's first 5 bytes jump to a stub, nothing calls back.
+    auto branch_stub = buffer.EmitStub(reinterpret_cast<uintptr_t>(&BranchHook::thunk));
+    PatchRelative(branched, 0xE9, branch_stub);
+
+    //write_detour: same jump in, the thunk calls the relocated prologue, which jumps back in past the hook.
+    auto prologue = buffer.Reserve(0x80);
+    auto relocation = Prologue::Relocate(reinterpret_cast<const uint8_t*>(detoured), detoured, 5, prologue, 0x80);
+
+    if (!relocation) {
+        std::fprintf(stderr, "dispatch: couldn't relocate the test prologue, skipped\n");
+        return;
+    }
+
+    std::memcpy(reinterpret_cast<void*>(prologue), relocation->code.data(), relocation->code.size());
+    DetourHook::func = reinterpret_cast<Function>(prologue);
+
+    auto detour_stub = buffer.EmitStub(reinterpret_cast<uintptr_t>(&DetourHook::thunk));
+    PatchRelative(detoured, 0xE9, detour_stub);
+    std::memset(reinterpret_cast<uint8_t*>(detoured) + 5, 0xCC, relocation->consumed - 5);
+
+
+    //write_vfunc: the slot is swapped for thunk<I>, which calls what was in it through func[I].
+    std::array<uintptr_t, k_vfuncs> plain_vtable;
+    plain_vtable.fill(original);
+
+    std::array<uintptr_t, k_vfuncs> hooked_vtable
+    {
+        reinterpret_cast<uintptr_t>(&VfuncHook::thunk<0>),
+        reinterpret_cast<uintptr_t>(&VfuncHook::thunk<1>),
+        reinterpret_cast<uintptr_t>(&VfuncHook::thunk<2>),
+        reinterpret_cast<uintptr_t>(&VfuncHook::thunk<3>),
+        reinterpret_cast<uintptr_t>(&VfuncHook::thunk<4>),
+    };
+
+    for (auto& func : VfuncHook::func)
+        func = reinterpret_cast<VirtualFunction>(original);
+
+    Object plain_object{ plain_vtable.data() };
+    Object hooked_object{ hooked_vtable.data() };
+
+
+    auto as_function = [](uintptr_t address) { return reinterpret_cast<Function>(address); };
+    auto as_virtual = [](uintptr_t address) { return reinterpret_cast<VirtualFunction>(address); };
+
+    RunChain(suite, "dispatch/unhooked call", as_function(plain_caller));
+    RunChain(suite, "dispatch/write_call", as_function(call_caller));
+    RunChain(suite, "dispatch/write_branch", as_function(branch_caller));
+    RunChain(suite, "dispatch/write_detour", as_function(detour_caller));
+
+    auto plain_virtual = as_virtual(virtual_callers[0]);
+    RunChain(suite, "dispatch/unhooked vfunc", [&](float x) { return plain_virtual(&plain_object, x); });
+
+    //Each thunk<I> is its own function with its own func[I], so each gets its own line.
+    for (size_t i = 0; i < k_vfuncs; i++)
+    {
+        auto caller = as_virtual(virtual_callers[i]);
+        RunChain(suite, "dispatch/write_vfunc thunk<" + std::to_string(i) + ">", [&](float x) { return caller(&hooked_object, x); });
+    }
+}
@@ -0,0 +1,68 @@
+#include "Bench.h"
+
+#include "FormTable.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+//The perfect hash table the overrides and profiles are looked up in, against the unordered_map it replaced. Ids are
+// spread over a few plugin indices like a real load order, lookups are half hits and half misses from the same plugins,
+// which is what the weapon hooks see with a handful of overrides and every other weapon in the game missing.
+
+namespace
+{
+    constexpr size_t k_lookups = 4096;
+
+    std::vector<std::pair<uint32_t, float>> Entries(Bench::Random& random, size_t count)
+    {
+        std::vector<std::pair<uint32_t, float>> result;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            uint32_t plugin = static_cast<uint32_t>(random.Uniform(0.f, 8.f)) << 24;
+            result.emplace_back(plugin | (static_cast<uint32_t>(random.Uniform(0.f, 1.f) * 0xFFFFFF) + 1), random.Uniform(0.5f, 1.5f));
+        }
+
+        return result;
+    }
+}
+
+
+void FormTableBenches(Bench::Suite& suite)
+{
+    Bench::Random random;
+
+    for (size_t count : { 16, 1000 })
+    {
+        auto entries = Entries(random, count);
+
+        FormTable<float> table{ entries };
+        std::unordered_map<uint32_t, float> map{ entries.begin(), entries.end() };
+
+        std::vector<uint32_t> keys;
+
+        for (size_t i = 0; i < k_lookups; i++)
+            keys.push_back(i & 1 ? entries[i % entries.size()].first : Entries(random, 1).front().first);
+
+        auto suffix = " " + std::to_string(count);
+
+        suite.Run("formtable/find" + suffix, [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++)
+                Bench::DoNotOptimize(table.find(keys[i % k_lookups]));
+        });
+
+        suite.Run("formtable/unordered_map find" + suffix, [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++)
+                Bench::DoNotOptimize(map.find(keys[i % k_lookups]));
+        });
+
+        //Only paid on data loaded, but it's the part that can go wrong with a bad seed search.
+        suite.Run("formtable/build" + suffix, [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++)
+                Bench::DoNotOptimize(FormTable<float>{ entries }.size());
+        });
+    }
+}
@@ -0,0 +1,207 @@
+#include "Bench.h"
+#include "Host.h"
+
+#include "SpeedHooks.h"
+#include "TagAudit.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+//A whole frame of what CARP does with 200 actors loaded, timed frame by frame for a p50/p99 that can be held against the
+// in game CARP_PROFILE numbers. It runs the plugin's own bodies from SpeedHooks.h and EffectHooks.h over Host::Game, so
+// only the game's side is stood in for:
+//
+// - every actor asks WeaponSpeedMult for both hands twice a frame, like the animation graph does while it's in combat
+// - a quarter of them are in an 8 frame attack at any time, half of those with an attack speed perk. Pins hold the perks
+//   through the swing, and attackStop drops them at the end
+// - a quarter sit in a lower process and go through the evaluation tiers
+// - a few effects start and finish somewhere each frame, moving the tags and marking the actor with a listener about
+// - PlayerUpdateHook's once a frame work, then the tag audit's budget once a pass is due
+//
+// Everything is seeded, so each run does the same work, and the order of frames is the same.
+
+namespace
+{
+    using Pins = SpeedHooks::AttackPins<Host::Game>;
+    using Tiers = SpeedHooks::EvaluationTiers<Host::Game>;
+    using Fused = SpeedHooks::FusedSpeedCache<Host::Game>;
+
+    constexpr size_t k_actors = 200;
+    constexpr size_t k_effectsPerActor = 4;
+    constexpr size_t k_queriesPerFrame = 2;
+    constexpr size_t k_changesPerFrame = 4;
+    constexpr uint64_t k_attackFrames = 8;
+    constexpr uint64_t k_drawFrames = 2;
+    constexpr size_t k_warmup = 200;
+    constexpr size_t k_frames = 2000;
+    constexpr float k_delta = 1.f / 60;
+    constexpr auto k_auditBudget = std::chrono::microseconds{ 20 };
+    constexpr uint64_t k_framesPerPass = 60;
+
+    //The game's process levels, high through low.
+    constexpr int32_t k_highProcess = 0;
+    constexpr int32_t k_lowProcess = 3;
+
+
+    struct Scenario
+    {
+        std::vector<Host::Actor> actors = std::vector<Host::Actor>(k_actors);
+        std::vector<Host::Weapon> weapons = std::vector<Host::Weapon>(k_actors);
+
+        TagAudit::Scheduler<uint32_t> scheduler;
+        std::vector<uint32_t> everyone;
+
+        Bench::Random random;
+        uint64_t frame = 0;
+        float sink = 0;
+
+        Scenario()
+        {
+            Host::Game::Reset();
+
+            for (uint32_t i = 0; i < k_actors; i++)
+            {
+                auto& actor = actors[i];
+
+                actor.formID = 0xFF000800 + i;
+                actor.base = { 1.f, 1.f };
+                actor.processLevel = i % 4 == 3 ? k_lowProcess : k_highProcess;
+
+                //About what a perk tree with one attack speed perk in it comes to.
+                if (i & 1)
+                    actor.perks = { 1.1f, 1.1f };
+
+                for (size_t j = 0; j < k_effectsPerActor; j++)
+                {
+                    actor.AddEffect({
+                        .right = j % 2 == 0,
+                        .value = random.Uniform(-1.5f, 1.5f),
+                        .recovers = j != 3,
+                        .detrimental = j == 2 });
+                }
+
+                auto& weapon = weapons[i];
+
+                weapon.speed = random.Uniform(0.7f, 1.3f);
+                weapon.type = static_cast<uint8_t>(random.Uniform(0.f, Host::Settings::k_weaponTypes));
+
+                actor.twoHanded = std::ranges::find(Host::Settings::k_twoHanded, weapon.type) != std::end(Host::Settings::k_twoHanded);
+
+                Host::Game::loaded[actor.formID] = &actor;
+                everyone.push_back(i);
+            }
+        }
+
+        //What TagAuditor::Audit does with one actor.
+        void Audit(uint32_t index)
+        {
+            auto& actor = actors[index];
+            auto expected = actor.Recompute();
+
+            if (actor.tags == expected)
+                return;
+
+            Host::Game::BeforeSpeedChange(&actor);
+            actor.tags = expected;
+            Host::Game::Sync(&actor);
+        }
+
+        //Who's attacking moves on by a quarter every k_attackFrames, with attackStop on the way out.
+        void Attacks()
+        {
+            for (size_t i = 0; i < k_actors; i++)
+            {
+                auto& actor = actors[i];
+
+                uint64_t into = (frame + i * k_attackFrames) % (4 * k_attackFrames);
+                bool attacking = into < k_attackFrames;
+
+                if (actor.attacking && !attacking)
+                    Pins::Release(&actor, Host::Game::BeforeSpeedChange);
+
+                actor.attacking = attacking;
+                actor.drawing = attacking && into < k_drawFrames;
+            }
+        }
+
+        void Frame()
+        {
+            frame++;
+
+            //Only there for the tests to look at.
+            Host::Game::changes.clear();
+
+            //PlayerUpdateHook.
+            Host::Game::settings.Refresh();
+            Fused::Invalidate();
+            Pins::Sweep(Host::Game::BeforeSpeedChange);
+            Tiers::Advance(k_delta);
+
+            Attacks();
+
+            for (size_t i = 0; i < k_actors; i++)
+            {
+                for (size_t q = 0; q < k_queriesPerFrame; q++)
+                {
+                    sink += SpeedHooks::WeaponSpeedMult<Host::Game>(&actors[i], &weapons[i], false);
+                    sink += SpeedHooks::WeaponSpeedMult<Host::Game>(&actors[i], &weapons[i], true);
+                }
+            }
+
+            for (size_t i = 0; i < k_changesPerFrame; i++)
+            {
+                auto& actor = actors[static_cast<size_t>(random.Uniform(0.f, k_actors - 1))];
+                auto effect = static_cast<size_t>(random.Uniform(0.f, k_effectsPerActor - 1));
+
+                if (actor.effects[effect].active)
+                    actor.Finish(effect);
+                else
+                    actor.Start(effect);
+            }
+
+            //A new pass at most once a second, like TagAuditor::Tick at 60 frames a second.
+            if (scheduler.Exhausted() && frame % k_framesPerPass == 0)
+                scheduler.Refill(everyone);
+
+            scheduler.Run(k_auditBudget, [] { return Bench::Clock::now().time_since_epoch(); }, [&](uint32_t index) { Audit(index); });
+        }
+    };
+}
+
+
+void FrameBenches(Bench::Suite& suite)
+{
+    if (!suite.Wants("frame/200 actors"))
+        return;
+
+    Scenario scenario;
+
+    for (size_t i = 0; i < k_warmup; i++)
+        scenario.Frame();
+
+    std::vector<double> frames;
+    frames.reserve(k_frames);
+
+    auto total = Bench::Clock::duration::zero();
+
+    for (size_t i = 0; i < k_frames; i++)
+    {
+        auto start = Bench::Clock::now();
+        scenario.Frame();
+        Bench::ClobberMemory();
+        auto elapsed = Bench::Clock::now() - start;
+
+        total += elapsed;
+        frames.push_back(static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+
+    Bench::DoNotOptimize(scenario.sink);
+
+    suite.Add({ "frame/200 actors", k_frames, static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(total).count()) });
+    suite.SetFrames(std::move(frames));
+
+    Host::Game::Reset();
+}
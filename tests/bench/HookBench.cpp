@@ -0,0 +1,49 @@
+#include "Bench.h"
+
+#include "Prologue.h"
+
+#include <cstdint>
+#include <vector>
+
+//What putting a hook in costs, the decoder and relocation that every detour goes through at startup.
+
+namespace
+{
+    //The start of GetActorValueModifier, then a few more of the shapes the decoder sees.
+    const std::vector<uint8_t> k_code
+    {
+        0x40, 0x53,
+        0x48, 0x83, 0xEC, 0x20,
+        0x48, 0x8B, 0x05, 1, 2, 3, 4,
+        0x4C, 0x8B, 0xDC,
+        0xC5, 0xFA, 0x10, 0x05, 1, 2, 3, 4,
+        0x48, 0x89, 0x5C, 0x24, 0x08,
+        0x0F, 0x84, 1, 2, 3, 4,
+        0x65, 0x48, 0x8B, 0x04, 0x25, 0x58, 0, 0, 0,
+        0xE8, 1, 2, 3, 4,
+        0xC3,
+    };
+}
+
+
+void HookBenches(Bench::Suite& suite)
+{
+    suite.Run("prologue/decode", [&](uint64_t n) {
+        size_t offset = 0;
+
+        for (uint64_t i = 0; i < n; i++) {
+            auto instruction = Prologue::Decode(k_code.data() + offset, k_code.size() - offset);
+            offset += instruction->length;
+
+            if (offset >= k_code.size())
+                offset = 0;
+
+            Bench::DoNotOptimize(instruction);
+        }
+    });
+
+    suite.Run("prologue/relocate 5 bytes", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++)
+            Bench::DoNotOptimize(Prologue::Relocate(k_code.data(), 0x140001000, 5, 0x140100000));
+    });
+}
@@ -0,0 +1,57 @@
+#include "Bench.h"
+#include "Host.h"
+
+#include "SpeedQuery.h"
+
+#include <span>
+#include <string>
+#include <vector>
+
+//The batch query at 1, 10 and 100 actors, against asking one actor and one hand at a time, both through the plugin's own
+// evaluation with nobody attacking. The batch includes sizing the result, like GetEffectiveSpeedsFromActors. What the batch
+// really saves is a Papyrus call per actor and hand, which there's no VM here to show, so this is the native side only:
+// what the batch itself costs and how it grows.
+
+void QueryBenches(Bench::Suite& suite)
+{
+    Bench::Random random;
+
+    std::vector<Host::Actor> actors(100);
+
+    for (auto& actor : actors)
+        actor.base = { random.Uniform(0.5f, 2.5f), random.Uniform(0.5f, 2.5f) };
+
+    std::vector<Host::Actor*> targets;
+
+    for (auto& actor : actors)
+        targets.push_back(&actor);
+
+    Host::Game::Reset();
+    Host::Game::settings.capSpeed.currValue = 0.f;
+    Host::Game::settings.Refresh();
+
+    auto both = [&](Host::Actor* target) { return SpeedHooks::GetBothEffectiveSpeeds<Host::Game>(target); };
+    auto one = [&](Host::Actor* target, bool right) { return SpeedHooks::GetEffectiveSpeed<Host::Game>(target, right); };
+
+    for (size_t count : { 1, 10, 100 })
+    {
+        std::span<Host::Actor* const> batch{ targets.data(), count };
+
+        suite.Run("query/batch " + std::to_string(count) + " actors", [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++) {
+                std::vector<float> result(batch.size() * SpeedQuery::Stride(SpeedQuery::k_bothHands));
+                SpeedQuery::Fill(batch, SpeedQuery::k_bothHands, result.data(), both, one);
+                Bench::DoNotOptimize(result.data());
+            }
+        });
+
+        suite.Run("query/one at a time " + std::to_string(count) + " actors", [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++) {
+                for (auto target : batch) {
+                    Bench::DoNotOptimize(one(target, true));
+                    Bench::DoNotOptimize(one(target, false));
+                }
+            }
+        });
+    }
+}
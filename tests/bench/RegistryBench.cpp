@@ -0,0 +1,61 @@
+#include "Bench.h"
+
+#include "TagRegistry.h"
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+//TaggedActors as the hooks use it: every effect starting or finishing takes the lock and sets an actor's tags, with about
+// 200 of the 5000 loaded actors tagged at any time. Keys are handle sized, like the handles it's keyed by in the plugin.
+
+namespace
+{
+    constexpr size_t k_loaded = 5000;
+    constexpr size_t k_tagged = 200;
+    constexpr size_t k_ops = 1 << 16;
+}
+
+
+void RegistryBenches(Bench::Suite& suite)
+{
+    Bench::Random random;
+
+    std::vector<uint32_t> keys(k_ops);
+
+    for (auto& key : keys)
+        key = static_cast<uint32_t>(random.Uniform(0.f, k_loaded)) + 1;
+
+    std::mutex lock;
+    TagRegistry<uint32_t> registry;
+
+    //Tags come and go, the actor leaving once both are back to zero.
+    suite.Run("registry/churn", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            auto key = keys[i % k_ops];
+
+            std::lock_guard guard{ lock };
+
+            if (registry.contains(key))
+                registry.Set(key, 0, 0);
+            else if (registry.size() < k_tagged)
+                registry.Set(key, 1, 0);
+        }
+
+        Bench::DoNotOptimize(registry.size());
+    });
+
+    registry.clear();
+
+    for (size_t i = 0; i < k_tagged; i++)
+        registry.Set(static_cast<uint32_t>(i + 1), 1, -1);
+
+    //What the auditor's snapshot costs a pass.
+    suite.Run("registry/snapshot 200", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            std::lock_guard guard{ lock };
+            std::vector<uint32_t> snapshot{ registry.keys().begin(), registry.keys().end() };
+            Bench::DoNotOptimize(snapshot.data());
+        }
+    });
+}
@@ -0,0 +1,71 @@
+#include "Bench.h"
+
+#include "ActorSlots.h"
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//The per actor table the attack pins and the tier cache are read from on every speed query, against the mutex and
+// unordered_map the tier cache used to take. Only ever one thread here, so this is the cost of the lookup and an
+// uncontended lock, not of threads fighting over it. Every lookup is a hit, like a frame of actors asking again.
+
+namespace
+{
+    constexpr size_t k_lookups = 4096;
+
+    struct Entry
+    {
+        float stamp;
+        std::array<float, 2> speeds;
+    };
+}
+
+
+void SlotsBenches(Bench::Suite& suite)
+{
+    Bench::Random random;
+
+    for (size_t count : { 16, 500 })
+    {
+        ActorSlots<Entry, 1024> slots;
+
+        std::mutex lock;
+        std::unordered_map<uint32_t, Entry> map;
+
+        std::vector<uint32_t> ids;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            uint32_t id = 0xFF000800 + static_cast<uint32_t>(i) * 7;
+            Entry entry{ 0.f, { random.Uniform(0.5f, 1.5f), random.Uniform(0.5f, 1.5f) } };
+
+            slots.set(id, entry);
+            map[id] = entry;
+            ids.push_back(id);
+        }
+
+        std::vector<uint32_t> keys;
+
+        for (size_t i = 0; i < k_lookups; i++)
+            keys.push_back(ids[static_cast<size_t>(random.Uniform(0.f, 1.f) * count) % count]);
+
+        auto suffix = " " + std::to_string(count);
+
+        suite.Run("slots/find" + suffix, [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++)
+                Bench::DoNotOptimize(slots.find(keys[i % k_lookups]).value_or(Entry{}).speeds[0]);
+        });
+
+        suite.Run("slots/locked unordered_map find" + suffix, [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++)
+            {
+                std::lock_guard guard{ lock };
+                Bench::DoNotOptimize(map.find(keys[i % k_lookups])->second.speeds[0]);
+            }
+        });
+    }
+}
@@ -0,0 +1,127 @@
+#define CARP_SOURCE
+#include "StandIn.h"
+
+#include "SpeedQuery.h"
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+//A stand-in for the plugin's side of the native interface, built as a shared library so a consumer gets to it the same
+// way it would get to the DLL. Speeds come from the host actors through the plugin's own evaluation and batch layout,
+// listeners follow the same rules as SpeedChangeEvents.
+
+namespace
+{
+    using Listener = std::pair<AttackRatePatchAPI::SpeedChangeCallback, void*>;
+
+    struct StandInInterface : public AttackRatePatchAPI::CurrentInterface
+    {
+        AttackRatePatchAPI::Version GetVersion() override
+        {
+            return AttackRatePatchAPI::Version::Current;
+        }
+
+        float GetEffectiveSpeed(RE::Actor* target, bool right) override
+        {
+            settings.Refresh();
+            return target ? SpeedHooks::GetEffectiveSpeed<Host::Game>(target, right) : 0.f;
+        }
+
+        void GetEffectiveSpeeds(RE::Actor* const* targets, uint64_t count, int32_t hand_mask, float* out) override
+        {
+            if (!targets || !out)
+                return;
+
+            settings.Refresh();
+
+            SpeedQuery::Fill(std::span<RE::Actor* const>{ targets, count }, hand_mask & AttackRatePatchAPI::kBothHands, out,
+                [&](RE::Actor* target) { return SpeedHooks::GetBothEffectiveSpeeds<Host::Game>(target); },
+                [&](RE::Actor* target, bool right) { return SpeedHooks::GetEffectiveSpeed<Host::Game>(target, right); });
+        }
+
+        float GetSpeedTag(RE::Actor* target, bool right) override
+        {
+            return target ? target->tags[!right] : 0.f;
+        }
+
+        void GetSettings(AttackRatePatchAPI::SettingsSnapshot& out) override
+        {
+            out = AttackRatePatchAPI::SettingsSnapshot
+            {
+                .minSpeed = settings.minSpeed.GetValue(),
+                .capSpeed = settings.capSpeed.GetValue(),
+                .speedTaper = settings.speedTaper.GetValue(),
+                .maxSpeed = settings.maxSpeed.GetValue(),
+                .magnitudeComparison = settings.magnitudeComparison.GetValue(),
+            };
+        }
+
+        bool AddSpeedChangeListener(AttackRatePatchAPI::SpeedChangeCallback callback, void* user) override
+        {
+            if (!callback)
+                return false;
+
+            std::lock_guard guard{ lock };
+
+            if (std::ranges::find(listeners, Listener{ callback, user }) != listeners.end())
+                return false;
+
+            listeners.emplace_back(callback, user);
+            return true;
+        }
+
+        bool RemoveSpeedChangeListener(AttackRatePatchAPI::SpeedChangeCallback callback, void* user) override
+        {
+            std::lock_guard guard{ lock };
+
+            return std::erase(listeners, Listener{ callback, user });
+        }
+
+
+        bool HasListener(const Listener& listener)
+        {
+            std::lock_guard guard{ lock };
+
+            return std::ranges::find(listeners, listener) != listeners.end();
+        }
+
+        void Flush(const AttackRatePatchAPI::SpeedChange* changes, uint64_t count)
+        {
+            std::unique_lock guard{ lock };
+            auto notify = listeners;
+            guard.unlock();
+
+            for (auto& listener : notify)
+            {
+                if (HasListener(listener))
+                    listener.first(changes, count, listener.second);
+            }
+        }
+
+
+        //The same settings the plugin's evaluation reads here.
+        Host::Settings& settings = Host::Game::settings;
+
+        std::mutex lock;
+        std::vector<Listener> listeners;
+    };
+
+
+    StandInInterface& GetStandIn()
+    {
+        static StandInInterface singleton;
+        return singleton;
+    }
+}
+
+
+AttackRatePatchAPI::CurrentInterface* AttackRatePatchAPI::InterfaceSingleton()
+{
+    return &GetStandIn();
+}
+
+extern "C" __attribute__((visibility("default"))) void CARP_StandInFlush(const AttackRatePatchAPI::SpeedChange* changes, uint64_t count)
+{
+    GetStandIn().Flush(changes, count);
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "Win32Shim.h"
+
+#include "Host.h"
+
+//What the API calls an actor is a host actor here.
+namespace RE
+{
+    class Actor : public Host::Actor
+    {
+    };
+}
+
+#include "ComprehensiveAttackRatePatch/ComprehensiveAttackRatePatchAPI.h"
+
+//Only in the stand-in, so a test can play the end of a frame with a given set of changes.
+extern "C" void CARP_StandInFlush(const AttackRatePatchAPI::SpeedChange* changes, uint64_t count);
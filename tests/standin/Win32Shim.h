@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <cwchar>
+#include <type_traits>
+
+#include <dlfcn.h>
+
+//Just enough of Windows and CommonLibSSE for ComprehensiveAttackRatePatchAPI.h to compile on Linux, with the module
+// lookups going through dlopen/dlsym to the stand-in library instead of the DLL.
+
+#define __declspec(x) __attribute__((visibility("default")))
+#define __stdcall
+
+using HINSTANCE = void*;
+
+//Like the real one, only finds the module if something already loaded it.
+inline HINSTANCE GetModuleHandle(const wchar_t* name)
+{
+    if (std::wcscmp(name, L"ComprehensiveAttackRatePatch.dll") != 0)
+        return nullptr;
+
+    return dlopen(CARP_STANDIN_PATH, RTLD_NOW | RTLD_NOLOAD);
+}
+
+inline void* GetProcAddress(HINSTANCE module, const char* name)
+{
+    return module ? dlsym(module, name) : nullptr;
+}
+
+namespace logger
+{
+    template <class... Args>
+    void info(Args&&...) {}
+
+    template <class... Args>
+    void warn(Args&&...) {}
+
+    template <class... Args>
+    void critical(Args&&...) {}
+}
@@ -0,0 +1,88 @@
+#!/usr/bin/env python3
+"""Compares two hook profiles written by a CARP_PROFILE build (ComprehensiveAttackRatePatch_profile.json in the SKSE log
+folder) and flags any hook that got slower per call by more than the threshold. The per frame p50/p99 is held to the
+same threshold.
+
+    compare_profile.py baseline.json current.json [--threshold 0.10] [--min-calls 1000]
+
+Exits with 1 if anything regressed, so it can sit in a script. Counters with too few calls on either side are shown but
+never flagged, a handful of calls is mostly noise.
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path, encoding="utf-8") as file:
+        return json.load(file)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Diff two CARP hook profiles.")
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=0.10, help="Slowdown per call that counts, 0.10 is 10%%.")
+    parser.add_argument("--min-calls", type=int, default=1000, help="Calls needed on both sides to flag a counter.")
+    args = parser.parse_args()
+
+    baseline = load(args.baseline)
+    current = load(args.current)
+
+    old = baseline["counters"]
+    new = current["counters"]
+
+    print(f"baseline {baseline.get('version', '?')}, current {current.get('version', '?')}")
+    print(f"{'hook':<48} {'old ns':>10} {'new ns':>10} {'change':>9}")
+
+    regressions = []
+
+    old_frames = baseline.get("frames", {})
+    new_frames = current.get("frames", {})
+
+    if old_frames.get("count") and new_frames.get("count"):
+        for key in ("p50Ns", "p99Ns"):
+            before = old_frames[key]
+            after = new_frames[key]
+            change = (after - before) / before if before else 0.0
+            flagged = change > args.threshold
+
+            print(f"{'frame ' + key[:3]:<48} {before:>10.1f} {after:>10.1f} {change:>+8.1%}{' <-' if flagged else ''}")
+
+            if flagged:
+                regressions.append("frame " + key[:3])
+
+        print()
+
+    for name in sorted(set(old) | set(new)):
+        if name not in old:
+            print(f"{name:<48} {'-':>10} {new[name]['nsPerCall']:>10.1f} {'new':>9}")
+            continue
+
+        if name not in new:
+            print(f"{name:<48} {old[name]['nsPerCall']:>10.1f} {'-':>10} {'gone':>9}")
+            continue
+
+        before = old[name]["nsPerCall"]
+        after = new[name]["nsPerCall"]
+        change = (after - before) / before if before else 0.0
+
+        enough = min(old[name]["calls"], new[name]["calls"]) >= args.min_calls
+        flagged = enough and change > args.threshold
+
+        mark = " <-" if flagged else ("" if enough else " (few calls)")
+        print(f"{name:<48} {before:>10.1f} {after:>10.1f} {change:>+8.1%}{mark}")
+
+        if flagged:
+            regressions.append(name)
+
+    if regressions:
+        print(f"\n{len(regressions)} hook(s) slower by more than {args.threshold:.0%}: {', '.join(regressions)}")
+        return 1
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
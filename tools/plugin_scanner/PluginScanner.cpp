@@ -0,0 +1,534 @@
+//Goes through a load order's plugin files ahead of time and writes out what CARP's effect hooks want to know about every
+// magic effect, spell and enchantment (see src/EffectIndex.h). The plugin still works it all out from the forms on data
+// loaded, and checks what it got against this, so anything that changed a record before then shows up in the log. Plugins
+// are mapped and scanned side by side on every core, only the MGEF, SPEL and ENCH groups are read, everything else is
+// skipped over by its group size.
+//
+//  plugin_scanner <Data folder> <plugins.txt> [-o EffectIndex.bin]
+//
+// The list is one plugin per line in load order. A leading * is dropped, and if any line has one the lines without it
+// are taken as disabled, so the game's plugins.txt works as is. The base game masters and Skyrim.ccc's plugins go in
+// front the same way the game puts them there. The output goes in Data/SKSE/Plugins/ComprehensiveAttackRatePatch/, and
+// it needs making again whenever the load order or any plugin in it changes, the plugin skips the check otherwise.
+//
+// bench_scan.py next to this times it over a made up load order.
+
+#include "EffectIndex.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <zlib.h>
+
+
+namespace
+{
+    class MappedFile
+    {
+    public:
+        explicit MappedFile(const std::filesystem::path& path)
+        {
+            int fd = open(path.c_str(), O_RDONLY);
+
+            if (fd < 0)
+                throw std::runtime_error("Can't open " + path.string() + ": " + std::strerror(errno));
+
+            struct stat info;
+
+            if (fstat(fd, &info) != 0) {
+                close(fd);
+                throw std::runtime_error("Can't read " + path.string());
+            }
+
+            _size = static_cast<size_t>(info.st_size);
+
+            if (_size)
+                _data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+            close(fd);
+
+            if (_data == MAP_FAILED)
+                throw std::runtime_error("Can't map " + path.string() + ": " + std::strerror(errno));
+        }
+
+        ~MappedFile()
+        {
+            if (_data && _data != MAP_FAILED)
+                munmap(_data, _size);
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        const uint8_t* data() const { return static_cast<const uint8_t*>(_data); }
+        size_t size() const { return _size; }
+
+    private:
+        void* _data = nullptr;
+        size_t _size = 0;
+    };
+
+
+    template <class T>
+    T Read(const uint8_t* data)
+    {
+        T value;
+        std::memcpy(&value, data, sizeof(T));
+        return value;
+    }
+
+    bool IsType(const uint8_t* data, std::string_view type)
+    {
+        return std::memcmp(data, type.data(), 4) == 0;
+    }
+
+    std::string Lower(std::string_view text)
+    {
+        std::string result{ text };
+
+        for (auto& c : result)
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+
+        return result;
+    }
+
+
+    constexpr size_t k_headerSize = 24;
+
+    constexpr uint32_t k_recordMaster = 0x1;
+    constexpr uint32_t k_recordDeleted = 0x20;
+    constexpr uint32_t k_recordLight = 0x200;
+    constexpr uint32_t k_recordCompressed = 0x40000;
+
+
+    //A record as it is in its own file, the form id still local to that file's masters.
+    struct Found
+    {
+        uint32_t formID;
+        EffectIndex::Entry entry;
+    };
+
+    struct Plugin
+    {
+        std::string name;
+        uint64_t size = 0;
+        int64_t writeTime = 0;
+
+        bool master = false;
+        bool light = false;
+        std::vector<std::string> masters;
+
+        std::vector<Found> found;
+        size_t records = 0;
+        size_t compressed = 0;
+
+        std::string error;
+    };
+
+
+    //Calls back with each subrecord's type and data. XXXX gives the size of the one after it.
+    template <class F>
+    void ForEachField(const uint8_t* data, size_t size, F&& callback)
+    {
+        size_t position = 0;
+        uint32_t next_size = 0;
+
+        while (position + 6 <= size)
+        {
+            const uint8_t* type = data + position;
+            uint32_t length = Read<uint16_t>(data + position + 4);
+            position += 6;
+
+            if (next_size) {
+                length = next_size;
+                next_size = 0;
+            }
+
+            if (position + length > size)
+                throw std::runtime_error("Subrecord runs past the end of its record");
+
+            if (IsType(type, "XXXX") && length == 4)
+                next_size = Read<uint32_t>(data + position);
+            else
+                callback(type, data + position, length);
+
+            position += length;
+        }
+    }
+
+
+    void ReadRecord(Plugin& plugin, const uint8_t* record, std::string_view group, std::vector<uint8_t>& inflated)
+    {
+        uint32_t size = Read<uint32_t>(record + 4);
+        uint32_t flags = Read<uint32_t>(record + 8);
+        uint32_t form_id = Read<uint32_t>(record + 12);
+
+        plugin.records++;
+
+        if (flags & k_recordDeleted)
+            return;
+
+        const uint8_t* data = record + k_headerSize;
+
+        if (flags & k_recordCompressed)
+        {
+            if (size < 4)
+                throw std::runtime_error("Compressed record too small");
+
+            uLongf length = Read<uint32_t>(data);
+            inflated.resize(length);
+
+            if (uncompress(inflated.data(), &length, data + 4, size - 4) != Z_OK)
+                throw std::runtime_error("Couldn't inflate a compressed record");
+
+            data = inflated.data();
+            size = static_cast<uint32_t>(length);
+            plugin.compressed++;
+        }
+
+        EffectIndex::Entry entry{ .formID = 0, .flags = 0, .kind = EffectIndex::kItem, .pad = {}, .primaryAV = -1, .secondaryAV = -1 };
+        bool has_data = false;
+
+        ForEachField(data, size, [&](const uint8_t* type, const uint8_t* field, size_t length) {
+            if (group == "MGEF" && IsType(type, "DATA") && length >= 92)
+            {
+                entry.kind = EffectIndex::kEffect;
+                entry.flags = EffectIndex::ClassifyEffect(Read<uint32_t>(field));
+                entry.primaryAV = Read<int32_t>(field + 68);
+                entry.secondaryAV = Read<int32_t>(field + 88);
+                has_data = true;
+            }
+            else if (group == "SPEL" && IsType(type, "SPIT") && length >= 20)
+            {
+                entry.flags = EffectIndex::ClassifyItem(Read<uint32_t>(field + 8), Read<uint32_t>(field + 16));
+                has_data = true;
+            }
+            else if (group == "ENCH" && IsType(type, "ENIT") && length >= 24)
+            {
+                //The enchantment type is its spell type, enchantment or staff enchantment.
+                entry.flags = EffectIndex::ClassifyItem(Read<uint32_t>(field + 20), Read<uint32_t>(field + 8));
+                has_data = true;
+            }
+        });
+
+        if (has_data)
+            plugin.found.push_back({ form_id, entry });
+    }
+
+
+    void Scan(Plugin& plugin, const std::filesystem::path& path)
+    {
+        MappedFile file{ path };
+
+        const uint8_t* data = file.data();
+        const size_t size = file.size();
+
+        plugin.size = size;
+
+        std::error_code error;
+        plugin.writeTime = EffectIndex::WriteTime(path, error);
+
+        if (size < k_headerSize || !IsType(data, "TES4"))
+            throw std::runtime_error("Not a plugin");
+
+        uint32_t header_size = Read<uint32_t>(data + 4);
+        uint32_t header_flags = Read<uint32_t>(data + 8);
+
+        if (k_headerSize + header_size > size)
+            throw std::runtime_error("Header runs past the end of the file");
+
+        auto extension = Lower(path.extension().string());
+
+        plugin.master = header_flags & k_recordMaster || extension == ".esm" || extension == ".esl";
+        plugin.light = header_flags & k_recordLight || extension == ".esl";
+
+        ForEachField(data + k_headerSize, header_size, [&](const uint8_t* type, const uint8_t* field, size_t length) {
+            if (IsType(type, "MAST"))
+                plugin.masters.emplace_back(reinterpret_cast<const char*>(field), strnlen(reinterpret_cast<const char*>(field), length));
+        });
+
+        std::vector<uint8_t> inflated;
+
+        size_t position = k_headerSize + header_size;
+
+        while (position + k_headerSize <= size)
+        {
+            const uint8_t* group = data + position;
+
+            if (!IsType(group, "GRUP"))
+                throw std::runtime_error("Expected a group at the top level");
+
+            uint32_t group_size = Read<uint32_t>(group + 4);
+
+            if (group_size < k_headerSize || position + group_size > size)
+                throw std::runtime_error("Group runs past the end of the file");
+
+            std::string_view label{ reinterpret_cast<const char*>(group + 8), 4 };
+
+            if (label == "MGEF" || label == "SPEL" || label == "ENCH")
+            {
+                size_t inner = position + k_headerSize;
+                size_t end = position + group_size;
+
+                while (inner + k_headerSize <= end)
+                {
+                    const uint8_t* record = data + inner;
+                    uint32_t record_size = Read<uint32_t>(record + 4);
+
+                    //Nothing nests in these, but a group's size counts its own header where a record's doesn't.
+                    size_t advance = IsType(record, "GRUP") ? record_size : k_headerSize + record_size;
+
+                    if (advance < k_headerSize || inner + advance > end)
+                        throw std::runtime_error("Record runs past the end of its group");
+
+                    if (!IsType(record, "GRUP"))
+                        ReadRecord(plugin, record, label, inflated);
+
+                    inner += advance;
+                }
+            }
+
+            position += group_size;
+        }
+    }
+
+
+    std::vector<std::string> ReadLoadOrder(const std::filesystem::path& data_dir, const std::filesystem::path& list)
+    {
+        std::ifstream stream{ list };
+
+        if (!stream)
+            throw std::runtime_error("Can't open " + list.string());
+
+        std::vector<std::pair<std::string, bool>> lines;
+        bool any_star = false;
+
+        for (std::string line; std::getline(stream, line);)
+        {
+            while (!line.empty() && (line.back() == '\r' || line.back() == ' '))
+                line.pop_back();
+
+            if (line.empty() || line[0] == '#')
+                continue;
+
+            bool star = line[0] == '*';
+            any_star |= star;
+
+            lines.emplace_back(star ? line.substr(1) : line, star);
+        }
+
+        //What the game loads before anything in the list.
+        std::vector<std::string> result{ "Skyrim.esm", "Update.esm", "Dawnguard.esm", "HearthFires.esm", "Dragonborn.esm" };
+
+        if (std::ifstream ccc{ data_dir.parent_path() / "Skyrim.ccc" }) {
+            for (std::string line; std::getline(ccc, line);) {
+                while (!line.empty() && (line.back() == '\r' || line.back() == ' '))
+                    line.pop_back();
+
+                if (!line.empty())
+                    result.push_back(line);
+            }
+        }
+
+        std::erase_if(result, [&](auto& name) { return !std::filesystem::exists(data_dir / name); });
+
+        for (auto& [name, star] : lines)
+        {
+            if (any_star && !star)
+                continue;
+
+            if (std::ranges::find(result, Lower(name), Lower) == result.end())
+                result.push_back(name);
+        }
+
+        return result;
+    }
+}
+
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        std::filesystem::path output = "EffectIndex.bin";
+        std::vector<std::string> positional;
+
+        for (int i = 1; i < argc; i++)
+        {
+            std::string_view arg = argv[i];
+
+            if (arg == "-o" && i + 1 < argc)
+                output = argv[++i];
+            else
+                positional.emplace_back(arg);
+        }
+
+        if (positional.size() != 2)
+            throw std::runtime_error("usage: plugin_scanner <Data folder> <plugins.txt> [-o EffectIndex.bin]");
+
+        std::filesystem::path data_dir = positional[0];
+
+        auto start = std::chrono::steady_clock::now();
+
+        auto names = ReadLoadOrder(data_dir, positional[1]);
+
+        std::vector<Plugin> plugins(names.size());
+
+        for (size_t i = 0; i < names.size(); i++)
+            plugins[i].name = names[i];
+
+        //Each worker takes the next plugin until there aren't any.
+        std::atomic<size_t> next = 0;
+        std::vector<std::thread> workers(std::max(1u, std::thread::hardware_concurrency()));
+
+        for (auto& worker : workers)
+        {
+            worker = std::thread{ [&] {
+                for (size_t i; (i = next.fetch_add(1)) < plugins.size();)
+                {
+                    try
+                    {
+                        Scan(plugins[i], data_dir / plugins[i].name);
+                    }
+                    catch (std::exception& error)
+                    {
+                        plugins[i].error = error.what();
+                    }
+                }
+            } };
+        }
+
+        for (auto& worker : workers)
+            worker.join();
+
+        for (auto& plugin : plugins)
+        {
+            if (!plugin.error.empty())
+                throw std::runtime_error(plugin.name + ": " + plugin.error);
+        }
+
+        //Masters load before everything else whatever the list says, the rest keeps its order.
+        std::ranges::stable_partition(plugins, &Plugin::master);
+
+        //Where each plugin's forms end up at runtime, full plugins and light ones counted separately.
+        struct Slot
+        {
+            bool light;
+            uint32_t index;
+        };
+
+        std::unordered_map<std::string, Slot> slots;
+        uint32_t full_count = 0;
+        uint32_t light_count = 0;
+
+        for (auto& plugin : plugins)
+        {
+            if (plugin.light)
+                slots[Lower(plugin.name)] = { true, light_count++ };
+            else
+                slots[Lower(plugin.name)] = { false, full_count++ };
+        }
+
+        if (full_count > 0xFE || light_count > 0x1000)
+            throw std::runtime_error("Too many plugins for one load order");
+
+        //The hash goes full plugins then light ones, which is one run over both.
+        EffectIndex::LoadOrderHash hash;
+
+        for (auto light : { false, true }) {
+            for (auto& plugin : plugins) {
+                if (plugin.light == light)
+                    hash.Add(plugin.name, plugin.size, plugin.writeTime);
+            }
+        }
+
+        //Later plugins overwrite earlier ones, same as the game.
+        std::unordered_map<uint32_t, EffectIndex::Entry> merged;
+
+        size_t records = 0;
+        size_t compressed = 0;
+        uint64_t bytes = 0;
+
+        for (auto& plugin : plugins)
+        {
+            records += plugin.records;
+            compressed += plugin.compressed;
+            bytes += plugin.size;
+
+            for (auto& [local, entry] : plugin.found)
+            {
+                uint32_t owner_index = local >> 24;
+
+                std::string owner = owner_index < plugin.masters.size() ? plugin.masters[owner_index] : plugin.name;
+
+                auto slot = slots.find(Lower(owner));
+
+                if (slot == slots.end())
+                    continue;
+
+                uint32_t form_id = slot->second.light ?
+                    0xFE000000 | slot->second.index << 12 | (local & 0xFFF) :
+                    slot->second.index << 24 | (local & 0xFFFFFF);
+
+                merged[form_id] = entry;
+                merged[form_id].formID = form_id;
+            }
+        }
+
+        std::vector<EffectIndex::Entry> entries;
+        entries.reserve(merged.size());
+
+        for (auto& [form_id, entry] : merged)
+            entries.push_back(entry);
+
+        std::ranges::sort(entries, {}, &EffectIndex::Entry::formID);
+
+        EffectIndex::FileHeader header{
+            .magic = EffectIndex::k_magic,
+            .version = EffectIndex::k_version,
+            .count = static_cast<uint32_t>(entries.size()),
+            .loadOrder = hash.value(),
+        };
+
+        std::ofstream file{ output, std::ios::binary };
+
+        if (!file)
+            throw std::runtime_error("Can't write " + output.string());
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(EffectIndex::Entry));
+
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        size_t effects = std::ranges::count(entries, EffectIndex::kEffect, &EffectIndex::Entry::kind);
+
+        std::printf("%zu plugins (%u full, %u light), %.1f MB, %zu records read (%zu compressed)\n",
+            plugins.size(), full_count, light_count, bytes / 1e6, records, compressed);
+        std::printf("%zu effects and %zu spells/enchantments written to %s\n", effects, entries.size() - effects, output.string().c_str());
+        std::printf("%.3fs, %.0f MB/s on %zu threads\n", elapsed, bytes / 1e6 / elapsed, workers.size());
+
+        return 0;
+    }
+    catch (std::exception& error)
+    {
+        std::fprintf(stderr, "%s\n", error.what());
+        return 1;
+    }
+}
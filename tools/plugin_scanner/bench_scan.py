@@ -0,0 +1,179 @@
+#!/usr/bin/env python3
+"""Times plugin_scanner over a made up load order, so a change to the scanner can be held up against what it did before
+without a game install. The plugins are the same every time for the same arguments: a Skyrim.esm with a few thousand
+effects, then a run of mods that each add effects, spells and enchantments, override one of Skyrim.esm's effects, and
+carry a lot of NPC and weapon records the scanner has to skip over. Every seventh effect is compressed.
+
+    bench_scan.py build/plugin_scanner [--plugins 20] [--filler 2000] [--runs 5] [--dir scan_data] [--out scan.json]
+
+The first run only warms the page cache and isn't counted, so what's timed is the scan and not the disk. --out writes
+the best run in the json compare_profile.py reads, which makes two of them a before and after.
+"""
+
+import argparse
+import json
+import os
+import random
+import shutil
+import statistics
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+import zlib
+
+
+def field(kind, data):
+    return kind.encode() + struct.pack("<H", len(data)) + data
+
+
+def record(kind, form_id, body, flags=0, compress=False):
+    if compress:
+        body = struct.pack("<I", len(body)) + zlib.compress(body)
+        flags |= 0x40000
+
+    return kind.encode() + struct.pack("<IIIIHH", len(body), flags, form_id, 0, 44, 0) + body
+
+
+def group(label, content):
+    return b"GRUP" + struct.pack("<I", 24 + len(content)) + label.encode() + struct.pack("<iHHHH", 0, 0, 0, 0, 0) + content
+
+
+#Only the parts of each record the scanner reads are filled in, see PluginScanner.cpp.
+def effect(flags, primary_av, secondary_av):
+    data = bytearray(152)
+    struct.pack_into("<I", data, 0, flags)
+    struct.pack_into("<i", data, 68, primary_av)
+    struct.pack_into("<i", data, 88, secondary_av)
+    return field("EDID", b"Eff\0") + field("DATA", bytes(data))
+
+
+def spell(spell_type, casting_type):
+    data = bytearray(36)
+    struct.pack_into("<I", data, 8, spell_type)
+    struct.pack_into("<I", data, 16, casting_type)
+    return field("EDID", b"Sp\0") + field("SPIT", bytes(data))
+
+
+def enchantment(casting_type, enchant_type):
+    data = bytearray(36)
+    struct.pack_into("<I", data, 8, casting_type)
+    struct.pack_into("<I", data, 20, enchant_type)
+    return field("EDID", b"En\0") + field("ENIT", bytes(data))
+
+
+def plugin(path, rng, masters, flags, effects, filler, overrides=()):
+    header = field("HEDR", struct.pack("<fII", 1.7, 0, 0))
+
+    for master in masters:
+        header += field("MAST", master.encode() + b"\0") + field("DATA", b"\0" * 8)
+
+    owner = len(masters) << 24
+
+    #Weapon speed and a few others, so some effects come out speed relevant and some don't.
+    avs = [-1, 22, 23, 24, 25, 106]
+
+    mgef = b"".join(
+        record("MGEF", owner | 0x800 + i, effect(rng.getrandbits(32), rng.choice(avs), rng.choice([-1, 25])), compress=i % 7 == 0)
+        for i in range(effects))
+    mgef += b"".join(record("MGEF", form_id, effect(*data)) for form_id, *data in overrides)
+
+    spel = b"".join(record("SPEL", owner | 0x100000 + i, spell(rng.randrange(12), rng.randrange(3))) for i in range(effects))
+    ench = b"".join(record("ENCH", owner | 0x200000 + i, enchantment(rng.randrange(3), rng.choice([6, 12]))) for i in range(effects // 2))
+
+    big = field("EDID", b"x\0") + field("DATA", rng.randbytes(2000))
+    npcs = b"".join(record("NPC_", owner | 0x300000 + i, big) for i in range(filler))
+    weapons = b"".join(record("WEAP", owner | 0x400000 + i, big) for i in range(filler // 2))
+
+    with open(path, "wb") as file:
+        file.write(record("TES4", 0, header, flags))
+        file.write(group("WEAP", weapons) + group("MGEF", mgef) + group("SPEL", spel) + group("ENCH", ench) + group("NPC_", npcs))
+
+
+#Writes <root>/Data and <root>/plugins.txt, and gives back how many bytes of plugins are in the load order.
+def make_load_order(root, count, filler, seed=1):
+    rng = random.Random(seed)
+    data = os.path.join(root, "Data")
+    os.makedirs(data, exist_ok=True)
+
+    plugin(os.path.join(data, "Skyrim.esm"), rng, [], 1, 3000, filler * 10)
+
+    names = []
+
+    for i in range(count):
+        light = i % 3 == 0
+        name = f"Mod{i:03}." + ("esl" if light and i % 2 else "esp")
+
+        #Every mod overrides the same Skyrim.esm effect, the last one wins.
+        last = i == count - 1
+        plugin(os.path.join(data, name), rng, ["Skyrim.esm"], 0x200 if light else 0, 200, filler,
+               overrides=[(0x800, 1 if last else 0, 25 if last else 24, -1)])
+
+        names.append(name)
+
+    with open(os.path.join(root, "plugins.txt"), "w", encoding="utf-8") as file:
+        file.write("# bench_scan.py\n" + "".join(f"*{name}\n" for name in names))
+
+    return sum(os.path.getsize(os.path.join(data, name)) for name in ["Skyrim.esm"] + names)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Time plugin_scanner over a generated load order.")
+    parser.add_argument("scanner", help="The plugin_scanner binary.")
+    parser.add_argument("--plugins", type=int, default=20, help="Mods after Skyrim.esm.")
+    parser.add_argument("--filler", type=int, default=2000, help="Skipped records per mod, about 2KB each.")
+    parser.add_argument("--runs", type=int, default=5, help="Timed runs, after one to warm up.")
+    parser.add_argument("--dir", help="Where to put the load order, and keep it. A temporary folder otherwise.")
+    parser.add_argument("--out", help="Write the best run as a profile json.")
+    args = parser.parse_args()
+
+    root = args.dir or tempfile.mkdtemp(prefix="carp_scan_")
+
+    try:
+        size = make_load_order(root, args.plugins, args.filler)
+        index = os.path.join(root, "EffectIndex.bin")
+        command = [args.scanner, os.path.join(root, "Data"), os.path.join(root, "plugins.txt"), "-o", index]
+
+        print(f"{args.plugins + 1} plugins, {size / 1e6:.1f} MB")
+
+        times = []
+
+        for run in range(args.runs + 1):
+            start = time.perf_counter()
+            result = subprocess.run(command, capture_output=True, text=True)
+            elapsed = time.perf_counter() - start
+
+            if result.returncode != 0:
+                sys.stderr.write(result.stdout + result.stderr)
+                return 1
+
+            if run:
+                times.append(elapsed)
+
+        best = min(times)
+        median = statistics.median(times)
+
+        print(result.stdout, end="")
+        print(f"best {best * 1e3:.1f}ms ({size / 1e6 / best:.0f} MB/s), median {median * 1e3:.1f}ms ({size / 1e6 / median:.0f} MB/s) over {len(times)} runs")
+
+        if args.out:
+            name = f"scan/{args.plugins + 1} plugins"
+            profile = {
+                "version": "bench_scan",
+                "ticksPerNano": 1.0,
+                "frames": {"count": 0, "p50Ns": 0, "p99Ns": 0, "maxNs": 0},
+                "counters": {name: {"calls": 1, "ticks": int(best * 1e9), "nsPerCall": best * 1e9, "totalMs": best * 1e3}},
+            }
+
+            with open(args.out, "w", encoding="utf-8") as file:
+                json.dump(profile, file, indent=4)
+
+        return 0
+    finally:
+        if not args.dir:
+            shutil.rmtree(root, ignore_errors=True)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
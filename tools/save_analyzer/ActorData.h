@@ -0,0 +1,406 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <vector>
+
+//Decodes the parts of an actor change form (ACHR) that go into its weapon speed: the two speed values' base and modifiers,
+// and the active effects. The sections come one after the other in the order of the change flags that turn them on, with
+// nothing saying how long most of them are, so each section before the ones wanted has to be walked to get past it.
+//
+// There's no published layout for this. What's here is pieced together from the change flag names (UESP's list, the same
+// as Actor::ChangeFlags) and the fields the game keeps on ActiveEffect and ActorValueStorage, and it hasn't been checked
+// against real saves yet. So nothing is trusted unless it decodes to exactly the form's length. A section that can't be
+// walked (extra data, a non empty inventory entry list, leveled and disposition data) or a form that comes out short or long
+// is reported as not decoded, with where it stopped, rather than guessed at.
+
+namespace ActorData
+{
+    enum Flag : uint32_t
+    {
+        kMove = 1 << 0,
+        kHavokMove = 1 << 1,
+        kCellChanged = 1 << 2,
+        kScale = 1 << 3,
+        kInventory = 1 << 4,
+        kExtraOwnership = 1 << 5,
+        kBaseObject = 1 << 6,
+        kLifeState = 1 << 10,
+        kExtraPackageData = 1 << 11,
+        kExtraMerchantContainer = 1 << 12,
+        kExtraDismemberedLimbs = 1 << 17,
+        kLeveledActor = 1 << 18,
+        kDispositionModifiers = 1 << 19,
+        kTempModifiers = 1 << 20,
+        kDamageModifiers = 1 << 21,
+        kOverrideModifiers = 1 << 22,
+        kPermanentModifiers = 1 << 23,
+        kPromoted = 1 << 25,
+        kExtraEncounterZone = 1 << 28,
+        kExtraCreatedOnly = 1 << 29,
+        kExtraGameOnly = 1 << 30,
+        kAnimation = 1u << 31,
+    };
+
+    constexpr uint32_t k_extraFlags = kExtraOwnership | kExtraPackageData | kExtraMerchantContainer | kExtraDismemberedLimbs |
+        kExtraEncounterZone | kExtraCreatedOnly | kExtraGameOnly;
+
+    //The modifier maps in the order they're written, with what they're called in the output.
+    constexpr std::array<std::pair<Flag, const char*>, 4> k_modifiers
+    {{
+        { kTempModifiers, "temporary" },
+        { kDamageModifiers, "damage" },
+        { kOverrideModifiers, "override" },
+        { kPermanentModifiers, "permanent" },
+    }};
+
+    //Actor value indices, the same as RE::ActorValue.
+    constexpr uint8_t k_weaponSpeedMult = 85;
+    constexpr uint8_t k_leftWeaponSpeedMultiply = 158;
+
+    //ActiveEffect::Flag.
+    enum EffectFlag : uint32_t
+    {
+        kHasConditions = 1 << 7,
+        kRecovers = 1 << 9,
+        kApplied = 1 << 16,
+        kDispelled = 1 << 18,
+    };
+
+    //ActiveEffect::ConditionStatus.
+    constexpr uint8_t k_conditionsTrue = 1;
+
+
+    //One of the speed values, right or left. Each is only there if the save has it, the base otherwise comes from the
+    // actor's record.
+    struct SpeedValue
+    {
+        std::optional<float> base;
+        std::array<std::optional<float>, k_modifiers.size()> modifiers;
+    };
+
+    struct Effect
+    {
+        uint32_t spell;
+        uint32_t baseEffect;
+        float elapsed;
+        float duration;
+        float magnitude;
+        uint32_t flags;
+        uint8_t conditionStatus;
+
+        //The value modifier part, when the effect has one.
+        std::optional<uint8_t> actorValue;
+        float value = 0.f;
+    };
+
+    struct Decoded
+    {
+        //Right then left.
+        std::array<SpeedValue, 2> speed;
+        std::vector<Effect> effects;
+    };
+
+    struct Failure
+    {
+        std::string section;
+        size_t offset;
+    };
+
+
+    class Reader
+    {
+    public:
+        Reader(const uint8_t* data, size_t size) : _data{ data }, _size{ size } {}
+
+        template <class T>
+        bool Get(T& value)
+        {
+            if (_size - _position < sizeof(T))
+                return false;
+
+            std::memcpy(&value, _data + _position, sizeof(T));
+            _position += sizeof(T);
+            return true;
+        }
+
+        bool Skip(size_t count)
+        {
+            if (_size - _position < count)
+                return false;
+
+            _position += count;
+            return true;
+        }
+
+        //The three byte reference, same as the change form's own.
+        bool RefID(uint32_t& value)
+        {
+            std::array<uint8_t, 3> bytes;
+
+            if (!Get(bytes))
+                return false;
+
+            value = bytes[0] << 16 | bytes[1] << 8 | bytes[2];
+            return true;
+        }
+
+        //The low two bits of the first byte say how wide it is, the rest is the value.
+        bool VSVal(uint32_t& value)
+        {
+            uint8_t first;
+
+            if (!Get(first))
+                return false;
+
+            switch (first & 3)
+            {
+            case 0:
+                value = first >> 2;
+                return true;
+            case 1: {
+                uint8_t next;
+
+                if (!Get(next))
+                    return false;
+
+                value = (first | next << 8) >> 2;
+                return true;
+            }
+            case 2: {
+                std::array<uint8_t, 3> next;
+
+                if (!Get(next))
+                    return false;
+
+                value = (first | next[0] << 8 | next[1] << 16 | static_cast<uint32_t>(next[2]) << 24) >> 2;
+                return true;
+            }
+            default:
+                return false;
+            }
+        }
+
+        size_t position() const { return _position; }
+        size_t remaining() const { return _size - _position; }
+
+    private:
+        const uint8_t* _data;
+        size_t _size;
+        size_t _position = 0;
+    };
+
+
+    //How much comes first, by what the reference is and how it moved. Created references (0xFF ids) carry their base object,
+    // ones that changed cell where they came from.
+    inline size_t InitialSize(uint32_t ref, uint32_t flags)
+    {
+        constexpr size_t k_moved = 3 + 6 * sizeof(float);
+
+        if (ref >> 22 == 2)
+            return k_moved + 1 + 3;
+
+        if (flags & (kPromoted | kCellChanged))
+            return k_moved + 3 + 2 * sizeof(int16_t);
+
+        if (flags & (kMove | kHavokMove))
+            return k_moved;
+
+        return 0;
+    }
+
+    //A map of actor value to float, only the speed values are kept.
+    inline bool ReadValues(Reader& reader, const auto& keep)
+    {
+        uint32_t count;
+
+        if (!reader.VSVal(count) || count > reader.remaining() / 5)
+            return false;
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            uint8_t av;
+            float value;
+
+            if (!reader.Get(av) || !reader.Get(value) || !std::isfinite(value))
+                return false;
+
+            keep(av, value);
+        }
+
+        return true;
+    }
+
+    inline bool ReadEffect(Reader& reader, Effect& effect)
+    {
+        if (!reader.RefID(effect.spell) || !reader.RefID(effect.baseEffect))
+            return false;
+
+        if (!reader.Get(effect.elapsed) || !reader.Get(effect.duration) || !reader.Get(effect.magnitude))
+            return false;
+
+        if (!reader.Get(effect.flags) || !reader.Get(effect.conditionStatus))
+            return false;
+
+        //What the effect's own type adds, sized so the types that aren't value modifiers can be stepped over.
+        uint32_t length;
+
+        if (!reader.VSVal(length) || length > reader.remaining())
+            return false;
+
+        if (length == 1 + sizeof(float)) {
+            uint8_t av = 0;
+
+            reader.Get(av);
+            reader.Get(effect.value);
+
+            effect.actorValue = av;
+            return std::isfinite(effect.value);
+        }
+
+        return reader.Skip(length);
+    }
+
+
+    //ref and flags are the change form's, data its (inflated) data.
+    inline bool Decode(const uint8_t* data, size_t size, uint32_t ref, uint32_t flags, Decoded& out, Failure& failure)
+    {
+        Reader reader{ data, size };
+
+        auto fail = [&](const char* section) {
+            failure = { section, reader.position() };
+            return false;
+        };
+
+        if (!reader.Skip(InitialSize(ref, flags)))
+            return fail("initial data");
+
+        if (flags & kHavokMove) {
+            uint32_t length;
+
+            if (!reader.VSVal(length) || !reader.Skip(length))
+                return fail("havok");
+        }
+
+        if (flags & kBaseObject) {
+            uint32_t base;
+
+            if (!reader.RefID(base))
+                return fail("base object");
+        }
+
+        if (flags & kScale) {
+            float scale;
+
+            if (!reader.Get(scale))
+                return fail("scale");
+        }
+
+        if (flags & k_extraFlags) {
+            uint32_t count;
+
+            if (!reader.VSVal(count) || count)
+                return fail("extra data");
+        }
+
+        if (flags & kInventory) {
+            uint32_t count;
+
+            if (!reader.VSVal(count))
+                return fail("inventory");
+
+            for (uint32_t i = 0; i < count; i++)
+            {
+                uint32_t item;
+                int32_t amount;
+                uint32_t extra_lists;
+
+                if (!reader.RefID(item) || !reader.Get(amount) || !reader.VSVal(extra_lists) || extra_lists)
+                    return fail("inventory");
+            }
+        }
+
+        if (flags & kAnimation) {
+            uint32_t length;
+
+            if (!reader.VSVal(length) || !reader.Skip(length))
+                return fail("animation");
+        }
+
+        if (flags & kLifeState) {
+            uint8_t state;
+
+            if (!reader.Get(state))
+                return fail("life state");
+        }
+
+        if (flags & kLeveledActor)
+            return fail("leveled actor");
+
+        if (flags & kDispositionModifiers)
+            return fail("disposition modifiers");
+
+        auto speed_hand = [](uint8_t av) -> std::optional<size_t> {
+            if (av == k_weaponSpeedMult)
+                return 0;
+
+            if (av == k_leftWeaponSpeedMultiply)
+                return 1;
+
+            return std::nullopt;
+        };
+
+        bool any_modifiers = false;
+
+        for (auto [flag, name] : k_modifiers)
+            any_modifiers |= (flags & flag) != 0;
+
+        //The base values only come along with at least one modifier map.
+        if (any_modifiers)
+        {
+            bool read = ReadValues(reader, [&](uint8_t av, float value) {
+                if (auto hand = speed_hand(av))
+                    out.speed[*hand].base = value;
+            });
+
+            if (!read)
+                return fail("base values");
+
+            for (size_t i = 0; i < k_modifiers.size(); i++)
+            {
+                if (!(flags & k_modifiers[i].first))
+                    continue;
+
+                read = ReadValues(reader, [&](uint8_t av, float value) {
+                    if (auto hand = speed_hand(av))
+                        out.speed[*hand].modifiers[i] = value;
+                });
+
+                if (!read)
+                    return fail(k_modifiers[i].second);
+            }
+        }
+
+        uint32_t count;
+
+        if (!reader.VSVal(count) || count > reader.remaining())
+            return fail("active effects");
+
+        out.effects.resize(count);
+
+        for (auto& effect : out.effects)
+        {
+            if (!ReadEffect(reader, effect))
+                return fail("active effects");
+        }
+
+        if (reader.remaining())
+            return fail("past the end");
+
+        return true;
+    }
+}
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+//Decodes an LZ4 block a piece at a time instead of all at once. The whole save body is one block, several hundred MB for a
+// big save, but a match can only ever reach back 64KB, so that plus what's being handed out is all that needs to be kept.
+// The state machine stops anywhere, mid literal run or mid match, and carries on from there next time.
+
+class Lz4Stream
+{
+public:
+    static constexpr size_t k_window = 0x10000;
+    static constexpr size_t k_chunk = 0x40000;
+
+    Lz4Stream(const uint8_t* data, size_t size) : _in{ data }, _end{ data + size }
+    {
+        _buffer.resize(k_window + k_chunk);
+    }
+
+    //Returns how many bytes were read, fewer than asked only at the end.
+    size_t Read(uint8_t* out, size_t count)
+    {
+        size_t done = 0;
+
+        while (done < count)
+        {
+            if (_read == _write && !Fill())
+                break;
+
+            size_t take = std::min(count - done, _write - _read);
+
+            if (out)
+                std::memcpy(out + done, _buffer.data() + _read, take);
+
+            _read += take;
+            done += take;
+        }
+
+        _total += done;
+        return done;
+    }
+
+    size_t Skip(size_t count) { return Read(nullptr, count); }
+
+    //Decompressed bytes handed out so far.
+    uint64_t position() const { return _total; }
+
+private:
+    enum struct State
+    {
+        Token,
+        Literals,
+        Match,
+        Done,
+    };
+
+    size_t ReadLength(size_t length)
+    {
+        if (length != 15)
+            return length;
+
+        uint8_t extra;
+
+        do
+        {
+            if (_in == _end)
+                throw std::runtime_error("LZ4 stream ends inside a length");
+
+            extra = *_in++;
+            length += extra;
+        } while (extra == 255);
+
+        return length;
+    }
+
+    //Only called once everything decoded so far has been read.
+    bool Fill()
+    {
+        if (_state == State::Done)
+            return false;
+
+        //Keep the last window for matches, everything before it is gone.
+        if (_write > k_window)
+        {
+            std::memmove(_buffer.data(), _buffer.data() + _write - k_window, k_window);
+            _write = k_window;
+        }
+
+        _read = _write;
+
+        const size_t limit = _buffer.size();
+
+        while (_write < limit)
+        {
+            switch (_state)
+            {
+            case State::Token:
+                if (_in == _end) {
+                    _state = State::Done;
+                    return _write > _read;
+                }
+
+                _token = *_in++;
+                _left = ReadLength(_token >> 4);
+                _state = State::Literals;
+                break;
+
+            case State::Literals:
+            {
+                size_t take = std::min({ _left, limit - _write, static_cast<size_t>(_end - _in) });
+
+                std::memcpy(_buffer.data() + _write, _in, take);
+                _in += take;
+                _write += take;
+                _left -= take;
+
+                if (_left)
+                {
+                    if (_in == _end)
+                        throw std::runtime_error("LZ4 stream ends inside a literal run");
+
+                    break;
+                }
+
+                //The last sequence is literals only.
+                if (_in == _end) {
+                    _state = State::Done;
+                    return _write > _read;
+                }
+
+                if (_end - _in < 2)
+                    throw std::runtime_error("LZ4 stream ends inside an offset");
+
+                _offset = _in[0] | (_in[1] << 8);
+                _in += 2;
+
+                //Everything in front of the write position is real output, the slide only ever keeps a full window.
+                if (!_offset || _offset > _write)
+                    throw std::runtime_error("LZ4 match reaches before the start of the data");
+
+                _left = ReadLength(_token & 15) + 4;
+                _state = State::Match;
+                break;
+            }
+
+            case State::Match:
+            {
+                size_t take = std::min(_left, limit - _write);
+
+                uint8_t* dst = _buffer.data() + _write;
+                const uint8_t* src = dst - _offset;
+
+                if (_offset >= take) {
+                    std::memcpy(dst, src, take);
+                }
+                else {
+                    //Overlapping, repeats the last _offset bytes.
+                    for (size_t i = 0; i < take; i++)
+                        dst[i] = src[i];
+                }
+
+                _write += take;
+                _left -= take;
+
+                if (!_left)
+                    _state = State::Token;
+
+                break;
+            }
+
+            case State::Done:
+                return _write > _read;
+            }
+        }
+
+        return true;
+    }
+
+    const uint8_t* _in;
+    const uint8_t* _end;
+
+    std::vector<uint8_t> _buffer;
+    size_t _read = 0;
+    size_t _write = 0;
+
+    State _state = State::Token;
+    uint8_t _token = 0;
+    size_t _left = 0;
+    size_t _offset = 0;
+
+    uint64_t _total = 0;
+};
@@ -0,0 +1,245 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#ifdef CARP_SAVE_ANALYZER_ZLIB
+#include <zlib.h>
+#endif
+
+//Reads the magic effects (MGEF) out of the save's plugins, for what an active effect in the save doesn't carry itself:
+// which kind of effect it is, whether it's detrimental, and what a dual value modifier's second value is. Only the MGEF
+// top group of each plugin is read, the rest is stepped over a group at a time.
+
+namespace Plugins
+{
+    //The MGEF DATA fields that matter here.
+    struct MagicEffect
+    {
+        uint32_t flags = 0;
+        uint32_t archetype = 0;
+        int32_t primaryAV = -1;
+        int32_t secondaryAV = -1;
+        float secondaryWeight = 0.f;
+    };
+
+    //EffectSetting::EffectSettingData::Flag.
+    constexpr uint32_t k_detrimental = 1 << 2;
+
+    //EffectArchetype, the ones CARP hooks.
+    enum Archetype : uint32_t
+    {
+        kValueModifier = 0,
+        kDualValueModifier = 5,
+        kAccumulateMagnitude = 32,
+        kPeakValueModifier = 34,
+        kEnhanceWeapon = 39,
+    };
+
+
+    //Where a plugin sits in the save's load order, so its own form ids can be turned into the save's.
+    struct LoadOrder
+    {
+        std::vector<std::string> plugins;
+        std::vector<std::string> lightPlugins;
+
+        std::optional<uint32_t> Prefix(std::string_view name) const
+        {
+            for (size_t i = 0; i < plugins.size(); i++) {
+                if (Same(plugins[i], name))
+                    return static_cast<uint32_t>(i) << 24;
+            }
+
+            for (size_t i = 0; i < lightPlugins.size(); i++) {
+                if (Same(lightPlugins[i], name))
+                    return 0xFE000000 | static_cast<uint32_t>(i) << 12;
+            }
+
+            return std::nullopt;
+        }
+
+        static uint32_t Local(uint32_t prefix, uint32_t id)
+        {
+            return prefix | (id & ((prefix >> 24) == 0xFE ? 0xFFF : 0xFFFFFF));
+        }
+
+        //Plugin names don't care about case.
+        static bool Same(std::string_view a, std::string_view b)
+        {
+            if (a.size() != b.size())
+                return false;
+
+            for (size_t i = 0; i < a.size(); i++) {
+                if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i])))
+                    return false;
+            }
+
+            return true;
+        }
+    };
+
+
+    class Records
+    {
+    public:
+        static constexpr size_t k_header = 24;
+        static constexpr uint32_t k_compressed = 0x00040000;
+
+        //data is the whole plugin, name what it's called in the load order. MGEFs from later plugins win, the same as in game.
+        //Returns false for anything that doesn't read as a plugin.
+        bool Read(const uint8_t* data, size_t size, std::string_view name, const LoadOrder& order)
+        {
+            auto self = order.Prefix(name);
+
+            if (!self || size < k_header || std::memcmp(data, "TES4", 4) != 0)
+                return false;
+
+            uint32_t header_size = Get<uint32_t>(data + 4);
+
+            if (k_header + header_size > size)
+                return false;
+
+            //Form ids in a plugin go by its masters, then itself.
+            std::vector<std::optional<uint32_t>> prefixes;
+
+            ForEachField(data + k_header, header_size, [&](std::string_view type, const uint8_t* field, size_t length) {
+                if (type == "MAST")
+                    prefixes.push_back(order.Prefix(std::string_view{ reinterpret_cast<const char*>(field), strnlen(reinterpret_cast<const char*>(field), length) }));
+            });
+
+            prefixes.push_back(self);
+
+            for (size_t at = k_header + header_size; at + k_header <= size;)
+            {
+                uint32_t group_size = Get<uint32_t>(data + at + 4);
+
+                if (std::memcmp(data + at, "GRUP", 4) != 0 || group_size < k_header || at + group_size > size)
+                    return false;
+
+                if (std::memcmp(data + at + 8, "MGEF", 4) == 0)
+                    ReadGroup(data + at + k_header, group_size - k_header, prefixes);
+
+                at += group_size;
+            }
+
+            return true;
+        }
+
+        const MagicEffect* Find(uint32_t form_id) const
+        {
+            auto it = _effects.find(form_id);
+            return it != _effects.end() ? &it->second : nullptr;
+        }
+
+        size_t size() const { return _effects.size(); }
+
+    private:
+        template <class T>
+        static T Get(const uint8_t* at)
+        {
+            T value;
+            std::memcpy(&value, at, sizeof(T));
+            return value;
+        }
+
+        template <class F>
+        static void ForEachField(const uint8_t* data, size_t size, F&& callback)
+        {
+            uint32_t large = 0;
+
+            for (size_t at = 0; at + 6 <= size;)
+            {
+                std::string_view type{ reinterpret_cast<const char*>(data + at), 4 };
+                size_t length = large ? large : Get<uint16_t>(data + at + 4);
+
+                at += 6;
+                large = 0;
+
+                if (at + length > size)
+                    return;
+
+                //The size of the next field, for one too big for 16 bits.
+                if (type == "XXXX" && length == 4)
+                    large = Get<uint32_t>(data + at);
+                else
+                    callback(type, data + at, length);
+
+                at += length;
+            }
+        }
+
+        void ReadGroup(const uint8_t* data, size_t size, const std::vector<std::optional<uint32_t>>& prefixes)
+        {
+            std::vector<uint8_t> inflated;
+
+            for (size_t at = 0; at + k_header <= size;)
+            {
+                uint32_t length = Get<uint32_t>(data + at + 4);
+
+                if (std::memcmp(data + at, "GRUP", 4) == 0) {
+                    at += std::max<size_t>(length, k_header);
+                    continue;
+                }
+
+                if (at + k_header + length > size)
+                    return;
+
+                uint32_t flags = Get<uint32_t>(data + at + 8);
+                uint32_t id = Get<uint32_t>(data + at + 12);
+                const uint8_t* fields = data + at + k_header;
+                size_t fields_size = length;
+
+                at += k_header + length;
+
+                if (flags & k_compressed)
+                {
+#ifdef CARP_SAVE_ANALYZER_ZLIB
+                    if (fields_size < 4)
+                        continue;
+
+                    inflated.resize(Get<uint32_t>(fields));
+                    uLongf inflated_size = inflated.size();
+
+                    if (uncompress(inflated.data(), &inflated_size, fields + 4, fields_size - 4) != Z_OK)
+                        continue;
+
+                    fields = inflated.data();
+                    fields_size = inflated_size;
+#else
+                    continue;
+#endif
+                }
+
+                size_t master = id >> 24;
+
+                if (master >= prefixes.size() || !prefixes[master])
+                    continue;
+
+                ForEachField(fields, fields_size, [&](std::string_view type, const uint8_t* field, size_t field_size) {
+                    constexpr size_t k_dataSize = 152;
+
+                    if (type != "DATA" || field_size < k_dataSize)
+                        return;
+
+                    _effects[LoadOrder::Local(*prefixes[master], id)] =
+                    {
+                        .flags = Get<uint32_t>(field),
+                        .archetype = Get<uint32_t>(field + 64),
+                        .primaryAV = Get<int32_t>(field + 68),
+                        .secondaryAV = Get<int32_t>(field + 88),
+                        .secondaryWeight = Get<float>(field + 60),
+                    };
+                });
+            }
+        }
+
+        std::unordered_map<uint32_t, MagicEffect> _effects;
+    };
+}
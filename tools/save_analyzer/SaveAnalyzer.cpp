@@ -0,0 +1,877 @@
+//Reads a Skyrim SE/AE save (.ess) and says what it holds, without loading the whole thing. The file is mapped rather than
+// read, and the compressed body is decoded a window at a time (see Lz4Stream.h), so memory stays the same for any size of
+// save. Meant for looking into stuck attack speed reports, where the first question is what's actually in the save for
+// the actor.
+//
+//  save_analyzer <save.ess> [--plugins] [--actors] [--data <Data folder>] [--dump <formid>]
+//
+// --actors lists every actor change form (ACHR) with its change flags and size, and for the ones that decode (see
+// ActorData.h), the base and modifiers of WeaponSpeedMult and LeftWeaponSpeedMultiply and the value modifier effects on
+// those. --data points at the game's Data folder, where the save's plugins get read for what the effects are (see
+// Plugins.h). With that each actor also gets the tags ValueEffect_FinishLoadGameHook would give it on load, worked out by
+// the plugin's own EffectHooks::Load and then checked by EffectHooks::Recompute, the same as the tag auditor.
+//
+// --dump prints the data of one actor's change form as hex, inflated when built with zlib, for the ones that don't decode.
+
+#include "ActorData.h"
+#include "Lz4Stream.h"
+#include "Plugins.h"
+
+#include "EffectHooks.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef CARP_SAVE_ANALYZER_ZLIB
+#include <zlib.h>
+#endif
+
+
+namespace
+{
+    class MappedFile
+    {
+    public:
+        explicit MappedFile(const char* path)
+        {
+            int fd = open(path, O_RDONLY);
+
+            if (fd < 0)
+                throw std::runtime_error(std::string{ "Can't open " } + path + ": " + std::strerror(errno));
+
+            struct stat info;
+
+            if (fstat(fd, &info) != 0 || info.st_size == 0) {
+                close(fd);
+                throw std::runtime_error(std::string{ "Can't read " } + path);
+            }
+
+            _size = static_cast<size_t>(info.st_size);
+            _data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+            close(fd);
+
+            if (_data == MAP_FAILED)
+                throw std::runtime_error(std::string{ "Can't map " } + path + ": " + std::strerror(errno));
+
+            //Read front to back once.
+            madvise(_data, _size, MADV_SEQUENTIAL);
+        }
+
+        ~MappedFile() { munmap(_data, _size); }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        const uint8_t* data() const { return static_cast<const uint8_t*>(_data); }
+        size_t size() const { return _size; }
+
+    private:
+        void* _data = nullptr;
+        size_t _size = 0;
+    };
+
+
+    //Where bytes come from, the mapped file itself or the decoder in front of it.
+    class Source
+    {
+    public:
+        virtual ~Source() = default;
+
+        virtual size_t Read(uint8_t* out, size_t count) = 0;
+
+        void Need(uint8_t* out, size_t count)
+        {
+            if (Read(out, count) != count)
+                throw std::runtime_error("Save ends early");
+        }
+
+        void Skip(size_t count) { Need(nullptr, count); }
+
+        template <class T>
+        T Get()
+        {
+            T value;
+            Need(reinterpret_cast<uint8_t*>(&value), sizeof(T));
+            return value;
+        }
+
+        std::string String()
+        {
+            std::string result(Get<uint16_t>(), '\0');
+            Need(reinterpret_cast<uint8_t*>(result.data()), result.size());
+            return result;
+        }
+
+        //Tries a read without throwing, for the spots where running out is how a list ends.
+        bool TryGet(uint32_t& value)
+        {
+            return Read(reinterpret_cast<uint8_t*>(&value), sizeof(value)) == sizeof(value);
+        }
+
+        virtual uint64_t position() const = 0;
+    };
+
+    class PlainSource : public Source
+    {
+    public:
+        PlainSource(const uint8_t* data, size_t size) : _data{ data }, _size{ size } {}
+
+        size_t Read(uint8_t* out, size_t count) override
+        {
+            count = std::min(count, _size - _position);
+
+            if (out)
+                std::memcpy(out, _data + _position, count);
+
+            _position += count;
+            return count;
+        }
+
+        uint64_t position() const override { return _position; }
+
+    private:
+        const uint8_t* _data;
+        size_t _size;
+        size_t _position = 0;
+    };
+
+    class Lz4Source : public Source
+    {
+    public:
+        Lz4Source(const uint8_t* data, size_t size) : _stream{ data, size } {}
+
+        size_t Read(uint8_t* out, size_t count) override { return _stream.Read(out, count); }
+
+        uint64_t position() const override { return _stream.position(); }
+
+    private:
+        Lz4Stream _stream;
+    };
+
+
+    //Change form types by the low 6 bits, as listed on UESP for Skyrim.
+    constexpr std::array<std::string_view, 49> k_typeNames
+    {
+        "REFR", "ACHR", "PMIS", "PGRE", "PBEA", "PFLA", "CELL", "INFO", "QUST", "NPC_", "ACTI", "TACT", "ARMO", "BOOK",
+        "CONT", "DOOR", "INGR", "LIGH", "MISC", "APPA", "STAT", "MSTT", "FURN", "WEAP", "AMMO", "KEYM", "ALCH", "IDLM",
+        "NOTE", "ECZN", "CLAS", "FACT", "PACK", "NAVM", "WOOP", "MGEF", "SMQN", "SCEN", "LCTN", "RELA", "PHZD", "PBAR",
+        "PCON", "FLST", "LVLN", "LVLI", "LVSP", "PARW", "ENTM",
+    };
+
+    constexpr uint8_t k_actorType = 1;
+
+
+    struct ActorForm
+    {
+        uint32_t ref;
+        uint32_t flags;
+        uint8_t version;
+        uint32_t length;
+        uint32_t inflated;
+
+        std::optional<ActorData::Decoded> decoded = std::nullopt;
+        ActorData::Failure failure = {};
+    };
+
+    struct TypeStats
+    {
+        uint64_t count = 0;
+        uint64_t bytes = 0;
+    };
+
+
+    struct Options
+    {
+        const char* path = nullptr;
+        bool plugins = false;
+        bool actors = false;
+        const char* data = nullptr;
+        std::optional<uint32_t> dump;
+    };
+
+
+    struct Header
+    {
+        uint32_t version;
+        std::string player;
+        uint32_t level;
+        std::string location;
+        std::string date;
+        uint16_t compression;
+        size_t bodyStart;
+        uint32_t uncompressed = 0;
+        uint32_t compressed = 0;
+    };
+
+    Header ReadHeader(const MappedFile& file)
+    {
+        constexpr std::string_view k_magic = "TESV_SAVEGAME";
+
+        if (file.size() < k_magic.size() || std::memcmp(file.data(), k_magic.data(), k_magic.size()) != 0)
+            throw std::runtime_error("Not a Skyrim save");
+
+        PlainSource source{ file.data(), file.size() };
+        source.Skip(k_magic.size());
+
+        auto header_size = source.Get<uint32_t>();
+        auto header_start = source.position();
+
+        Header header;
+        header.version = source.Get<uint32_t>();
+
+        if (header.version < 12)
+            throw std::runtime_error("Only SE/AE saves (version 12 and up) are read, this is version " + std::to_string(header.version));
+
+        source.Get<uint32_t>();//Save number
+        header.player = source.String();
+        header.level = source.Get<uint32_t>();
+        header.location = source.String();
+        header.date = source.String();
+        source.String();//Race
+        source.Get<uint16_t>();//Sex
+        source.Get<float>();//Experience
+        source.Get<float>();//Level up experience
+        source.Get<uint64_t>();//File time
+
+        auto width = source.Get<uint32_t>();
+        auto height = source.Get<uint32_t>();
+        header.compression = source.Get<uint16_t>();
+
+        if (source.position() != header_start + header_size)
+            throw std::runtime_error("Header size doesn't match what was read, unknown save layout");
+
+        //RGBA screenshot.
+        source.Skip(static_cast<size_t>(width) * height * 4);
+
+        if (header.compression != 0) {
+            header.uncompressed = source.Get<uint32_t>();
+            header.compressed = source.Get<uint32_t>();
+        }
+
+        header.bodyStart = source.position();
+        return header;
+    }
+
+
+    void SkipGlobalTable(Source& body, uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            body.Get<uint32_t>();//Type
+            body.Skip(body.Get<uint32_t>());
+        }
+    }
+
+
+    //The three byte reference a change form is keyed by. The top two bits say what the rest is.
+    uint32_t Resolve(uint32_t ref, const std::vector<uint32_t>& form_ids)
+    {
+        uint32_t value = ref & 0x3FFFFF;
+
+        switch (ref >> 22)
+        {
+        case 0:
+            return value < form_ids.size() ? form_ids[value] : 0;
+        case 1:
+            return value;
+        case 2:
+            return 0xFF000000 | value;
+        default:
+            return 0;
+        }
+    }
+
+
+    void Dump(const uint8_t* data, size_t size)
+    {
+        for (size_t i = 0; i < size; i += 16)
+        {
+            std::printf("    %08zX ", i);
+
+            for (size_t j = i; j < i + 16; j++) {
+                if (j < size)
+                    std::printf(" %02X", data[j]);
+                else
+                    std::printf("   ");
+            }
+
+            std::printf("  ");
+
+            for (size_t j = i; j < i + 16 && j < size; j++)
+                std::printf("%c", data[j] >= 0x20 && data[j] < 0x7F ? data[j] : '.');
+
+            std::printf("\n");
+        }
+    }
+
+
+    //Inflates a change form stored with zlib, size being what it inflates to. False if it can't be.
+    bool Inflate(std::vector<uint8_t>& data, uint32_t size)
+    {
+#ifdef CARP_SAVE_ANALYZER_ZLIB
+        std::vector<uint8_t> inflated(size);
+        uLongf inflated_size = size;
+
+        if (uncompress(inflated.data(), &inflated_size, data.data(), data.size()) != Z_OK)
+            return false;
+
+        inflated.resize(inflated_size);
+        data = std::move(inflated);
+        return true;
+#else
+        (void)data;
+        (void)size;
+        return false;
+#endif
+    }
+
+
+    struct Result
+    {
+        Plugins::LoadOrder order;
+        std::vector<ActorForm> actors;
+        std::vector<uint32_t> formIds;
+        std::array<TypeStats, 64> types{};
+        uint32_t changeForms = 0;
+        uint64_t bodySize = 0;
+    };
+
+    //One pass over the body. dump_ref, when set, is the raw reference of the change form to print.
+    Result Scan(const MappedFile& file, const Header& header, const Options& options, std::optional<uint32_t> dump_ref)
+    {
+        std::unique_ptr<Source> body;
+
+        const uint8_t* start = file.data() + header.bodyStart;
+        size_t remaining = file.size() - header.bodyStart;
+
+        switch (header.compression)
+        {
+        case 0:
+            body = std::make_unique<PlainSource>(start, remaining);
+            break;
+
+        case 2:
+            body = std::make_unique<Lz4Source>(start, std::min<size_t>(header.compressed, remaining));
+            break;
+
+        default:
+            throw std::runtime_error("Compression type " + std::to_string(header.compression) + " isn't supported, only none and LZ4");
+        }
+
+        Result result;
+
+        auto form_version = body->Get<uint8_t>();
+        body->Get<uint32_t>();//Plugin info size
+
+        auto& plugins = result.order.plugins;
+        auto& light_plugins = result.order.lightPlugins;
+
+        plugins.resize(body->Get<uint8_t>());
+
+        for (auto& plugin : plugins)
+            plugin = body->String();
+
+        if (form_version >= 78) {
+            light_plugins.resize(body->Get<uint16_t>());
+
+            for (auto& plugin : light_plugins)
+                plugin = body->String();
+        }
+
+        //File location table, only the counts are any use when streaming.
+        std::array<uint32_t, 10> locations;
+        body->Need(reinterpret_cast<uint8_t*>(locations.data()), sizeof(locations));
+        body->Skip(15 * sizeof(uint32_t));
+
+        uint32_t table1_count = locations[6];
+        uint32_t table2_count = locations[7];
+        uint32_t table3_count = locations[8];
+        result.changeForms = locations[9];
+
+        if (!dump_ref)
+        {
+            std::printf("Form version %u, %zu plugins, %zu light plugins\n", form_version, plugins.size(), light_plugins.size());
+
+            if (options.plugins)
+            {
+                for (size_t i = 0; i < plugins.size(); i++)
+                    std::printf("    %02zX %s\n", i, plugins[i].c_str());
+
+                for (size_t i = 0; i < light_plugins.size(); i++)
+                    std::printf("    FE%03zX %s\n", i, light_plugins[i].c_str());
+            }
+        }
+
+        SkipGlobalTable(*body, table1_count);
+        SkipGlobalTable(*body, table2_count);
+
+        std::vector<uint8_t> data;
+
+        for (uint32_t i = 0; i < result.changeForms; i++)
+        {
+            std::array<uint8_t, 3> ref_bytes;
+            body->Need(ref_bytes.data(), ref_bytes.size());
+
+            uint32_t ref = ref_bytes[0] << 16 | ref_bytes[1] << 8 | ref_bytes[2];
+
+            auto flags = body->Get<uint32_t>();
+            auto type = body->Get<uint8_t>();
+            auto version = body->Get<uint8_t>();
+
+            uint32_t length1 = 0;
+            uint32_t length2 = 0;
+
+            switch (type >> 6)
+            {
+            case 0:
+                length1 = body->Get<uint8_t>();
+                length2 = body->Get<uint8_t>();
+                break;
+            case 1:
+                length1 = body->Get<uint16_t>();
+                length2 = body->Get<uint16_t>();
+                break;
+            case 2:
+                length1 = body->Get<uint32_t>();
+                length2 = body->Get<uint32_t>();
+                break;
+            default:
+                throw std::runtime_error("Change form " + std::to_string(i) + " has an unknown length size");
+            }
+
+            type &= 0x3F;
+
+            result.types[type].count++;
+            result.types[type].bytes += length1;
+
+            if (type == k_actorType && !dump_ref)
+            {
+                auto& actor = result.actors.emplace_back(ActorForm{ ref, flags, version, length1, length2 });
+
+                data.resize(length1);
+                body->Need(data.data(), length1);
+
+                ActorData::Decoded decoded;
+
+                if (length2 && !Inflate(data, length2))
+                    actor.failure = { "zlib", 0 };
+                else if (ActorData::Decode(data.data(), data.size(), ref, flags, decoded, actor.failure))
+                    actor.decoded = std::move(decoded);
+
+                continue;
+            }
+
+            if (dump_ref && type == k_actorType && ref == *dump_ref)
+            {
+                data.resize(length1);
+                body->Need(data.data(), length1);
+
+                std::printf("ACHR change form, flags %08X, version %u, %u bytes%s\n",
+                    flags, version, length1, length2 ? " zlib compressed" : "");
+
+                if (length2)
+                {
+                    if (Inflate(data, length2))
+                        std::printf("Inflated to %zu bytes\n", data.size());
+                    else
+                        std::printf("Couldn't inflate, showing it as stored\n");
+                }
+
+                Dump(data.data(), data.size());
+                continue;
+            }
+
+            body->Skip(length1);
+        }
+
+        //Table three is sometimes one longer than its count says, the extra entry's type is told apart from the form id
+        // count that comes next by being in the range the table uses.
+        SkipGlobalTable(*body, table3_count);
+
+        uint32_t value = 0;
+
+        if (body->TryGet(value) && value >= 1000 && value < 1100) {
+            body->Skip(body->Get<uint32_t>());
+            body->TryGet(value);
+        }
+
+        result.formIds.resize(value);
+        body->Need(reinterpret_cast<uint8_t*>(result.formIds.data()), result.formIds.size() * sizeof(uint32_t));
+
+        result.bodySize = body->position();
+
+        return result;
+    }
+
+
+    //The save's plugins that are in the Data folder, for what their magic effects are.
+    Plugins::Records LoadPlugins(const std::string& folder, const Plugins::LoadOrder& order)
+    {
+        Plugins::Records records;
+        size_t missing = 0;
+
+        auto load = [&](const std::string& name) {
+            try
+            {
+                MappedFile plugin{ (folder + "/" + name).c_str() };
+
+                if (!records.Read(plugin.data(), plugin.size(), name, order))
+                    std::printf("    %s doesn't read as a plugin\n", name.c_str());
+            }
+            catch (std::exception&)
+            {
+                missing++;
+            }
+        };
+
+        for (auto& name : order.plugins)
+            load(name);
+
+        for (auto& name : order.lightPlugins)
+            load(name);
+
+        std::printf("%zu magic effects from the plugins, %zu plugins not found\n", records.size(), missing);
+
+        return records;
+    }
+
+
+    //What EffectHooks.h gets a saved actor through, so the load and the audit the plugin does are what run here. The tags
+    // start at 0, the same as on a load, and nothing outside the effects moves them.
+    struct SaveGame
+    {
+        struct Actor;
+
+        struct Effect
+        {
+            const ActorData::Effect* saved;
+            const Plugins::MagicEffect* base;
+            Actor* target;
+            int type;
+            uint16_t mark = 0;
+        };
+
+        struct Actor
+        {
+            std::array<float, 2> tags{};
+            std::vector<Effect> effects;
+        };
+
+        static std::optional<bool> HandOf(int32_t av)
+        {
+            if (av == ActorData::k_weaponSpeedMult)
+                return true;
+
+            if (av == ActorData::k_leftWeaponSpeedMultiply)
+                return false;
+
+            return std::nullopt;
+        }
+
+        //Which ModifierEffect the archetype makes, the same order as EffectHooks::Type.
+        static std::optional<int> TypeOf(uint32_t archetype)
+        {
+            switch (archetype)
+            {
+            case Plugins::kValueModifier:
+                return EffectHooks::kValueMod;
+            case Plugins::kDualValueModifier:
+                return EffectHooks::kDualMod;
+            case Plugins::kAccumulateMagnitude:
+                return EffectHooks::kAccumMod;
+            case Plugins::kPeakValueModifier:
+                return EffectHooks::kPeakMod;
+            case Plugins::kEnhanceWeapon:
+                return EffectHooks::kEnhance;
+            default:
+                return std::nullopt;
+            }
+        }
+
+        static Actor* Target(Effect* effect) { return effect->target; }
+
+        static std::optional<bool> Hand(Effect* effect)
+        {
+            return effect->saved->actorValue ? HandOf(*effect->saved->actorValue) : std::nullopt;
+        }
+
+        static std::optional<bool> SecondaryHand(Effect* effect) { return HandOf(effect->base->secondaryAV); }
+        static float DualWeight(Effect* effect) { return effect->base->secondaryWeight; }
+        static bool Recovers(Effect* effect) { return effect->saved->flags & ActorData::kRecovers; }
+        static bool Detrimental(Effect* effect) { return effect->base->flags & Plugins::k_detrimental; }
+        static bool Dispelled(Effect* effect) { return effect->saved->flags & ActorData::kDispelled; }
+
+        //The plugin goes by the effect item's magnitude, the active effect's own is what the save has. They only differ
+        // for magnitudes something scaled after the effect was cast.
+        static float Magnitude(Effect* effect) { return effect->saved->magnitude; }
+
+        static float Value(Effect* effect) { return effect->saved->value; }
+        static bool Applied(Effect* effect) { return effect->saved->flags & ActorData::kApplied; }
+
+        static bool ConditionsHold(Effect* effect)
+        {
+            return effect->saved->conditionStatus == ActorData::k_conditionsTrue || !(effect->saved->flags & ActorData::kHasConditions);
+        }
+
+        static uint16_t& Mark(Effect* effect) { return effect->mark; }
+        static float& Tag(Actor* actor, bool right) { return actor->tags[!right]; }
+        static void Sync(Actor*) {}
+
+        static bool SpeedRelevant(Effect* effect)
+        {
+            return Hand(effect) || (effect->type == EffectHooks::kDualMod && SecondaryHand(effect));
+        }
+
+        static void BeforeSpeedChange(Actor*) {}
+
+        template <class F>
+        static bool ForEachValueEffect(Actor* actor, F&& callback)
+        {
+            for (auto& effect : actor->effects)
+                callback(&effect, effect.type);
+
+            return true;
+        }
+    };
+
+    //The speed relevant value effects on the actor, with the tags the load would build from them. Effects whose magic
+    // effect isn't in the plugins read are left out, and counted in unknown.
+    SaveGame::Actor Predict(const ActorData::Decoded& decoded, const Plugins::Records& records, const std::vector<uint32_t>& form_ids, size_t& unknown)
+    {
+        SaveGame::Actor actor;
+
+        unknown = 0;
+
+        for (auto& saved : decoded.effects)
+        {
+            auto base = records.Find(Resolve(saved.baseEffect, form_ids));
+
+            if (!base) {
+                unknown++;
+                continue;
+            }
+
+            auto type = SaveGame::TypeOf(base->archetype);
+
+            if (!type)
+                continue;
+
+            SaveGame::Effect effect{ &saved, base, nullptr, *type };
+
+            if (SaveGame::SpeedRelevant(&effect))
+                actor.effects.push_back(effect);
+        }
+
+        //Pointers only once the list is done growing.
+        for (auto& effect : actor.effects)
+        {
+            effect.target = &actor;
+            EffectHooks::Load<SaveGame>(&effect, effect.type);
+        }
+
+        return actor;
+    }
+
+
+    void PrintSpeed(const ActorData::Decoded& decoded)
+    {
+        constexpr const char* k_hands[]{ "WeaponSpeedMult", "LeftWeaponSpeedMultiply" };
+
+        for (size_t hand = 0; hand < 2; hand++)
+        {
+            auto& value = decoded.speed[hand];
+
+            std::printf("        %s: base ", k_hands[hand]);
+
+            if (value.base)
+                std::printf("%g", *value.base);
+            else
+                std::printf("from the record");
+
+            for (size_t i = 0; i < value.modifiers.size(); i++) {
+                if (value.modifiers[i])
+                    std::printf(", %s %g", ActorData::k_modifiers[i].second, *value.modifiers[i]);
+            }
+
+            std::printf("\n");
+        }
+    }
+
+    void PrintEffects(const SaveGame::Actor& actor, const std::vector<uint32_t>& form_ids)
+    {
+        constexpr const char* k_types[]{ "value", "dual value", "accumulating", "peak value", "enhance weapon" };
+
+        for (auto& effect : actor.effects)
+        {
+            auto hand = SaveGame::Hand(const_cast<SaveGame::Effect*>(&effect));
+
+            std::printf("        MGEF %08X from %08X, %s modifier on %s, value %g, magnitude %g%s%s%s%s -> %s\n",
+                Resolve(effect.saved->baseEffect, form_ids), Resolve(effect.saved->spell, form_ids), k_types[effect.type],
+                hand ? (*hand ? "right" : "left") : "neither",
+                effect.saved->value, effect.saved->magnitude,
+                effect.saved->flags & ActorData::kRecovers ? ", recovers" : "",
+                effect.base->flags & Plugins::k_detrimental ? ", detrimental" : "",
+                effect.saved->flags & ActorData::kApplied ? "" : ", not applied",
+                effect.saved->flags & ActorData::kDispelled ? ", dispelled" : "",
+                effect.mark == TagAudit::kCounted ? "counted" : "not counted");
+        }
+    }
+
+
+    Options ParseOptions(int argc, char** argv)
+    {
+        Options options;
+
+        for (int i = 1; i < argc; i++)
+        {
+            std::string_view arg = argv[i];
+
+            if (arg == "--plugins")
+                options.plugins = true;
+            else if (arg == "--actors")
+                options.actors = true;
+            else if (arg == "--data" && i + 1 < argc)
+                options.data = argv[++i];
+            else if (arg == "--dump" && i + 1 < argc)
+                options.dump = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 16));
+            else if (!options.path && !arg.starts_with("--"))
+                options.path = argv[i];
+            else
+                throw std::runtime_error("Unknown argument " + std::string{ arg });
+        }
+
+        if (!options.path)
+            throw std::runtime_error("usage: save_analyzer <save.ess> [--plugins] [--actors] [--data <Data folder>] [--dump <formid>]");
+
+        return options;
+    }
+}
+
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        auto options = ParseOptions(argc, argv);
+
+        auto start = std::chrono::steady_clock::now();
+
+        MappedFile file{ options.path };
+
+        auto header = ReadHeader(file);
+
+        std::printf("%s, level %u, %s, %s\n", header.player.c_str(), header.level, header.location.c_str(), header.date.c_str());
+
+        auto result = Scan(file, header, options, std::nullopt);
+
+        std::printf("Body: %s, %.1f MB\n", header.compression ? "LZ4" : "uncompressed", result.bodySize / 1e6);
+        std::printf("%u change forms, %zu form ids\n", result.changeForms, result.formIds.size());
+
+        for (size_t type = 0; type < result.types.size(); type++)
+        {
+            auto& stats = result.types[type];
+
+            if (!stats.count)
+                continue;
+
+            std::string name = type < k_typeNames.size() ? std::string{ k_typeNames[type] } : "type " + std::to_string(type);
+
+            std::printf("    %-8s %8" PRIu64 " forms %12" PRIu64 " bytes\n", name.c_str(), stats.count, stats.bytes);
+        }
+
+        size_t decoded = std::ranges::count_if(result.actors, [](auto& actor) { return actor.decoded.has_value(); });
+
+        std::printf("%zu of %zu actor change forms decoded\n", decoded, result.actors.size());
+
+        std::optional<Plugins::Records> records;
+
+        if (options.data)
+            records = LoadPlugins(options.data, result.order);
+
+        std::optional<uint32_t> dump_ref;
+
+        if (options.actors)
+            std::printf("Actors:\n");
+
+        for (auto& actor : result.actors)
+        {
+            uint32_t form_id = Resolve(actor.ref, result.formIds);
+
+            if (options.dump && form_id == *options.dump)
+                dump_ref = actor.ref;
+
+            if (!options.actors)
+                continue;
+
+            std::printf("    %08X flags %08X version %u, %u bytes%s\n", form_id, actor.flags, actor.version, actor.length,
+                actor.inflated ? " (zlib)" : "");
+
+            if (!actor.decoded) {
+                std::printf("        not decoded, stopped in %s at byte %zu\n", actor.failure.section.c_str(), actor.failure.offset);
+                continue;
+            }
+
+            PrintSpeed(*actor.decoded);
+
+            if (!records) {
+                std::printf("        %zu active effects, --data to see which touch speed and the tags\n", actor.decoded->effects.size());
+                continue;
+            }
+
+            size_t unknown;
+            auto predicted = Predict(*actor.decoded, *records, result.formIds, unknown);
+
+            PrintEffects(predicted, result.formIds);
+
+            if (unknown)
+                std::printf("        %zu effects from magic effects that weren't in the plugins read, left out\n", unknown);
+
+            auto expected = EffectHooks::Recompute<SaveGame>(&predicted).value_or(std::array<float, 2>{});
+
+            std::printf("        tags on load: right %g, left %g\n", expected[0], expected[1]);
+
+            //Recompute goes by what the load decided, these only part if the two hooks stop agreeing.
+            if (expected != predicted.tags)
+                std::printf("        the load itself builds right %g, left %g\n", predicted.tags[0], predicted.tags[1]);
+        }
+
+        if (options.dump)
+        {
+            if (!dump_ref)
+                std::printf("No actor change form for %08X\n", *options.dump);
+            else
+                //The form id table comes after the change forms, so finding the one to print takes a second pass.
+                Scan(file, header, options, dump_ref);
+        }
+
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::printf("Read %.1f MB in %.2fs\n", file.size() / 1e6, elapsed);
+
+        return 0;
+    }
+    catch (std::exception& error)
+    {
+        std::fprintf(stderr, "%s\n", error.what());
+        return 1;
+    }
+}